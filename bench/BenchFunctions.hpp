@@ -0,0 +1,131 @@
+#ifndef VMC_BENCH_BENCHFUNCTIONS_HPP
+#define VMC_BENCH_BENCHFUNCTIONS_HPP
+
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/Metric.hpp"
+#include "vmc/TwoBodyPseudoPotential.hpp"
+#include "vmc/WaveFunction.hpp"
+
+#include <cmath>
+
+/*
+  Product of gaussians for N particles in D dimensions
+  Psi(x) = exp(-b * sum_i x_i^2)
+*/
+class GaussianNP: public vmc::WaveFunction
+{
+protected:
+    double _b;
+
+    mci::SamplingFunctionInterface * _clone() const final
+    {
+        return new GaussianNP(_nspacedim, _npart, _b, hasVD1());
+    }
+
+public:
+    GaussianNP(const int nspacedim, const int npart, const double b, const bool flag_vd1 = false):
+            vmc::WaveFunction(nspacedim, npart, 1, 1, flag_vd1, false, false), _b(b) {}
+
+    void setVP(const double * in) final { _b = *in; }
+    void getVP(double * out) const final { *out = _b; }
+
+    void protoFunction(const double * in, double * out) final
+    {
+        double r2 = 0.;
+        for (int i = 0; i < getTotalNDim(); ++i) { r2 += in[i]*in[i]; }
+        *out = -2.*_b*r2;
+    }
+
+    double acceptanceFunction(const double * protoold, const double * protonew) const final
+    {
+        return exp(protonew[0] - protoold[0]);
+    }
+
+    void computeAllDerivatives(const double * in) final
+    {
+        double r2 = 0.;
+        for (int i = 0; i < getTotalNDim(); ++i) {
+            _setD1DivByWF(i, -2.*_b*in[i]);
+            _setD2DivByWF(i, -2.*_b + 4.*_b*_b*in[i]*in[i]);
+            r2 += in[i]*in[i];
+        }
+        if (hasVD1()) { _setVD1DivByWF(0, -r2); }
+    }
+
+    double computeWFValue(const double * protovalues) const final
+    {
+        return exp(0.5*protovalues[0]);
+    }
+};
+
+/*
+  Gaussian pseudopotential (optionally with first variational derivative)
+  u(r) = -a * r^2
+*/
+class GaussianU2: public vmc::TwoBodyPseudoPotential
+{
+private:
+    double _a;
+
+    vmc::TwoBodyPseudoPotential * _clone() const final
+    {
+        return new GaussianU2(_metric, _a, _flag_vd1);
+    }
+
+public:
+    GaussianU2(vmc::Metric * metric, const double a, const bool flag_vd1 = false):
+            vmc::TwoBodyPseudoPotential(metric, 1, flag_vd1), _a(a) {}
+
+    void setVP(const double * vp) final { _a = vp[0]; }
+    void getVP(double * vp) const final { vp[0] = _a; }
+
+    double ur(const double r) final { return -_a*r*r; }
+    double urD1(const double r) final { return -2.*_a*r; }
+    double urD2(const double /*r*/) final { return -2.*_a; }
+    void urVD1(const double r, double * vd1) final { vd1[0] = -r*r; }
+    void urD1VD1(const double r, double * d1vd1) final { d1vd1[0] = -2.*r; }
+    void urD2VD1(const double /*r*/, double * d2vd1) final { d2vd1[0] = -2.; }
+
+    // vectorizable batched versions
+    void urBatch(const int n, const double * r, double * out) final
+    {
+        for (int k = 0; k < n; ++k) { out[k] = -_a*r[k]*r[k]; }
+    }
+    void urD1Batch(const int n, const double * r, double * out) final
+    {
+        for (int k = 0; k < n; ++k) { out[k] = -2.*_a*r[k]; }
+    }
+    void urD2Batch(const int n, const double * /*r*/, double * out) final
+    {
+        for (int k = 0; k < n; ++k) { out[k] = -2.*_a; }
+    }
+    void urVD1Batch(const int n, const double * r, double * vd1s) final
+    {
+        for (int k = 0; k < n; ++k) { vd1s[k] = -r[k]*r[k]; }
+    }
+};
+
+// Harmonic oscillator for N particles in D dimensions
+class HarmonicOscillatorNP: public vmc::Hamiltonian
+{
+protected:
+    const double _w;
+
+    mci::ObservableFunctionInterface * _clone() const final
+    {
+        return new HarmonicOscillatorNP(_nspacedim, _npart, _w);
+    }
+
+public:
+    HarmonicOscillatorNP(const int nspacedim, const int npart, const double w):
+            vmc::Hamiltonian(nspacedim, npart), _w(w) {}
+
+    double localPotentialEnergy(const double * r) final
+    {
+        double r2 = 0.;
+        for (int i = 0; i < getTotalNDim(); ++i) { r2 += r[i]*r[i]; }
+        return 0.5*_w*_w*r2;
+    }
+};
+
+#endif
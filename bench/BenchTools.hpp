@@ -0,0 +1,101 @@
+#ifndef VMC_BENCH_BENCHTOOLS_HPP
+#define VMC_BENCH_BENCHTOOLS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace vmc_bench
+{
+
+// One benchmark measurement
+struct BenchResult
+{
+    std::string suite; // e.g. "jastrow"
+    std::string name; // e.g. "computeAllDerivatives"
+    int param; // scaling parameter (e.g. number of particles), or 0
+    int64_t iterations; // total number of timed iterations
+    double ns_per_op; // best (minimum over repeats) time per iteration
+    double ns_per_op_median; // median over repeats
+    double ops_per_s; // throughput, i.e. 1e9/ns_per_op times items per op
+};
+
+// Accumulator preventing the compiler from optimizing away benchmarked computations
+inline double &sink()
+{
+    static double s = 0.;
+    return s;
+}
+
+// Times f() (one op per call) in nrepeat batches of calibrated size, each lasting about mintime/nrepeat
+// seconds. items is the number of items (e.g. samples) processed per op, for ops_per_s.
+template <class F>
+BenchResult runBench(const std::string &suite, const std::string &name, const int param, F &&f,
+                     const double mintime, const double items = 1., const int nrepeat = 5)
+{
+    using clock = std::chrono::steady_clock;
+    const auto timeBatch = [&f](const int64_t n) {
+        const auto t0 = clock::now();
+        for (int64_t i = 0; i < n; ++i) { f(); }
+        return std::chrono::duration<double>(clock::now() - t0).count();
+    };
+
+    // calibrate the batch size (includes warm-up)
+    const double tbatch = mintime/nrepeat;
+    int64_t nbatch = 1;
+    double t = timeBatch(nbatch);
+    while (t < 0.5*tbatch && nbatch < (int64_t(1) << 40)) {
+        nbatch = (t > 0.) ? std::max(2*nbatch, static_cast<int64_t>(nbatch*tbatch/t)) : 2*nbatch;
+        t = timeBatch(nbatch);
+    }
+
+    std::vector<double> times;
+    for (int ir = 0; ir < nrepeat; ++ir) { times.push_back(1e9*timeBatch(nbatch)/nbatch); }
+    std::sort(times.begin(), times.end());
+
+    BenchResult res;
+    res.suite = suite;
+    res.name = name;
+    res.param = param;
+    res.iterations = nbatch*nrepeat;
+    res.ns_per_op = times.front();
+    res.ns_per_op_median = times[times.size()/2];
+    res.ops_per_s = items*1e9/res.ns_per_op;
+    return res;
+}
+
+inline std::string escapeJSON(const std::string &str)
+{
+    std::string out;
+    for (const char c : str) {
+        if (c == '"' || c == '\\') { out += '\\'; }
+        out += c;
+    }
+    return out;
+}
+
+// Write results and build information as JSON
+inline void writeJSON(std::ostream &out, const std::vector<BenchResult> &results, const std::vector<std::pair<std::string, std::string>> &info)
+{
+    out << std::setprecision(6);
+    out << "{\n  \"info\": {";
+    for (size_t i = 0; i < info.size(); ++i) {
+        out << (i > 0 ? ", " : "") << "\"" << escapeJSON(info[i].first) << "\": \"" << escapeJSON(info[i].second) << "\"";
+    }
+    out << "},\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        out << "    {\"suite\": \"" << escapeJSON(r.suite) << "\", \"name\": \"" << escapeJSON(r.name) << "\", \"param\": " << r.param
+            << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.ns_per_op << ", \"ns_per_op_median\": " << r.ns_per_op_median
+            << ", \"ops_per_s\": " << r.ops_per_s << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+} // namespace vmc_bench
+
+#endif
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vmc/EuclideanMetric.hpp"
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/MultiComponentWaveFunction.hpp"
+#include "vmc/StochasticReconfigurationTargetFunction.hpp"
+#include "vmc/SymmetrizerWaveFunction.hpp"
+#include "vmc/TwoBodyJastrow.hpp"
+#include "vmc/VMC.hpp"
+
+#include "BenchFunctions.hpp"
+#include "BenchTools.hpp"
+#include "../test/common/TestVMCFunctions.hpp" // pseudopotentials and 1D functions
+
+using namespace vmc_bench;
+
+// random particle positions in a box of side length L
+std::vector<double> randomPositions(const int ndim, const double L, std::mt19937_64 &rgen)
+{
+    std::uniform_real_distribution<double> rd(0., L);
+    std::vector<double> x(static_cast<size_t>(ndim));
+    for (double &xi : x) { xi = rd(rgen); }
+    return x;
+}
+
+struct BenchConfig
+{
+    double mintime = 0.2; // seconds per kernel benchmark
+    double mintime_e2e = 1.; // seconds per end-to-end benchmark
+    std::vector<std::string> suites; // empty = all
+    std::mt19937_64 rgen{12345};
+
+    bool runSuite(const std::string &suite) const
+    {
+        return suites.empty() || std::find(suites.begin(), suites.end(), suite) != suites.end();
+    }
+};
+
+
+// --- Kernel suites
+
+void benchMetric(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    vmc::EuclideanMetric em(3);
+    const auto x = randomPositions(6, 1., cfg.rgen);
+    double out[6]; // derivatives w.r.t. both positions
+    results.push_back(runBench("metric", "dist", 3, [&]() { sink() += em.dist(x.data(), x.data() + 3); }, cfg.mintime));
+    results.push_back(runBench("metric", "distD1", 3, [&]() {
+        em.distD1(x.data(), x.data() + 3, out);
+        sink() += out[0];
+    }, cfg.mintime));
+    results.push_back(runBench("metric", "distD2", 3, [&]() {
+        em.distD2(x.data(), x.data() + 3, out);
+        sink() += out[0];
+    }, cfg.mintime));
+}
+
+void benchPseudoPotential(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    vmc::EuclideanMetric em(3);
+    PolynomialU2 u2(&em, -0.3, -0.1);
+    He3u2 he3(&em);
+    const auto x = randomPositions(6, 1., cfg.rgen);
+    results.push_back(runBench("pseudopotential", "PolynomialU2::computeAllDerivatives", 3, [&]() {
+        u2.computeAllDerivatives(x.data(), x.data() + 3);
+        sink() += u2.getD1(0);
+    }, cfg.mintime));
+    results.push_back(runBench("pseudopotential", "He3u2::computeAllDerivatives", 3, [&]() {
+        he3.computeAllDerivatives(x.data(), x.data() + 3);
+        sink() += he3.getD1(0);
+    }, cfg.mintime));
+}
+
+void benchJastrow(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    vmc::EuclideanMetric em(3);
+    PolynomialU2 u2(&em, -0.3, -0.1);
+    for (const int npart : {2, 4, 8, 16, 32, 64}) {
+        vmc::TwoBodyJastrow J(npart, &u2);
+        const auto x = randomPositions(3*npart, 2., cfg.rgen);
+        double protov[1];
+        results.push_back(runBench("jastrow", "protoFunction", npart, [&]() {
+            J.protoFunction(x.data(), protov);
+            sink() += protov[0];
+        }, cfg.mintime));
+        results.push_back(runBench("jastrow", "computeAllDerivatives", npart, [&]() {
+            J.computeAllDerivatives(x.data());
+            sink() += J.getD1DivByWF(0);
+        }, cfg.mintime));
+    }
+}
+
+void benchBatch(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    // per-walker vs. walker-batched (SoA) evaluation of W walkers, ops_per_s counts walkers
+    const int npart = 8, ndim = 3*npart;
+    vmc::EuclideanMetric em(3);
+    GaussianU2 u2(&em, 0.05, true);
+    vmc::TwoBodyJastrow J(npart, &u2);
+    for (const int nwalkers : {1, 4, 16, 64, 256}) {
+        const auto xs = randomPositions(ndim*nwalkers, 2., cfg.rgen); // SoA layout
+        std::vector<double> x(static_cast<size_t>(ndim*nwalkers)); // the same walkers, AoS layout
+        for (int w = 0; w < nwalkers; ++w) {
+            for (int i = 0; i < ndim; ++i) { x[w*ndim + i] = xs[i*nwalkers + w]; }
+        }
+        std::vector<double> d1s(xs.size()), d2s(xs.size()), vd1s(static_cast<size_t>(nwalkers));
+        results.push_back(runBench("batch", "computeAllDerivatives", nwalkers, [&]() {
+            for (int w = 0; w < nwalkers; ++w) {
+                J.computeAllDerivatives(x.data() + w*ndim);
+                sink() += J.getD1DivByWF(0);
+            }
+        }, cfg.mintime, nwalkers));
+        results.push_back(runBench("batch", "computeAllDerivativesBatch", nwalkers, [&]() {
+            J.computeAllDerivativesBatch(nwalkers, xs.data(), d1s.data(), d2s.data(), vd1s.data());
+            sink() += d1s[0];
+        }, cfg.mintime, nwalkers));
+    }
+}
+
+void benchMultiComponent(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    const int npart = 8;
+    vmc::EuclideanMetric em(3);
+    std::vector<std::unique_ptr<PolynomialU2>> u2s;
+    std::vector<std::unique_ptr<vmc::TwoBodyJastrow>> Js;
+    const auto x = randomPositions(3*npart, 2., cfg.rgen);
+    for (const int ncomp : {1, 2, 4, 8}) {
+        while (static_cast<int>(Js.size()) < ncomp) {
+            u2s.emplace_back(new PolynomialU2(&em, -0.3 + 0.01*u2s.size(), -0.1));
+            Js.emplace_back(new vmc::TwoBodyJastrow(npart, u2s.back().get()));
+        }
+        vmc::MultiComponentWaveFunction Psi(3, npart, true, true, true);
+        for (int i = 0; i < ncomp; ++i) { Psi.addWaveFunction(Js[i].get()); }
+        std::vector<double> protov(static_cast<size_t>(Psi.getNProto()));
+        results.push_back(runBench("multicomponent", "protoFunction", ncomp, [&]() {
+            Psi.protoFunction(x.data(), protov.data());
+            sink() += protov[0];
+        }, cfg.mintime));
+        results.push_back(runBench("multicomponent", "computeAllDerivatives", ncomp, [&]() {
+            Psi.computeAllDerivatives(x.data());
+            sink() += Psi.getD1DivByWF(0);
+        }, cfg.mintime));
+    }
+}
+
+void benchSymmetrizer(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    vmc::EuclideanMetric em(3);
+    PolynomialU2 u2(&em, -0.3, -0.1);
+    for (const int npart : {2, 3, 4, 5, 6}) {
+        vmc::TwoBodyJastrow J(npart, &u2);
+        vmc::SymmetrizerWaveFunction Psi(&J);
+        const auto x = randomPositions(3*npart, 2., cfg.rgen);
+        double protov[1];
+        results.push_back(runBench("symmetrizer", "protoFunction", npart, [&]() {
+            Psi.protoFunction(x.data(), protov);
+            sink() += protov[0];
+        }, cfg.mintime));
+        results.push_back(runBench("symmetrizer", "computeAllDerivatives", npart, [&]() {
+            Psi.computeAllDerivatives(x.data());
+            sink() += Psi.getD1DivByWF(0);
+        }, cfg.mintime));
+    }
+}
+
+void benchSRSolve(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    std::normal_distribution<double> rn(0., 1.);
+    for (const int nvp : {2, 8, 32, 128}) {
+        // synthetic observables with a well-conditioned overlap matrix S_ij = <OiOj> - <Oi><Oj>
+        const auto nvps = static_cast<size_t>(nvp);
+        std::vector<double> obs(4 + 2*nvps + nvps*nvps), dobs(obs.size(), 0.01);
+        std::vector<double> A(nvps*nvps);
+        for (double &a : A) { a = rn(cfg.rgen)/sqrt(nvp); }
+        obs[0] = 1.;
+        for (size_t i = 0; i < nvps; ++i) {
+            obs[4 + i] = 0.1*rn(cfg.rgen); // Oi
+            obs[4 + nvps + i] = obs[4 + i] + 0.1*rn(cfg.rgen); // HOi
+        }
+        for (size_t i = 0; i < nvps; ++i) {
+            for (size_t j = 0; j < nvps; ++j) {
+                double sij = (i == j) ? 1. : 0.;
+                for (size_t k = 0; k < nvps; ++k) { sij += A[i*nvps + k]*A[j*nvps + k]; }
+                obs[4 + 2*nvps + i*nvps + j] = sij + obs[4 + i]*obs[4 + j];
+            }
+        }
+        std::vector<double> grad(nvps), dgrad(nvps);
+        results.push_back(runBench("srsolve", "computeSRDirection", nvp, [&]() {
+            vmc::computeSRDirection(nvp, obs.data(), dobs.data(), grad.data(), dgrad.data());
+            sink() += grad[0];
+        }, cfg.mintime));
+    }
+}
+
+
+// --- End-to-end suite
+
+void benchEnergy(BenchConfig &cfg, std::vector<BenchResult> &results)
+{
+    const int64_t NMC = 5000; // MC steps per computeEnergy call
+    double E[4], dE[4];
+
+    { // the minimal 1D, 1 particle system, i.e. mostly MCI overhead
+        vmc::VMC vmc(Gaussian1D1POrbital(0.5), HarmonicOscillator1D1P(1.));
+        vmc.computeEnergy(NMC, E, dE); // equilibrate once
+        results.push_back(runBench("energy", "computeEnergy_1D1P", 1, [&]() {
+            vmc.computeEnergy(NMC, E, dE, false, false);
+            sink() += E[0];
+        }, cfg.mintime_e2e, NMC, 3));
+    }
+
+    // N particles in 3D, with gaussian orbitals times a two-body Jastrow
+    vmc::EuclideanMetric em(3);
+    GaussianU2 u2(&em, 0.05);
+    for (const int npart : {2, 8, 32}) {
+        GaussianNP G(3, npart, 0.5);
+        vmc::TwoBodyJastrow J(npart, &u2);
+        vmc::MultiComponentWaveFunction Psi(3, npart, false);
+        Psi.addWaveFunction(&G);
+        Psi.addWaveFunction(&J);
+        vmc::VMC vmc(Psi, HarmonicOscillatorNP(3, npart, 1.));
+        vmc.computeEnergy(NMC, E, dE);
+        results.push_back(runBench("energy", "computeEnergy_3DNP", npart, [&]() {
+            vmc.computeEnergy(NMC, E, dE, false, false);
+            sink() += E[0];
+        }, cfg.mintime_e2e, NMC, 3));
+    }
+}
+
+
+void printUsage()
+{
+    std::cout << "Usage: vmc_bench [options] [suites...]\n"
+              << "Suites: metric pseudopotential jastrow batch multicomponent symmetrizer srsolve energy (default: all)\n"
+              << "Options:\n"
+              << "  --out FILE        write JSON results to FILE (default: stdout)\n"
+              << "  --mintime SEC     minimal time per kernel benchmark (default 0.2)\n"
+              << "  --mintime-e2e SEC minimal time per end-to-end benchmark (default 1)\n"
+              << "  --quick           shortcut for --mintime 0.02 --mintime-e2e 0.1\n";
+}
+
+int main(int argc, char ** argv)
+{
+    const int myrank = MPIVMC::Init();
+
+    BenchConfig cfg;
+    std::string outfile;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--out" && i + 1 < argc) { outfile = argv[++i]; }
+        else if (arg == "--mintime" && i + 1 < argc) { cfg.mintime = std::atof(argv[++i]); }
+        else if (arg == "--mintime-e2e" && i + 1 < argc) { cfg.mintime_e2e = std::atof(argv[++i]); }
+        else if (arg == "--quick") {
+            cfg.mintime = 0.02;
+            cfg.mintime_e2e = 0.1;
+        }
+        else if (arg == "--help" || arg == "-h" || arg[0] == '-') {
+            if (myrank == 0) { printUsage(); }
+            MPIVMC::Finalize();
+            return (arg[0] == '-' && arg != "--help" && arg != "-h") ? 1 : 0;
+        }
+        else { cfg.suites.push_back(arg); }
+    }
+
+    std::vector<BenchResult> results;
+    if (cfg.runSuite("metric")) { benchMetric(cfg, results); }
+    if (cfg.runSuite("pseudopotential")) { benchPseudoPotential(cfg, results); }
+    if (cfg.runSuite("jastrow")) { benchJastrow(cfg, results); }
+    if (cfg.runSuite("batch")) { benchBatch(cfg, results); }
+    if (cfg.runSuite("multicomponent")) { benchMultiComponent(cfg, results); }
+    if (cfg.runSuite("symmetrizer")) { benchSymmetrizer(cfg, results); }
+    if (cfg.runSuite("srsolve")) { benchSRSolve(cfg, results); }
+    if (cfg.runSuite("energy")) { benchEnergy(cfg, results); }
+
+#if USE_MPI == 1
+    const std::string mpi = "1";
+#else
+    const std::string mpi = "0";
+#endif
+#if USE_PROFILING == 1
+    const std::string profiling = "1";
+#else
+    const std::string profiling = "0";
+#endif
+    const std::vector<std::pair<std::string, std::string>> info{
+            {"compiler", __VERSION__},
+            {"mpi", mpi},
+            {"mpi_size", std::to_string(MPIVMC::Size())},
+            {"profiling", profiling},
+            {"checksum", std::to_string(sink())} // keeps the benchmarked results alive
+    };
+    if (myrank == 0) {
+        if (outfile.empty()) { writeJSON(std::cout, results, info); }
+        else {
+            std::ofstream out(outfile);
+            writeJSON(out, results, info);
+        }
+    }
+
+    MPIVMC::Finalize();
+    return 0;
+}
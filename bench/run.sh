@@ -0,0 +1,8 @@
+#!/bin/sh
+# run all benchmark suites and store the results, e.g.: ./run.sh results.json [suites...]
+
+OUT=${1:-bench_results.json}
+[ $# -gt 0 ] && shift
+
+cd ../build/bench/
+./vmc_bench --out "${OUT}" "$@" && echo "Results written to build/bench/${OUT}"
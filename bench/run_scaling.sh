@@ -0,0 +1,22 @@
+#!/bin/sh
+# Strong/weak scaling on this machine, for 1..NPROCS local ranks (default: number of cores)
+# Usage: ./run_scaling.sh [NPROCS] [results.json] [further vmc_scaling options...]
+
+NPROCS=${1:-$(nproc)}
+OUT=${2:-scaling_results.json}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] && shift
+
+# pin the ranks to cores (the option syntax differs between Open MPI and MPICH)
+if mpirun --version 2>&1 | grep -q "Open MPI"; then
+    BIND="--bind-to core"
+else
+    BIND="-bind-to core"
+fi
+
+cd ../build/bench/
+rm -f "${OUT}" # every run appends its results, the efficiency is relative to the first one
+for P in $(seq 1 "${NPROCS}"); do
+    mpirun -np "${P}" ${BIND} ./vmc_scaling --out "${OUT}" "$@" || exit 1
+done
+echo "Results written to build/bench/${OUT}"
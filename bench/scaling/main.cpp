@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if USE_MPI != 1
+#error "vmc_scaling requires a library build with USE_MPI=1"
+#endif
+
+#include <mpi.h>
+
+#include "nfm/Adam.hpp"
+#include "nfm/LogManager.hpp"
+
+#include "vmc/EnergyMinimization.hpp"
+#include "vmc/EuclideanMetric.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/MultiComponentWaveFunction.hpp"
+#include "vmc/Profiler.hpp"
+#include "vmc/TwoBodyJastrow.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../BenchFunctions.hpp"
+
+// Strong/weak scaling benchmark of the MPI energy evaluation and energy minimization step
+//
+// Measures the library entry points with all ranks of MPI_COMM_WORLD (which MPIVMC::Integrate reduces over):
+//     energy:   MPIVMC::Integrate of the energy (including fixed-length findMRT2step/decorrelation)
+//     gradient: one step of minimizeEnergy with the Adam optimizer and EnergyGradientTargetFunction
+// and reports the minimum over --nrep repetitions of the slowest rank's time. If the library was compiled with
+// USE_PROFILING=1, the rank-averaged times of the profiler phases of the best repetition are reported as well
+// (e.g. Integrate vs. MPIReduce vs. GradientSolve). Run it once per rank count (see run_scaling.sh), appending
+// the results to the same --out file, which are one JSON object per line. The parallel efficiency is computed
+// relative to the first result of the same mode and task in that file.
+// Modes: strong (fixed total Nmc, split among the ranks) and weak (fixed Nmc per rank).
+
+struct ScalingConfig
+{
+    int64_t nmc = 100000; // total (strong) or per-rank (weak) MC steps
+    int npart = 8;
+    int nfind = 10; // findMRT2step iterations
+    int64_t ndecorr = 1000; // decorrelation steps
+    int nrep = 3;
+    std::vector<std::string> modes{"strong", "weak"};
+    std::string outfile;
+};
+
+struct ScalingResult
+{
+    std::string mode, task;
+    int nranks;
+    int64_t nmc_total;
+    double time; // max over ranks
+    std::vector<vmc::ProfileEntry> phases; // rank-averaged, empty without profiling
+    double efficiency, samples_per_s;
+};
+
+// Time f() on all ranks, returns the time of the slowest rank
+template <class F>
+double timedCall(F &&f)
+{
+    MPI_Barrier(MPI_COMM_WORLD);
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    MPI_Allreduce(MPI_IN_PLACE, &time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return time;
+}
+
+// Run one task nrep times, returns the best result (without efficiency)
+ScalingResult runTask(const ScalingConfig &cfg, const std::string &mode, const std::string &task)
+{
+    const int nranks = MPIVMC::Size();
+    vmc::EuclideanMetric em(3);
+    GaussianNP G(3, cfg.npart, 0.5, true);
+    GaussianU2 u2(&em, 0.05, true);
+    vmc::TwoBodyJastrow J(cfg.npart, &u2);
+    vmc::MultiComponentWaveFunction Psi(3, cfg.npart, true);
+    Psi.addWaveFunction(&G);
+    Psi.addWaveFunction(&J);
+    vmc::VMC vmc(Psi, HarmonicOscillatorNP(3, cfg.npart, 1.));
+    MPIVMC::SetSeed(vmc.getMCI(), 1337);
+    vmc.getMCI().setNfindMRT2Iterations(cfg.nfind);
+    vmc.getMCI().setNdecorrelationSteps(cfg.ndecorr);
+
+    ScalingResult best;
+    best.mode = mode;
+    best.task = task;
+    best.nranks = nranks;
+    best.nmc_total = (mode == "strong") ? cfg.nmc : cfg.nmc*nranks;
+    best.time = -1.;
+
+    std::vector<double> vp0(static_cast<size_t>(vmc.getNVP()));
+    vmc.getVP(vp0.data());
+    std::vector<double> avg(static_cast<size_t>(vmc.getMCI().getNObsDim())), err(avg.size());
+    for (int ir = 0; ir < cfg.nrep; ++ir) {
+        vmc::Profiler::reset();
+        double time;
+        if (task == "energy") {
+            time = timedCall([&]() { MPIVMC::Integrate(vmc.getMCI(), best.nmc_total, avg.data(), err.data(), true, true); });
+        }
+        else { // every repetition performs the same first step
+            vmc.setVP(vp0.data());
+            nfm::Adam adam(vmc.getNVP());
+            adam.setMaxNIterations(1);
+            time = timedCall([&]() { vmc::minimizeEnergy(vmc, adam, best.nmc_total, best.nmc_total, false); });
+        }
+        if (best.time < 0. || time < best.time) {
+            best.time = time;
+            best.phases.clear();
+            const vmc::ProfileReport report = vmc::Profiler::getReport();
+            if (report.enabled) {
+                for (const vmc::ProfileEntry &e : report.entries) {
+                    double seconds = e.seconds;
+                    MPI_Allreduce(MPI_IN_PLACE, &seconds, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+                    best.phases.push_back(vmc::ProfileEntry{e.name, e.calls, seconds/nranks, {}});
+                }
+            }
+        }
+    }
+    best.samples_per_s = static_cast<double>(best.nmc_total)/best.time;
+    return best;
+}
+
+// Find samples_per_s and nranks of the first result of mode and task in the existing output file
+bool readReference(const std::string &filename, const std::string &mode, const std::string &task, double &samples_per_s, int &nranks)
+{
+    std::ifstream file(filename);
+    const std::string key = "{\"mode\": \"" + mode + "\", \"task\": \"" + task + "\"";
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, key.size(), key) != 0) { continue; }
+        const size_t ipos = line.find("\"nranks\": "), spos = line.find("\"samples_per_s\": ");
+        if (ipos == std::string::npos || spos == std::string::npos) { continue; }
+        nranks = std::atoi(line.c_str() + ipos + 10);
+        samples_per_s = std::atof(line.c_str() + spos + 17);
+        return true;
+    }
+    return false;
+}
+
+
+void printUsage()
+{
+    std::cout << "Usage: mpirun -np P vmc_scaling [options]\n"
+              << "Options:\n"
+              << "  --out FILE       append the results (one JSON object per line) to FILE (default: stdout)\n"
+              << "  --mode MODE      strong, weak or both (default)\n"
+              << "  --nmc N          total (strong) / per-rank (weak) MC steps (default 100000)\n"
+              << "  --npart N        number of particles (default 8)\n"
+              << "  --nfind N        findMRT2step iterations (default 10)\n"
+              << "  --ndecorr N      decorrelation steps (default 1000)\n"
+              << "  --nrep N         repetitions per measurement (default 3)\n";
+}
+
+int main(int argc, char ** argv)
+{
+    const int myrank = MPIVMC::Init();
+    nfm::LogManager::setLoggingOn(false);
+
+    ScalingConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        const bool hasValue = (i + 1 < argc);
+        if (arg == "--out" && hasValue) { cfg.outfile = argv[++i]; }
+        else if (arg == "--mode" && hasValue) {
+            const std::string mode(argv[++i]);
+            if (mode != "both") { cfg.modes = {mode}; }
+        }
+        else if (arg == "--nmc" && hasValue) { cfg.nmc = std::atoll(argv[++i]); }
+        else if (arg == "--npart" && hasValue) { cfg.npart = std::atoi(argv[++i]); }
+        else if (arg == "--nfind" && hasValue) { cfg.nfind = std::atoi(argv[++i]); }
+        else if (arg == "--ndecorr" && hasValue) { cfg.ndecorr = std::atoll(argv[++i]); }
+        else if (arg == "--nrep" && hasValue) { cfg.nrep = std::max(1, std::atoi(argv[++i])); }
+        else {
+            if (myrank == 0) { printUsage(); }
+            MPIVMC::Finalize();
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+    for (const auto &mode : cfg.modes) {
+        if (mode != "strong" && mode != "weak") {
+            if (myrank == 0) { std::cerr << "Invalid mode " << mode << std::endl; }
+            MPIVMC::Finalize();
+            return 1;
+        }
+    }
+
+    std::vector<ScalingResult> results;
+    for (const auto &mode : cfg.modes) {
+        for (const std::string task : {"energy", "gradient"}) {
+            results.push_back(runTask(cfg, mode, task));
+        }
+    }
+
+    if (myrank == 0) {
+        for (ScalingResult &r : results) {
+            // parallel efficiency relative to the first (usually 1 rank) measurement, see header
+            double ref_rate = r.samples_per_s;
+            int ref_nranks = r.nranks;
+            if (!cfg.outfile.empty()) { readReference(cfg.outfile, r.mode, r.task, ref_rate, ref_nranks); }
+            r.efficiency = (r.samples_per_s/r.nranks)/(ref_rate/ref_nranks);
+        }
+
+        std::ofstream file;
+        if (!cfg.outfile.empty()) { file.open(cfg.outfile, std::ios::app); }
+        std::ostream &out = cfg.outfile.empty() ? std::cout : file;
+        out << std::setprecision(6);
+        for (const ScalingResult &r : results) {
+            out << "{\"mode\": \"" << r.mode << "\", \"task\": \"" << r.task << "\", \"nranks\": " << r.nranks
+                << ", \"npart\": " << cfg.npart << ", \"nfind\": " << cfg.nfind << ", \"ndecorr\": " << cfg.ndecorr
+                << ", \"nrep\": " << cfg.nrep << ", \"nmc_total\": " << r.nmc_total << ", \"time\": " << r.time << ", \"phases\": {";
+            for (size_t i = 0; i < r.phases.size(); ++i) {
+                out << (i > 0 ? ", " : "") << "\"" << r.phases[i].name << "\": " << r.phases[i].seconds;
+            }
+            out << "}, \"efficiency\": " << r.efficiency << ", \"samples_per_s\": " << r.samples_per_s << "}\n";
+        }
+    }
+
+    MPIVMC::Finalize();
+    return 0;
+}
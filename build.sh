@@ -2,7 +2,7 @@
 
 . ./config.sh
 mkdir -p build && cd build
-cmake -DCMAKE_CXX_COMPILER="${CXX_COMPILER}" -DUSER_CXX_FLAGS="${CXX_FLAGS}" -DUSE_COVERAGE="${USE_COVERAGE}" -DUSE_MPI="${USE_MPI}" -DMCI_ROOT_DIR="${MCI_ROOT}" -DNFM_ROOT_DIR="${NFM_ROOT}" -DGSL_ROOT_DIR="${GSL_ROOT}" -DCMAKE_EXPORT_COMPILE_COMMANDS=ON ..
+cmake -DCMAKE_CXX_COMPILER="${CXX_COMPILER}" -DUSER_CXX_FLAGS="${CXX_FLAGS}" -DUSE_COVERAGE="${USE_COVERAGE}" -DUSE_MPI="${USE_MPI}" -DUSE_ZLIB="${USE_ZLIB}" -DUSE_PROFILING="${USE_PROFILING}" -DMCI_ROOT_DIR="${MCI_ROOT}" -DNFM_ROOT_DIR="${NFM_ROOT}" -DGSL_ROOT_DIR="${GSL_ROOT}" -DCMAKE_EXPORT_COMPILE_COMMANDS=ON ..
 
 if [ "$1" = "" ]; then
   make -j$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || getconf _NPROCESSORS_ONLN 2>/dev/null)
@@ -12,6 +12,12 @@ USE_COVERAGE=0
 # use MPI for integration
 USE_MPI=0
 
+# use zlib for compressed trajectory files
+USE_ZLIB=0
+
+# compile in the hot-path phase timers (see include/vmc/Profiler.hpp)
+USE_PROFILING=0
+
 # MCIntegrator++ Library
 MCI_ROOT="/...../MCIntegratorPlusPlus"
 
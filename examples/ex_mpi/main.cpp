@@ -3,6 +3,7 @@
 
 #include "nfm/ConjGrad.hpp"
 #include "vmc/Hamiltonian.hpp"
+#include "vmc/Trajectory.hpp"
 #include "vmc/VMC.hpp"
 
 #include "vmc/MPIVMC.hpp" // this example requires MPI!
@@ -32,13 +33,17 @@ int main()
         d_energy[i] = 0.;
     }
 
-    // example of file out with MPI (but we disable it for the test below (100K Steps!!))
-    auto obsfile = "obsfile" + std::to_string(myrank);
-    auto wlkfile = "wlkfile" + std::to_string(myrank);
-    vmc.getMCI().storeObservablesOnFile(obsfile, 1); // would print observables on every step
-    vmc.getMCI().storeWalkerPositionsOnFile(wlkfile, 1); // would print walker positions on every step
-    vmc.getMCI().clearObservableFile();
-    vmc.getMCI().clearWalkerFile();
+    // example of file out with MPI: every rank streams the configurations (walker positions, proto values and
+    // local energies) of one energy computation to its own binary trajectory file (see vmc::TrajectoryReader)
+    // (we only record a short run here, not the evaluations below (100K Steps!!))
+    {
+        TrajectoryWriter writer("trajectory" + std::to_string(myrank) + ".bin", vmc.getNTotalDim(), vmc.getWF().getNProto(), 4);
+        vmc.recordTrajectory(10000, writer, energy_h, d_energy_h);
+        writer.close();
+        if (myrank == 0) {
+            cout << "Recorded " << writer.getNRecords() << " configurations on rank 0, Total Energy = " << energy_h[0] << " +- " << d_energy_h[0] << endl;
+        }
+    }
 
     if (myrank == 0) {
         cout << endl << " - - - EVALUATION OF ENERGY - - - " << endl << endl;
@@ -95,7 +100,17 @@ int main()
         cout << "Potential Energy    = " << energy[1]/neval << " +- " << sqrt(d_energy[1])/neval << endl;
         cout << "Kinetic (PB) Energy = " << energy[2]/neval << " +- " << sqrt(d_energy[2])/neval << endl;
         cout << "Kinetic (JF) Energy = " << energy[3]/neval << " +- " << sqrt(d_energy[3])/neval << endl << endl;
-        cout << "Note that the wave function was not the exact ground state, i.e. E > E_0 = 0.5." << endl;
+        cout << "Note that the wave function was not the exact ground state, i.e. E > E_0 = 0.5." << endl << endl;
+    }
+
+    // Finally, let every CPU sample for a fixed amount of time (here 1 second, in chunks of 1000 steps),
+    // such that faster CPUs contribute more samples instead of waiting for the slower ones
+    if (myrank == 0) {
+        cout << "Computing the energy with a fixed time budget per CPU (consistent time, inconsistent samples per CPU)." << endl;
+    }
+    const int64_t nsamples = vmc.computeEnergyTimed(1., 1000, energy_h, d_energy_h);
+    if (myrank == 0) {
+        cout << "Total Energy        = " << energy_h[0] << " +- " << d_energy_h[0] << " (" << nsamples << " samples)" << endl;
     }
 
     MPIVMC::Finalize();
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "vmc/ConfigurationSampler.hpp"
+#include "vmc/Trajectory.hpp"
+#include "vmc/TrajectoryReplay.hpp"
+
+#include "../common/ExampleFunctions.hpp"
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    // Setup wave function and Hamiltonian
+    const double b_ref = 0.45; // gaussian parameter used for sampling
+    const double w = 1.; // We use the harmonic oscillator with w=1
+    Gaussian1D1POrbital psi(b_ref);
+    HarmonicOscillator1D1P ham(w);
+    ham.bindWaveFunction(&psi); // needed to compute local energies outside of MCI
+
+    // --- Expensive part: sample configurations once and store them in a trajectory file
+    const char * const filename = "trajectory.bin";
+    const int NREC = 200000; // number of stored configurations
+    ConfigurationSampler sampler(psi);
+    sampler.setSeed(1337);
+    sampler.tuneStepSize();
+    sampler.decorrelate(10000);
+    {
+        TrajectoryWriter writer(filename, psi.getTotalNDim(), psi.getNProto(), 4 /*local energies*/);
+        sampler.record(NREC, 2, writer, &ham); // positions, proto values and local energies
+    }
+    cout << "Stored " << NREC << " configurations sampled with b = " << b_ref << " in " << filename << "." << endl << endl;
+
+    // --- Cheap part: replay the stored configurations with other wave functions (in parallel)
+    TrajectoryReader reader(filename);
+    TrajectoryReplay replay(reader); // uses all hardware threads
+    replay.setBlockSize(1000);
+
+    double energy[4], d_energy[4];
+    for (const double b : {0.4, 0.45, 0.5, 0.55, 0.6}) {
+        Gaussian1D1POrbital psi_b(b);
+        replay.evaluate(psi_b, ham, energy, d_energy); // reweighted with |Psi_b/Psi_ref|^2
+        cout << "b = " << b << ":   Total Energy = " << energy[0] << " +- " << d_energy[0];
+        cout << "   (effective sample size " << replay.getESS() << ")" << endl;
+    }
+    cout << endl << "The exact ground state is b = 0.5 with E_0 = 0.5." << endl;
+
+    remove(filename);
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef VMC_ALIGNEDALLOCATOR_HPP
+#define VMC_ALIGNEDALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace vmc
+{
+
+// Allocator for std::vector returning memory aligned to Align bytes (a cache line by default)
+// The allocated size is rounded up to a multiple of Align, so no other allocation shares the first or
+// last cache line (e.g. of data written concurrently by different threads). Unlike operator new in C++14,
+// it also respects the alignment of over-aligned types (alignas(64)).
+template <typename T, size_t Align = 64>
+struct AlignedAllocator
+{
+    static_assert(Align >= alignof(T) && Align%sizeof(void *) == 0, "Align must be a multiple of the pointer size and at least alignof(T).");
+
+    using value_type = T;
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Align>;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Align> &/*other*/) noexcept {}
+
+    T * allocate(const size_t n)
+    {
+        void * ptr = nullptr;
+        const size_t bytes = ((n*sizeof(T) + Align - 1)/Align)*Align;
+        if (posix_memalign(&ptr, Align, bytes) != 0) { throw std::bad_alloc(); }
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T * ptr, size_t /*n*/) noexcept { free(ptr); }
+};
+
+template <typename T, typename U, size_t Align>
+bool operator==(const AlignedAllocator<T, Align> &/*a*/, const AlignedAllocator<U, Align> &/*b*/) { return true; }
+
+template <typename T, typename U, size_t Align>
+bool operator!=(const AlignedAllocator<T, Align> &/*a*/, const AlignedAllocator<U, Align> &/*b*/) { return false; }
+} // namespace vmc
+
+#endif
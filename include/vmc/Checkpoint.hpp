@@ -0,0 +1,118 @@
+#ifndef VMC_CHECKPOINT_HPP
+#define VMC_CHECKPOINT_HPP
+
+#include "vmc/ConfigurationSampler.hpp"
+#include "vmc/VMC.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vmc
+{
+
+// Binary checkpoint/restart of VMC walkers, ConfigurationSampler walkers and optimizer state
+//
+// Per VMC, the variational parameters, the MCI walker position and the MRT2 step sizes are stored.
+// MCI's internal generator state is not accessible, so on restore the MCI is reseeded reproducibly from
+// the passed run seed, the rank and the checkpoint generation (counter-based, see Philox), and the next
+// energy evaluation skips findMRT2step/decorrelation (see VMC::skipNextEquilibration()).
+// Per ConfigurationSampler, the walker position, step size and the full Philox state are stored.
+// Proto values are not stored, but recomputed exactly from the restored positions and parameters.
+// The optimizer state is stored as iteration counter, parameter vector and free-form extra values.
+//
+// The file starts with a magic string and a format version. With MPI, every rank should write and
+// read its own file (e.g. by appending the rank to the filename).
+class Checkpoint
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+
+protected:
+    struct VMCState
+    {
+        uint64_t seed;
+        std::vector<double> vp, x, mrt2step;
+    };
+    struct SamplerState
+    {
+        uint64_t seed, stream, position;
+        double step;
+        std::vector<double> x;
+    };
+
+    uint64_t _generation = 0; // incremented on every write, used to reseed restored MCIs
+    std::vector<VMCState> _vmcs;
+    std::vector<SamplerState> _samplers;
+
+    // optimizer state
+    int64_t _opt_iter = 0;
+    std::vector<double> _opt_x;
+    std::vector<double> _opt_extra;
+
+public:
+    // Capture state (appends, use clear() to start a new checkpoint)
+    void addVMC(VMC &vmc, uint64_t seed); // seed: run seed used to reseed the MCI on restore
+    void addSampler(const ConfigurationSampler &sampler);
+    void setOptimizerState(int64_t iteration, const std::vector<double> &x, const std::vector<double> &extra = {});
+    void clear();
+
+    // Restore state (index in order of adding)
+    void restoreVMC(int i, VMC &vmc) const;
+    void restoreSampler(int i, ConfigurationSampler &sampler) const;
+
+    // Accessors
+    int getNVMC() const { return static_cast<int>(_vmcs.size()); }
+    int getNSampler() const { return static_cast<int>(_samplers.size()); }
+    uint64_t getGeneration() const { return _generation; }
+    int64_t getOptimizerIteration() const { return _opt_iter; }
+    const std::vector<double> &getOptimizerX() const { return _opt_x; }
+    const std::vector<double> &getOptimizerExtra() const { return _opt_extra; }
+
+    // File IO (throw std::runtime_error on failure or format mismatch)
+    void write(const std::string &filename);
+    void read(const std::string &filename); // replaces the current content
+};
+
+
+// Periodic checkpoints of an optimization, and resuming from the last one
+//
+// Pass a pointer to the minimizers (minimizeEnergy<GradT>(..., &checkpoint) or NMSimplexMinimization::setCheckpoint)
+// to write a Checkpoint of the VMC and of the optimizer state every interval iterations. If the file already exists
+// when a minimizer starts, the run is resumed from it: the VMC is restored (see Checkpoint::restoreVMC) and the
+// optimization continues from the stored state, with the iteration count continuing as well.
+// The gradient-based optimizers of NoisyFunMin don't expose their iterations, so for them every gradient evaluation
+// counts as iteration and the state is the last evaluated parameter vector (internal optimizer state, like the
+// moments of Adam, starts fresh on resume). NMSimplexMinimization stores its whole simplex in batched mode, while
+// the GSL mode restarts the simplex around the stored best vertex.
+//
+// The file is replaced atomically (written to filename.tmp first). With more than one rank, every rank writes
+// its own file with the rank appended (filename.rank), and either all or none of them must exist on resume.
+class OptimizerCheckpoint
+{
+protected:
+    const std::string _filename; // of this rank
+    const int _interval; // iterations between checkpoints (0 = never write)
+    const uint64_t _seed; // run seed used to reseed the MCI on restore
+    int64_t _iteration = 0; // completed iterations (including those before a resume)
+    Checkpoint _checkpoint; // last written or read checkpoint
+
+public:
+    OptimizerCheckpoint(const std::string &filename, int interval, uint64_t seed = 0);
+
+    const std::string &getFilename() const { return _filename; }
+    int getInterval() const { return _interval; }
+    int64_t getIteration() const { return _iteration; }
+    const Checkpoint &getCheckpoint() const { return _checkpoint; }
+
+    // If the checkpoint file exists (collective with MPI), read it, restore the VMC and the iteration count and
+    // return true. The stored optimizer state is then available via getCheckpoint().
+    bool resume(VMC &vmc);
+
+    // Count one completed iteration and write a checkpoint of vmc and the optimizer state (parameter vector x and
+    // further values extra) if the iteration count is a multiple of the interval. Returns true if written.
+    bool iterate(VMC &vmc, const std::vector<double> &x, const std::vector<double> &extra = {});
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef VMC_CONFIGURATIONSAMPLER_HPP
+#define VMC_CONFIGURATIONSAMPLER_HPP
+
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/Philox.hpp"
+#include "vmc/Trajectory.hpp"
+#include "vmc/WaveFunction.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace vmc
+{
+
+// Lightweight Metropolis walker sampling Psi^2 of a WaveFunction, used to produce stored configurations
+//
+// In contrast to MCI's integrator this gives direct access to every visited configuration (including
+// repeated ones after rejected moves), which is what reweighting and post-processing methods need.
+// Only the SamplingFunctionInterface contract (protoFunction / acceptanceFunction) is used, with
+// uniform all-particle trial moves.
+//
+// NOTE: The WaveFunction is not owned. If its variational parameters are changed from outside,
+// call refreshProtoValues() before continuing to sample.
+class ConfigurationSampler
+{
+protected:
+    WaveFunction &_wf;
+    const int _ndim;
+
+    std::vector<double> _x, _xnew; // walker positions
+    std::vector<double> _protoold, _protonew; // proto values at _x / _xnew
+    double _step; // trial move step size
+
+    Philox _rgen; // counter-based, see setSeed()
+    std::uniform_real_distribution<double> _rd;
+
+    int64_t _nacc, _nrej; // acceptance counters
+
+public:
+    explicit ConfigurationSampler(WaveFunction &wf, uint64_t seed = 0, double step = 0.1);
+
+    WaveFunction &getWF() const { return _wf; }
+    int getNDim() const { return _ndim; }
+
+    // Walker state
+    void setX(const double * x); // also refreshes the proto values
+    const double * getX() const { return _x.data(); }
+    const double * getProtoValues() const { return _protoold.data(); }
+    void refreshProtoValues();
+
+    // Trial moves
+    void setStepSize(double step) { _step = step; }
+    double getStepSize() const { return _step; }
+    void setSeed(uint64_t seed, uint64_t stream = 0) { _rgen.seed(seed, stream); } // see Philox::streamID()
+    Philox &getRNG() { return _rgen; } // e.g. to save/restore the generator position
+    const Philox &getRNG() const { return _rgen; }
+
+    // Acceptance statistics
+    double getAcceptanceRate() const { return (_nacc + _nrej > 0) ? static_cast<double>(_nacc)/(_nacc + _nrej) : 0.; }
+    void resetAcceptanceRate() { _nacc = 0; _nrej = 0; }
+
+    // Sampling
+    bool step(); // one Metropolis step, returns true on acceptance
+    void tuneStepSize(int niter = 20, int nsteps = 100, double targetrate = 0.5); // adapt step size towards target acceptance
+    void decorrelate(int64_t nsteps);
+
+    // Append nconf configurations (taken every nskip steps) to confs (size nconf*ndim) and,
+    // if protos is not nullptr, their proto values (size nconf*nproto)
+    void sample(int64_t nconf, int nskip, std::vector<double> &confs, std::vector<double> * protos = nullptr);
+
+    // Append nconf records (taken every nskip steps) of position and proto values to a trajectory file.
+    // If H is passed (it must be bound to the sampler's WaveFunction), the 4 local energies are stored
+    // as observables as well. The writer's record layout must match. (To record the MCI chain of a VMC instead,
+    // see VMC::recordTrajectory.)
+    void record(int64_t nconf, int nskip, TrajectoryWriter &writer, Hamiltonian * H = nullptr);
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef VMC_CORRELATEDEVALUATION_HPP
+#define VMC_CORRELATEDEVALUATION_HPP
+
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/VMC.hpp"
+#include "vmc/WaveFunction.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vmc
+{
+
+// Correlated evaluation of several candidate wave functions on the Markov chain of one guide VMC
+//
+// The VMC samples from its own (guide) wave function Psi_g as usual, while every added candidate pair
+// (Psi_k, H_k) is evaluated on the same configurations, with the local energies reweighted by
+//     w_k(x) = |Psi_k(x) / Psi_g(x)|^2
+// (computed via computeWFValue()). Hence the cost of sampling is shared by all candidates and the
+// estimates are strongly correlated, which makes energy differences much more precise than independent runs.
+// Unlike CorrelatedSampling, nothing is stored: the candidates are evaluated on the fly, by an observable
+// that is added to the VMC's MCI during evaluate(). The candidates may be of any type, e.g. different
+// ansatzes or the same wave function at different parameters. Adding a clone of the guide itself gives
+// a reference with w = 1.
+//
+// The candidates' observable only returns per-sample values (w_k, w_k^2, w_k*e_k, ...), all sums are taken
+// by MCI, so results account for every sample of the chain (e.g. repeated values of rejected steps) and are
+// combined over ranks like the guide's energies. Errors are estimated by MCI from block averages over blocks
+// of blocksize samples, via the linearized ratio estimator (see Reweighting.hpp). The covariances it needs
+// follow from the errors of sums of the values (var(a+b) = var(a) + var(b) + 2 cov(a,b)), which the
+// observable returns as well, so the errors of differences include the covariance of both candidates.
+// The blocks should be longer than the autocorrelation time. The quality of the reweighting is monitored by
+// the effective sample size of every candidate, ESS = (sum w)^2 / sum w^2, which becomes small if Psi_k
+// differs a lot from Psi_g.
+class CorrelatedEvaluation
+{
+protected:
+    class Observable; // the MCI observable evaluating the candidates
+
+    VMC &_vmc; // guide
+    int64_t _blocksize;
+
+    std::unique_ptr<WaveFunction> _guide; // private clone of the guide wave function
+    std::vector<std::unique_ptr<WaveFunction>> _wfs; // private clones of the candidates
+    std::vector<std::unique_ptr<Hamiltonian>> _Hs; // (bound to _wfs)
+
+    // MCI averages and errors of the observable values of the last evaluation. Per candidate k (NVALUES),
+    // with the energy components e[c]:
+    //     [w, w^2, w*e[c] (4), w*e[c] + w (4)]
+    // and then for every pair k < l the sums of the total energy values (A_k = w_k*e_k[0], B_k = w_k):
+    //     [A_k + A_l, A_k + B_l, B_k + A_l, B_k + B_l]
+    static constexpr int NVALUES = 10; // per candidate
+    std::vector<double> _obs;
+    std::vector<double> _dobs;
+    int64_t _nsamples = 0; // samples of the last evaluation (all ranks)
+    std::vector<double> _proto; // buffer for proto values
+
+    int _nvalues() const; // total number of observable values
+    size_t _pairOffset(int k, int l) const; // of the pair k < l
+    // covariance of the averages of the observable values i and j, given the index ij of their sum
+    double _cov(size_t i, size_t j, size_t ij) const;
+    void _computeValues(const double * x, double * values);
+
+public:
+    explicit CorrelatedEvaluation(VMC &vmc, int64_t blocksize = 100);
+    ~CorrelatedEvaluation();
+
+    // Add a candidate (cloned, the clone of H is bound to the clone of wf), returns its index
+    int addCandidate(const WaveFunction &wf, const Hamiltonian &H);
+    int getNCandidates() const { return static_cast<int>(_wfs.size()); }
+
+    void setBlockSize(int64_t blocksize);
+    int64_t getBlockSize() const { return _blocksize; }
+
+    // Sample Nmc steps with the guide VMC and evaluate all candidates on the configurations (collective with MPI,
+    // as in VMC::computeEnergy Nmc is the total over all ranks and the results are combined over ranks).
+    // The guide's own energies (layout of VMC::computeEnergy) are stored to guideE/guideDE, if not nullptr.
+    void evaluate(int64_t Nmc, double * guideE = nullptr, double * guideDE = nullptr, bool doFindMRT2step = true, bool doDecorrelation = true);
+
+    // --- Results of the last evaluate()
+    // Reweighted energies of candidate k (same layout as VMC::computeEnergy(), only the 4 energy components)
+    void getEnergy(int k, double * E, double * dE) const;
+    // Correlated total energy difference E_k - E_l and its error
+    void getEnergyDifference(int k, int l, double &diff, double &ddiff) const;
+    // Effective sample size of candidate k (sum over ranks) and the number of samples (MC steps/nskip of all ranks)
+    double getESS(int k) const;
+    int64_t getNSamples() const { return _nsamples; }
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef VMC_CORRELATEDSAMPLING_HPP
+#define VMC_CORRELATEDSAMPLING_HPP
+
+#include "vmc/ConfigurationSampler.hpp"
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/VMC.hpp"
+#include "vmc/WaveFunction.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vmc
+{
+
+// Correlated sampling engine for the evaluation of energies at many parameter sets on one sample set
+//
+// A set of configurations is sampled from Psi_ref^2 at a reference parameter vector vp_ref and stored.
+// Energies at nearby parameters vp are then computed by reweighting the local energies with
+//     w(x) = |Psi_vp(x) / Psi_ref(x)|^2
+// which makes energy differences strongly correlated (and cheap). The quality of the reweighting is
+// monitored by the effective sample size ESS = (sum w)^2 / sum w^2. If ESS/N falls below the set
+// threshold, new configurations are sampled at the requested parameters (which become the new reference).
+//
+// The engine works on private clones of the VMC's WaveFunction and Hamiltonian, so the passed VMC
+// object is left untouched. With MPI, every rank stores its own configurations and the sums are reduced.
+//
+// NOTE: The stored configurations should be approximately uncorrelated (choose nskip accordingly),
+// because the error estimates don't account for autocorrelation.
+class CorrelatedSampling
+{
+protected:
+    std::unique_ptr<WaveFunction> _wf; // private clone of the wave function
+    std::unique_ptr<Hamiltonian> _H; // private clone of the Hamiltonian (bound to _wf)
+    ConfigurationSampler _sampler; // walker used to produce the configurations
+
+    const int _nvp;
+    const int64_t _nconf; // number of stored configurations (per rank)
+    const int _nskip; // walker steps between stored configurations
+    int64_t _ndecorr = 1000; // decorrelation steps before sampling
+    double _min_ess_ratio = 0.5; // resample if ESS/N drops below this value (0 disables resampling)
+
+    std::vector<double> _vp_ref; // reference parameters
+    std::vector<double> _confs; // stored configurations (nconf*ndim)
+    std::vector<double> _protos; // reference proto values of stored configurations (nconf*nproto)
+
+    double _ess = 0.; // effective sample size of the last evaluation (sum over ranks)
+    int _nsample = 0; // how often did we (re-)sample
+
+    // per-configuration values of the last evaluation
+    std::vector<double> _weights; // reweighting factors
+    std::vector<double> _elocs; // local energies (4 per configuration)
+
+    // evaluate weights and local energies at vp and compute reweighted energies, returns ESS
+    double _evaluate(const double * vp, double * E, double * dE);
+
+public:
+    CorrelatedSampling(VMC &vmc, int64_t nconf, int nskip = 1, uint_fast64_t seed = 0);
+
+    // Settings
+    void setNDecorrelationSteps(int64_t ndecorr) { _ndecorr = ndecorr; }
+    int64_t getNDecorrelationSteps() const { return _ndecorr; }
+    void setMinESSRatio(double ratio) { _min_ess_ratio = ratio; }
+    double getMinESSRatio() const { return _min_ess_ratio; }
+
+    // Accessors
+    int getNVP() const { return _nvp; }
+    int64_t getNConf() const { return _nconf; }
+    int getNSkip() const { return _nskip; }
+    void getReferenceVP(double * vp) const { std::copy(_vp_ref.begin(), _vp_ref.end(), vp); }
+    const std::vector<double> &getConfigurations() const { return _confs; }
+    double getESS() const { return _ess; } // of last evaluation
+    int getNSample() const { return _nsample; } // including the initial sampling
+
+    // (Re-)sample the configurations at the passed parameters, which become the new reference.
+    // Without argument, the current reference (initially the VMC's parameters) is used.
+    void sample(const double * vp);
+    void sample();
+
+    // Reweighted energies (same layout as VMC::computeEnergy(), only the 4 energy components)
+    void computeEnergy(const double * vp, double * E, double * dE);
+
+    // Correlated total energy difference E(vp1) - E(vp2) and its error
+    void computeEnergyDifference(const double * vp1, const double * vp2, double &diff, double &ddiff);
+};
+} // namespace vmc
+
+#endif
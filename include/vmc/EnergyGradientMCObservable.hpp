@@ -7,6 +7,8 @@
 #include "vmc/WaveFunction.hpp"
 #include "vmc/DependencyHelpers.hpp"
 
+#include <cmath>
+
 namespace vmc
 {
 
@@ -60,6 +62,7 @@ public:
     // mci::ObservableFunctionInterface implementation
     void observableFunction(const double * in, double * out) final
     {
+        VMC_PROFILE_SCOPE(ObservableFunction);
         // obs[0 : wf->getNVP()-1] = Variational Derivative of the Wave Function
         // obs[wf->getNVP() : 2*wf->getNVP()-1] = Local Energy times the Variational Derivative of the Wave Function
         const double Hloc = _E[ElocID::ETot]; // use enum integer to get total energy
@@ -69,6 +72,22 @@ public:
         }
     }
 };
+
+// Norm of the error vector of the energy gradient 2*(HOi - H*Oi), from the results obs/dobs of an integration
+// with the energy (4 values) followed by Oi and HOi (nvp values each). This layout is shared by the
+// EnergyGradient, StochasticReconfiguration and LinearMethod MC observables.
+inline double energyGradientErrorNorm(const int nvp, const double * const obs, const double * const dobs)
+{
+    const double H = obs[ElocID::ETot], dH = dobs[ElocID::ETot];
+    const double * const Oi = obs + 4;
+    const double * const dOi = dobs + 4;
+    const double * const dHOi = dobs + 4 + nvp;
+    double norm = 0.;
+    for (int i = 0; i < nvp; ++i) {
+        norm += 4.*(dHOi[i]*dHOi[i] + dH*dH*Oi[i]*Oi[i] + H*H*dOi[i]*dOi[i]);
+    }
+    return sqrt(norm);
+}
 } // namespace vmc
 
 #endif
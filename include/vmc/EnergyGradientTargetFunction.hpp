@@ -1,24 +1,16 @@
 #ifndef VMC_ENERGYGRADIENTTARGETFUNCTION_HPP
 #define VMC_ENERGYGRADIENTTARGETFUNCTION_HPP
 
-#include "vmc/VMC.hpp"
-#include "nfm/NoisyFunction.hpp"
+#include "vmc/VMCTargetFunction.hpp"
 
 namespace vmc
 {
 
-class EnergyGradientTargetFunction: public nfm::NoisyFunctionWithGradient
+class EnergyGradientTargetFunction: public VMCTargetFunction
 {
-protected:
-    VMC &_vmc; // the VMC object containing WaveFunction, Hamiltonian and MCI
-    const int64_t _E_Nmc; // number of MC steps for energy calculation
-    const int64_t _grad_E_Nmc; // number of MC steps for gradient calculation
-    const double _lambda_reg; // vp regularization factor
-
 public:
     EnergyGradientTargetFunction(VMC &vmc, int64_t E_Nmc, int64_t grad_E_Nmc, bool useGradErr, double lambda_reg = 0.):
-            nfm::NoisyFunctionWithGradient(vmc.getNVP(), useGradErr), _vmc(vmc),
-            _E_Nmc(E_Nmc), _grad_E_Nmc(grad_E_Nmc), _lambda_reg(lambda_reg) {}
+            VMCTargetFunction(vmc, E_Nmc, grad_E_Nmc, useGradErr, lambda_reg) {}
 
     ~EnergyGradientTargetFunction() final = default;
 
@@ -1,6 +1,7 @@
 #ifndef VMC_ENERGYMINIMIZATION_HPP
 #define VMC_ENERGYMINIMIZATION_HPP
 
+#include "vmc/Checkpoint.hpp"
 #include "vmc/VMC.hpp"
 #include "vmc/EnergyGradientTargetFunction.hpp" // we use that as default
 #include "nfm/NoisyFunMin.hpp"
@@ -12,13 +13,25 @@ namespace vmc
 //
 // Pass vmc to be optimized and existing noisy optimizer NFM
 // Set the Gradient Type to be used via template <> and pass
-// the required constructor arguments.
+// the required constructor arguments. Optionally, every target
+// function evaluation is recorded to telemetry (see OptimizerTelemetry.hpp),
+// and checkpoints are written periodically to checkpoint. If the
+// checkpoint file exists already, the optimization is resumed from
+// it (see OptimizerCheckpoint in Checkpoint.hpp).
 template <typename GradT = EnergyGradientTargetFunction>
-void minimizeEnergy(VMC &vmc, nfm::NFM &nfm, int64_t E_NMC, int64_t grad_E_NMC, bool useGradErr = true, double lambda_reg = 0.)
+void minimizeEnergy(VMC &vmc, nfm::NFM &nfm, int64_t E_NMC, int64_t grad_E_NMC, bool useGradErr = true, double lambda_reg = 0.,
+                    OptimizerTelemetry * telemetry = nullptr, OptimizerCheckpoint * checkpoint = nullptr)
 {
     GradT gradfun(vmc, E_NMC, grad_E_NMC, useGradErr, lambda_reg); // create gradient target function of type GradT with passed arguments
+    gradfun.setTelemetry(telemetry);
+    gradfun.setCheckpoint(checkpoint);
     std::vector<double> x0(static_cast<size_t>(vmc.getNVP()));
-    vmc.getVP(x0.data()); // set x0 from wf VP
+    if (checkpoint != nullptr && checkpoint->resume(vmc)) {
+        x0 = checkpoint->getCheckpoint().getOptimizerX(); // continue from the last checkpoint
+    }
+    else {
+        vmc.getVP(x0.data()); // set x0 from wf VP
+    }
     nfm.findMin(gradfun, x0); // minimize energy
 }
 } // namespace vmc
@@ -3,11 +3,21 @@
 
 #include "vmc/Metric.hpp"
 
+#include <vector>
+
 namespace vmc
 {
 
 class EuclideanMetric: public Metric
 {
+private:
+    std::vector<double> _rbuf; // distances used by the batched derivatives
+
+    Metric * _clone() const final
+    {
+        return new EuclideanMetric(_nspacedim);
+    }
+
 public:
     explicit EuclideanMetric(int nspacedim): Metric(nspacedim) {}
     ~EuclideanMetric() override = default;
@@ -17,6 +27,13 @@ public:
     void distD1(const double * r1, const double * r2, double * out) override;
 
     void distD2(const double * r1, const double * r2, double * out) override;
+
+    // vectorized across the points
+    void distBatch(int n, const double * r1s, const double * r2s, double * out) override;
+
+    void distD1Batch(int n, const double * r1s, const double * r2s, double * out) override;
+
+    void distD2Batch(int n, const double * r1s, const double * r2s, double * out) override;
 };
 } // namespace vmc
 
@@ -6,6 +6,10 @@
 #include "vmc/WaveFunction.hpp"
 #include "vmc/DependencyHelpers.hpp"
 
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
 namespace vmc
 {
 
@@ -49,6 +53,17 @@ public:
 
     bool hasPBKE() const { return _flag_PBKE; }
 
+    // Clone as Hamiltonian (unbound, see bindWaveFunction())
+    std::unique_ptr<Hamiltonian> cloneHamiltonian() const
+    {
+        std::unique_ptr<Hamiltonian> newH(dynamic_cast<Hamiltonian *>(this->clone().release()));
+        if (!newH) {
+            throw std::runtime_error("[Hamiltonian] clone() did not produce a type derived from Hamiltonian.");
+        }
+        newH->bindWaveFunction(nullptr);
+        return newH;
+    }
+
     // use this if you need to check whether observable is bound (i.e. can be fully used)
     bool isBound() const { return (_wf != nullptr); }
 
@@ -73,6 +88,17 @@ public:
     // Potential energy --- MUST BE IMPLEMENTED
     virtual double localPotentialEnergy(const double * r) = 0;
 
+    // Potential energies epots[w] of nwalkers configurations in SoA layout (see WaveFunction::protoFunctionBatch)
+    // The default loops over localPotentialEnergy, override it to vectorize across the walkers.
+    virtual void localPotentialEnergyBatch(const int nwalkers, const double * xs, double * epots)
+    {
+        std::vector<double> x(static_cast<size_t>(_ndim));
+        for (int w = 0; w < nwalkers; ++w) {
+            for (int i = 0; i < _ndim; ++i) { x[i] = xs[i*nwalkers + w]; }
+            epots[w] = this->localPotentialEnergy(x.data());
+        }
+    }
+
     double localPBKineticEnergy(const double * /*r*/)
     {
         double ekin = 0.;
@@ -94,11 +120,42 @@ public:
 
     void observableFunction(const double * in, double * out) override
     {
+        VMC_PROFILE_SCOPE(ObservableFunction);
         out[ElocID::EKinJF] = localJFKineticEnergy(in);
         out[ElocID::EKinPB] = _flag_PBKE ? localPBKineticEnergy(in) : 0.;
         out[ElocID::EPot] = localPotentialEnergy(in);
         out[ElocID::ETot] = _flag_PBKE ? out[ElocID::EPot] + out[EKinPB] : out[ElocID::EPot] + out[ElocID::EKinJF];
     }
+
+    // Walker-batched observableFunction, with SoA layout: outs[iobs*nwalkers + w] (see ElocID).
+    // Takes the wave function derivatives d1s/d2s of the walkers as computed by WaveFunction::computeAllDerivativesBatch,
+    // so it does not require a bound wave function.
+    void observableFunctionBatch(const int nwalkers, const double * xs, const double * d1s, const double * d2s, double * outs)
+    {
+        VMC_PROFILE_SCOPE(ObservableFunction);
+        double * const etot = outs + ElocID::ETot*nwalkers;
+        double * const epot = outs + ElocID::EPot*nwalkers;
+        double * const ekinpb = outs + ElocID::EKinPB*nwalkers;
+        double * const ekinjf = outs + ElocID::EKinJF*nwalkers;
+        for (int w = 0; w < nwalkers; ++w) {
+            ekinjf[w] = 0.;
+            ekinpb[w] = 0.;
+        }
+        for (int i = 0; i < _ndim; ++i) {
+            const double * const d1 = d1s + i*nwalkers;
+            const double * const d2 = d2s + i*nwalkers;
+            for (int w = 0; w < nwalkers; ++w) {
+                ekinjf[w] += d1[w]*d1[w];
+                ekinpb[w] += d2[w];
+            }
+        }
+        localPotentialEnergyBatch(nwalkers, xs, epot);
+        for (int w = 0; w < nwalkers; ++w) {
+            ekinjf[w] *= 0.5;
+            ekinpb[w] = _flag_PBKE ? -0.5*ekinpb[w] : 0.;
+            etot[w] = _flag_PBKE ? epot[w] + ekinpb[w] : epot[w] + ekinjf[w];
+        }
+    }
 };
 } // namespace vmc
 
@@ -0,0 +1,43 @@
+#ifndef VMC_HARDWARECOUNTERS_HPP
+#define VMC_HARDWARECOUNTERS_HPP
+
+#include <cstdint>
+
+namespace vmc
+{
+
+// Hardware events counted by HardwareCounters (user-space only)
+enum class HardwareEvent: int
+{
+    Cycles = 0, // CPU cycles
+    Instructions, // retired instructions
+    CacheMisses, // last level cache misses
+    BranchMisses, // mispredicted branches
+    Count // number of events
+};
+
+// Per-thread hardware performance counters, read via Linux perf_event_open
+//
+// Every thread lazily opens its own counter group on the first read() and closes it at thread exit.
+// Events which cannot be opened (no PMU, e.g. in many VMs/containers, perf_event_paranoid > 2,
+// non-Linux systems) are reported as unavailable, with a count of -1. If the kernel multiplexes
+// the counters, the counts are extrapolated to the full enabled time.
+class HardwareCounters
+{
+public:
+    static constexpr int NEVENTS = static_cast<int>(HardwareEvent::Count);
+
+    static const char * getEventName(HardwareEvent event);
+
+    // Is the event countable in the calling thread? (opens the counters, if necessary)
+    static bool isAvailable(HardwareEvent event);
+    // Is any event countable in the calling thread?
+    static bool isAvailable();
+
+    // Read the current counts of the calling thread into counts[NEVENTS] (-1 for unavailable events)
+    // Returns false if no event is available.
+    static bool read(int64_t * counts);
+};
+} // namespace vmc
+
+#endif
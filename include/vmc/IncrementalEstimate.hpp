@@ -0,0 +1,61 @@
+#ifndef VMC_INCREMENTALESTIMATE_HPP
+#define VMC_INCREMENTALESTIMATE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace vmc
+{
+
+// Combines the results of several independent MC integrations of possibly different length
+// into sample-count weighted averages and errors:
+//     avg = sum_k n_k avg_k / N,    err = sqrt( sum_k n_k^2 err_k^2 ) / N,    N = sum_k n_k
+//
+// The raw sums are kept in one contiguous buffer, so that contributions of several ranks
+// can be combined by summing up the buffers (see MPIVMC::AllreduceSum).
+class IncrementalEstimate
+{
+protected:
+    const int _nobsdim;
+    std::vector<double> _sums; // [sum n*avg (nobsdim), sum n^2*err^2 (nobsdim), N]
+
+public:
+    explicit IncrementalEstimate(int nobsdim): _nobsdim(nobsdim), _sums(2*static_cast<size_t>(nobsdim) + 1, 0.) {}
+
+    int getNObsDim() const { return _nobsdim; }
+
+    void reset() { std::fill(_sums.begin(), _sums.end(), 0.); }
+
+    // add the result of an integration over n samples
+    void add(int64_t n, const double * average, const double * error)
+    {
+        const auto dn = static_cast<double>(n);
+        for (int i = 0; i < _nobsdim; ++i) {
+            _sums[i] += dn*average[i];
+            _sums[_nobsdim + i] += dn*dn*error[i]*error[i];
+        }
+        _sums[2*_nobsdim] += dn;
+    }
+
+    int64_t getNSamples() const { return static_cast<int64_t>(_sums[2*_nobsdim]); }
+
+    double getAverage(int i) const { return (getNSamples() > 0) ? _sums[i]/_sums[2*_nobsdim] : 0.; }
+    double getError(int i) const { return (getNSamples() > 0) ? sqrt(_sums[_nobsdim + i])/_sums[2*_nobsdim] : 0.; }
+
+    void getResult(double * average, double * error) const
+    {
+        for (int i = 0; i < _nobsdim; ++i) {
+            average[i] = getAverage(i);
+            error[i] = getError(i);
+        }
+    }
+
+    // raw access to the sums buffer
+    double * getSums() { return _sums.data(); }
+    int getNSums() const { return static_cast<int>(_sums.size()); }
+};
+} // namespace vmc
+
+#endif
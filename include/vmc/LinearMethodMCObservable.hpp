@@ -0,0 +1,107 @@
+#ifndef VMC_LINEARMETHODMCOBSERVABLE_HPP
+#define VMC_LINEARMETHODMCOBSERVABLE_HPP
+
+#include "mci/ObservableFunctionInterface.hpp"
+#include "mci/DependentObservableInterface.hpp"
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/WaveFunction.hpp"
+#include "vmc/DependencyHelpers.hpp"
+
+namespace vmc
+{
+// MC Observable used to sample the Hamiltonian and overlap matrices of the Linear Method,
+// i.e. in the basis {Psi, d/dp_i Psi} of the wave function and its variational derivatives.
+//
+// The local action of H on the derivative wave functions is computed from the cross derivatives:
+//     (H d/dp_j Psi) / Psi = -0.5 * sum_i D2VD1(i, j) + V * VD1(j)
+// so the WaveFunction must provide VD1 and D2VD1.
+//
+// NOTE: Remember the necessary dependency binding just as in the case of Hamiltonian.
+class LinearMethodMCObservable: public mci::ObservableFunctionInterface, public mci::DependentObservableInterface
+{
+protected:
+    const int _nvp; // number of variational parameters (nobs will be 3*nvp + 2*nvp*nvp)
+
+    // These must be bound via registerDeps() (called by MCI) or bind methods
+    const WaveFunction * _wf = nullptr; // WaveFunction to read derivatives from
+    const double * _E = nullptr; // if set, should point to an array of len 4 where the energies are read from
+
+    mci::ObservableFunctionInterface * _clone() const final
+    {
+        return new LinearMethodMCObservable(_ndim, _nvp);
+    }
+public:
+    LinearMethodMCObservable(int ntotaldim, int nvp):
+            mci::ObservableFunctionInterface(ntotaldim, 3*nvp + 2*nvp*nvp, false),
+            mci::DependentObservableInterface(true), _nvp(nvp) {}
+
+    ~LinearMethodMCObservable() final = default;
+
+
+    // use this if you need to check whether required objects are bound (i.e. may be fully used)
+    bool isBound() const { return (_E != nullptr && _wf != nullptr); }
+
+    // Simple method to bind a wave function (e.g. for testing)
+    void bindDependencies(const double E[], WaveFunction * wf) // if any is nullptr, isBound() will be false afterwards
+    {
+        _E = E;
+        _wf = wf;
+    }
+
+    // Methods to register/deregister WaveFunction/Hamiltonian dependency (called by MCI)
+    void registerDeps(const mci::SamplingFunctionContainer &pdfcont, const std::vector<mci::AccumulatorInterface *> &accus, int selfIdx) final
+    {
+        // use dependency helpers
+        _E = fetchEnergyDep<Hamiltonian>(accus, selfIdx, "LinearMethodMCObservable::registerDeps");
+        _wf = fetchWaveFunctionDep<WaveFunction>(pdfcont, "LinearMethodMCObservable::registerDeps");
+    }
+
+    void deregisterDeps() final
+    {
+        _E = nullptr;
+        _wf = nullptr;
+    }
+
+    // mci::ObservableFunctionInterface implementation
+    void observableFunction(const double * in, double * out) final
+    {
+        VMC_PROFILE_SCOPE(ObservableFunction);
+        // out is made in this way (nvp is the number of variational parameters):
+        // out[0:nvp-1] = Oi
+        // out[nvp:2*nvp-1] = HOi
+        // out[2*nvp:3*nvp-1] = HDi    where HDi = (H d/dp_i Psi) / Psi
+        // out[3*nvp:3*nvp+nvp*nvp-1] = OiOj    according to the rule OiOj[i, j] = OiOj[j + i*nvp]
+        // out[3*nvp+nvp*nvp:3*nvp+2*nvp*nvp-1] = OiHDj    according to the rule OiHDj[i, j] = OiHDj[j + i*nvp]
+
+        // local energies
+        const double Hloc = _E[ElocID::ETot]; // use enum integer to get total energy
+        const double Vloc = _E[ElocID::EPot];
+
+        double * const Oi = out;
+        double * const HOi = out + _nvp;
+        double * const HDi = out + 2*_nvp;
+        double * const OiOj = out + 3*_nvp;
+        double * const OiHDj = out + 3*_nvp + _nvp*_nvp;
+
+        // store the elements Oi, HOi and HDi
+        for (int i = 0; i < _nvp; ++i) {
+            Oi[i] = _wf->getVD1DivByWF(i);
+            HOi[i] = Hloc*Oi[i];
+            double lap = 0.;
+            for (int id = 0; id < _ndim; ++id) {
+                lap += _wf->getD2VD1DivByWF(id, i);
+            }
+            HDi[i] = -0.5*lap + Vloc*Oi[i];
+        }
+        // store the elements OiOj and OiHDj
+        for (int i = 0; i < _nvp; ++i) {
+            for (int j = 0; j < _nvp; ++j) {
+                OiOj[i*_nvp + j] = Oi[i]*Oi[j];
+                OiHDj[i*_nvp + j] = Oi[i]*HDi[j];
+            }
+        }
+    }
+};
+} // namespace vmc
+
+#endif
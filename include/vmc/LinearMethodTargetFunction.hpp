@@ -0,0 +1,37 @@
+#ifndef VMC_LINEARMETHODTARGETFUNCTION_HPP
+#define VMC_LINEARMETHODTARGETFUNCTION_HPP
+
+#include "vmc/VMCTargetFunction.hpp"
+
+namespace vmc
+{
+
+// Target function for the Linear Method (Toulouse & Umrigar, J. Chem. Phys. 126, 084102 (2007))
+//
+// The Hamiltonian and overlap matrices in the basis {Psi, d/dp_i Psi} are sampled and the stabilized
+// generalized eigenproblem H c = E S c is solved. The "gradient" returned to the optimizer is the
+// Linear Method parameter update dp_i = c_i / c_0, so that a plain descent step of size 1 reproduces
+// the pure Linear Method (like in the SR case, the direction is sign-compatible with the other gradients).
+// Requires a WaveFunction providing the VD1 and D2VD1 derivatives.
+class LinearMethodTargetFunction: public VMCTargetFunction
+{
+protected:
+    const double _stabilization; // shift added to the diagonal of the derivative block of H
+
+    void _integrate(const double * vp, double * obs, double * dobs, bool flag_grad = false, bool flag_dgrad = false);
+    void _calcObs(const double * vp, double &f, double &df, double * grad_E = nullptr, double * dgrad_E = nullptr);
+public:
+    LinearMethodTargetFunction(VMC &vmc, int64_t E_Nmc, int64_t grad_E_Nmc, bool useGradErr, double lambda_reg = 0., double stabilization = 0.);
+
+    ~LinearMethodTargetFunction() final = default;
+
+    double getStabilization() const { return _stabilization; }
+
+    // NoisyFunctionWithGradient implementation
+    nfm::NoisyValue f(const std::vector<double> &vp) final;
+    void grad(const std::vector<double> &vp, nfm::NoisyGradient &grad) final;
+    nfm::NoisyValue fgrad(const std::vector<double> &vp, nfm::NoisyGradient &grad) final;
+};
+} // namespace vmc
+
+#endif
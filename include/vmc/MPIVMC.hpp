@@ -3,9 +3,23 @@
 
 #include "mci/MCIntegrator.hpp"
 #include "mci/MPIMCI.hpp"
+#include "vmc/IncrementalEstimate.hpp"
+#include "vmc/Philox.hpp"
+#include "vmc/Profiler.hpp"
+#include "vmc/Tracer.hpp"
 
+#if USE_MPI == 1
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace MPIVMC
 {
@@ -36,6 +50,7 @@ inline int Init()
 #endif
 }
 
+// Seed the MCI of this rank from a seed file (see MPIMCI::setSeed), prefer the overload below
 inline void SetSeed(mci::MCI &mci, const std::string &filename, int offset = 0)
 {
 #if USE_MPI == 1
@@ -46,8 +61,21 @@ inline void SetSeed(mci::MCI &mci, const std::string &filename, int offset = 0)
 #endif
 }
 
+// Seed the MCI of this rank (and thread) from a single run seed, without seed file
+// The MCI seed is drawn from the counter-based Philox stream keyed by (seed, rank, thread),
+// so it is reproducible and independent of the other ranks/threads.
+// NOTE: MCI still draws its moves from its own internal generator, so a run is only reproduced with
+// the same number of ranks/threads. Results independent of the work split require sampling directly
+// from Philox streams keyed on global walker indices (see Philox and ConfigurationSampler).
+inline void SetSeed(mci::MCI &mci, uint64_t seed, int thread = 0)
+{
+    vmc::Philox rng(seed, vmc::Philox::streamID(MyRank(), thread));
+    mci.setSeed(rng());
+}
+
 inline void Integrate(mci::MCI &mci, int64_t Nmc, double * average, double * error, bool findMRT2step = true, bool initialdecorrelation = true, bool randomizeWalkers = false)
 {
+    VMC_PROFILE_SCOPE(Integrate);
     if (randomizeWalkers) { mci.newRandomX(); }
 #if USE_MPI == 1
     MPIMCI::integrate(mci, Nmc, average, error, findMRT2step, initialdecorrelation);
@@ -56,8 +84,305 @@ inline void Integrate(mci::MCI &mci, int64_t Nmc, double * average, double * err
 #endif
 }
 
+// Like Integrate (Nmc is split among the ranks), but the results of the ranks are combined by a non-blocking
+// reduction (MPI_Iallreduce). While the reduction is in flight, overlapWork() is called repeatedly until it
+// completed, e.g. to keep sampling/decorrelating the walkers instead of idling in the reduction.
+// overlapWork must not touch average/error.
+// Returns the number of overlapWork() calls (always 0 without MPI, where nothing needs to be reduced).
+inline int IntegrateOverlapped(mci::MCI &mci, int64_t Nmc, double * average, double * error, const std::function<void()> &overlapWork,
+                               bool findMRT2step = true, bool initialdecorrelation = true)
+{
+#if USE_MPI == 1
+    const int size = Size();
+    const int nobsdim = mci.getNObsDim();
+    {
+        VMC_PROFILE_SCOPE(Integrate);
+        mci.integrate(Nmc/size, average, error, findMRT2step, initialdecorrelation);
+    }
+
+    // combine means and (independent) errors of all ranks
+    std::vector<double> buf(2*static_cast<size_t>(nobsdim));
+    for (int i = 0; i < nobsdim; ++i) {
+        buf[i] = average[i];
+        buf[nobsdim + i] = error[i]*error[i];
+    }
+    MPI_Request request;
+    int done = 0, ncalls = 0;
+    {
+        VMC_PROFILE_SCOPE(MPIReduce);
+        MPI_Iallreduce(MPI_IN_PLACE, buf.data(), 2*nobsdim, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &request);
+    }
+    while (true) {
+        {
+            VMC_PROFILE_SCOPE(MPIReduce);
+            MPI_Test(&request, &done, MPI_STATUS_IGNORE); // also drives the progress of the reduction
+        }
+        if (done != 0) { break; }
+        if (!overlapWork) { // nothing to do meanwhile
+            VMC_PROFILE_SCOPE(MPIReduce);
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+            break;
+        }
+        overlapWork();
+        ++ncalls;
+    }
+    for (int i = 0; i < nobsdim; ++i) {
+        average[i] = buf[i]/size;
+        error[i] = sqrt(buf[nobsdim + i])/size;
+    }
+    return ncalls;
+#else
+    (void) overlapWork;
+    Integrate(mci, Nmc, average, error, findMRT2step, initialdecorrelation);
+    return 0;
+#endif
+}
+
+#if USE_MPI == 1
+// Split MPI_COMM_WORLD into ngroups groups of contiguous ranks (ngroups is clamped to [1, Size()])
+// Returns the group communicator (to be freed by the caller) and sets groupid and the actual ngroups.
+inline MPI_Comm SplitGroups(int &ngroups, int &groupid)
+{
+    ngroups = std::max(1, std::min(ngroups, Size()));
+    groupid = (MyRank()*ngroups)/Size();
+    MPI_Comm comm;
+    MPI_Comm_split(MPI_COMM_WORLD, groupid, MyRank(), &comm);
+    return comm;
+}
+
+// Like Integrate, but only over the ranks in comm (Nmc is split among them)
+inline void IntegrateOnComm(mci::MCI &mci, MPI_Comm comm, int64_t Nmc, double * average, double * error, bool findMRT2step = true, bool initialdecorrelation = true)
+{
+    int size;
+    MPI_Comm_size(comm, &size);
+    const int nobsdim = mci.getNObsDim();
+    {
+        VMC_PROFILE_SCOPE(Integrate);
+        mci.integrate(Nmc/size, average, error, findMRT2step, initialdecorrelation);
+    }
+
+    // combine means and (independent) errors of all ranks
+    std::vector<double> buf(2*static_cast<size_t>(nobsdim));
+    for (int i = 0; i < nobsdim; ++i) {
+        buf[i] = average[i];
+        buf[nobsdim + i] = error[i]*error[i];
+    }
+    {
+        VMC_PROFILE_SCOPE(MPIReduce);
+        MPI_Allreduce(MPI_IN_PLACE, buf.data(), 2*nobsdim, MPI_DOUBLE, MPI_SUM, comm);
+    }
+    for (int i = 0; i < nobsdim; ++i) {
+        average[i] = buf[i]/size;
+        error[i] = sqrt(buf[nobsdim + i])/size;
+    }
+}
+#endif
+
+// Combine the results of independent integrations on all ranks (in-place), like Integrate does: the averages
+// are averaged and the errors are combined as independent. Only the first ndouble values (all if negative) are
+// reduced in double precision, the others are rounded to float32 (also with a single rank), which halves their
+// reduction volume. Meant for large arrays whose statistical errors by far exceed the float32 precision,
+// e.g. O_i*O_j in SR, while the energies stay in double precision.
+inline void ReduceResults(double * average, double * error, int n, int ndouble = -1)
+{
+    ndouble = (ndouble < 0 || ndouble > n) ? n : ndouble;
+    const int nfloat = n - ndouble;
+    const int size = Size();
+    std::vector<double> dbuf(2*static_cast<size_t>(ndouble));
+    std::vector<float> fbuf(2*static_cast<size_t>(nfloat));
+    for (int i = 0; i < ndouble; ++i) {
+        dbuf[i] = average[i];
+        dbuf[ndouble + i] = error[i]*error[i];
+    }
+    for (int i = 0; i < nfloat; ++i) {
+        fbuf[i] = static_cast<float>(average[ndouble + i]);
+        fbuf[nfloat + i] = static_cast<float>(error[ndouble + i]*error[ndouble + i]);
+    }
+#if USE_MPI == 1
+    {
+        VMC_PROFILE_SCOPE(MPIReduce);
+        MPI_Allreduce(MPI_IN_PLACE, dbuf.data(), 2*ndouble, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        if (nfloat > 0) { MPI_Allreduce(MPI_IN_PLACE, fbuf.data(), 2*nfloat, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD); }
+    }
+#endif
+    for (int i = 0; i < ndouble; ++i) {
+        average[i] = dbuf[i]/size;
+        error[i] = sqrt(dbuf[ndouble + i])/size;
+    }
+    for (int i = 0; i < nfloat; ++i) {
+        average[ndouble + i] = static_cast<double>(fbuf[i])/size;
+        error[ndouble + i] = sqrt(static_cast<double>(fbuf[nfloat + i]))/size;
+    }
+}
+
+// Sum up the n values of data (in-place) over all ranks
+inline void AllreduceSum(double * data, int n)
+{
+#if USE_MPI == 1
+    VMC_PROFILE_SCOPE(MPIReduce);
+    MPI_Allreduce(MPI_IN_PLACE, data, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#else
+    (void) data; // nothing to do
+    (void) n;
+#endif
+}
+
+// Balanced partition of n rows into Size() contiguous blocks: the rows of rank r are [offsets[r], offsets[r+1])
+inline std::vector<int> RowOffsets(int n)
+{
+    const int size = Size();
+    std::vector<int> offsets(static_cast<size_t>(size) + 1);
+    for (int r = 0; r <= size; ++r) { offsets[r] = static_cast<int>(static_cast<int64_t>(n)*r/size); }
+    return offsets;
+}
+
+// Sum up the row-major nrows x ncols array data over all ranks, but store only the row block of this rank
+// (see RowOffsets) into result. Moves nrows*ncols/Size() values per rank, instead of nrows*ncols for AllreduceSum.
+// If singlePrecision is true, the values are rounded to float32 before the reduction (also with a single rank,
+// so results do not depend on the number of ranks), halving the volume again (see ReduceResults).
+inline void ReduceScatterRows(const double * data, int nrows, int ncols, double * result, bool singlePrecision = false)
+{
+    const std::vector<int> offsets = RowOffsets(nrows);
+    const int myrank = MyRank();
+    const size_t ndata = static_cast<size_t>(nrows)*ncols;
+    const size_t nresult = static_cast<size_t>(offsets[myrank + 1] - offsets[myrank])*ncols;
+#if USE_MPI == 1
+    std::vector<int> counts(offsets.size() - 1);
+    for (size_t r = 0; r < counts.size(); ++r) { counts[r] = (offsets[r + 1] - offsets[r])*ncols; }
+    if (singlePrecision) {
+        const std::vector<float> fdata(data, data + ndata);
+        std::vector<float> fresult(nresult);
+        {
+            VMC_PROFILE_SCOPE(MPIReduce);
+            MPI_Reduce_scatter(fdata.data(), fresult.data(), counts.data(), MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+        }
+        std::copy(fresult.begin(), fresult.end(), result);
+    }
+    else {
+        VMC_PROFILE_SCOPE(MPIReduce);
+        MPI_Reduce_scatter(data, result, counts.data(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    }
+#else
+    (void) ndata;
+    const double * const rows = data + static_cast<size_t>(offsets[myrank])*ncols;
+    for (size_t i = 0; i < nresult; ++i) { result[i] = singlePrecision ? static_cast<float>(rows[i]) : rows[i]; }
+#endif
+}
+
+// Gather the row blocks (see RowOffsets) of all ranks into the full row-major nrows x ncols array data
+inline void AllgatherRows(const double * local, int nrows, int ncols, double * data)
+{
+#if USE_MPI == 1
+    const std::vector<int> offsets = RowOffsets(nrows);
+    std::vector<int> counts(offsets.size() - 1), displs(offsets.size() - 1);
+    for (size_t r = 0; r < counts.size(); ++r) {
+        counts[r] = (offsets[r + 1] - offsets[r])*ncols;
+        displs[r] = offsets[r]*ncols;
+    }
+    VMC_PROFILE_SCOPE(MPIReduce);
+    MPI_Allgatherv(local, counts[MyRank()], MPI_DOUBLE, data, counts.data(), displs.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+#else
+    std::copy(local, local + static_cast<size_t>(nrows)*ncols, data);
+#endif
+}
+
+// Target-error adaptive integration
+//
+// Integrates in increments (the first one of Ninit steps) until errorFunction(average, error) of the
+// combined estimate is at most targetError, or Nmax steps have been used in total. Every increment uses the
+// blocking error estimates of MCI and all increments are combined with sample-count weights. The size of the
+// next increment is extrapolated from the current error (assuming error ~ 1/sqrt(N)), but is at least Ninit.
+// Only the first increment performs findMRT2step/initialdecorrelation, if requested.
+// Returns the total number of steps used.
+inline int64_t IntegrateAdaptive(mci::MCI &mci, int64_t Ninit, int64_t Nmax, double targetError, double * average, double * error,
+                                 const std::function<double(const double *, const double *)> &errorFunction,
+                                 bool findMRT2step = true, bool initialdecorrelation = true)
+{
+    vmc::IncrementalEstimate est(mci.getNObsDim());
+    int64_t Ninc = std::min(Ninit, Nmax);
+    bool first = true;
+    while (Ninc > 0) {
+        Integrate(mci, Ninc, average, error, first && findMRT2step, first && initialdecorrelation);
+        first = false;
+        est.add(Ninc, average, error);
+        est.getResult(average, error);
+
+        const double err = errorFunction(average, error);
+        const int64_t N = est.getNSamples();
+        if (err <= targetError || N >= Nmax) { break; }
+
+        // extrapolate the remaining steps (with 10% margin)
+        const double ratio = err/targetError;
+        const auto Nneeded = static_cast<int64_t>(1.1*ratio*ratio*N);
+        Ninc = std::min(std::max(Nneeded - N, Ninit), Nmax - N);
+    }
+    return est.getNSamples();
+}
+
+// Same as above, with the error of the observable with index errorIndex as error measure
+inline int64_t IntegrateAdaptive(mci::MCI &mci, int64_t Ninit, int64_t Nmax, double targetError, double * average, double * error,
+                                 int errorIndex = 0, bool findMRT2step = true, bool initialdecorrelation = true)
+{
+    return IntegrateAdaptive(mci, Ninit, Nmax, targetError, average, error,
+                             [errorIndex](const double *, const double * err) { return err[errorIndex]; },
+                             findMRT2step, initialdecorrelation);
+}
+
+// Wall-clock budgeted integration, for ranks of heterogeneous speed
+//
+// Every rank integrates in chunks of Nchunk steps until the time budget (in seconds) is used up,
+// so that fast ranks contribute more samples instead of idling at the final reduction. The results
+// of all chunks and ranks are combined with sample-count weights. The budget is checked after every
+// chunk, so Nchunk should be small enough to take only a fraction of the budget.
+// If targetError > 0, the ranks synchronize every checkInterval seconds and stop early as soon as
+// the combined error of the first observable (i.e. the total energy in VMC) is below targetError.
+// Returns the total number of samples (over all ranks).
+inline int64_t IntegrateTimed(mci::MCI &mci, double budget, int64_t Nchunk, double * average, double * error,
+                              double targetError = 0., double checkInterval = 1., bool findMRT2step = true, bool initialdecorrelation = true)
+{
+    using clock = std::chrono::steady_clock;
+    const auto tstart = clock::now();
+    const auto elapsed = [&tstart]() { return std::chrono::duration<double>(clock::now() - tstart).count(); };
+
+    const int nobsdim = mci.getNObsDim();
+    vmc::IncrementalEstimate local(nobsdim); // chunks of this rank
+    vmc::IncrementalEstimate global(nobsdim); // chunks of all ranks
+    double avg_h[nobsdim], err_h[nobsdim];
+
+    const double slice = (targetError > 0.) ? std::min(checkInterval, budget) : budget;
+    double tend = slice;
+    bool first = true;
+    while (true) {
+        do { // sample chunks until the end of the current time slice (at least one)
+            mci.integrate(Nchunk, avg_h, err_h, first && findMRT2step, first && initialdecorrelation);
+            first = false;
+            local.add(Nchunk, avg_h, err_h);
+        } while (elapsed() < tend);
+
+        std::copy(local.getSums(), local.getSums() + local.getNSums(), global.getSums());
+        AllreduceSum(global.getSums(), global.getNSums());
+        if (targetError <= 0. || global.getError(0) <= targetError) { break; }
+
+        double outoftime = (elapsed() >= budget) ? 1. : 0.;
+        AllreduceSum(&outoftime, 1); // make sure all ranks take the same decision
+        if (outoftime > 0.) { break; }
+        tend = std::min(tend + slice, budget);
+    }
+
+    global.getResult(average, error);
+    return global.getNSamples();
+}
+
+// Finalize MPI (writes the trace file first, if vmc::Tracer was started)
+// A failure to write the trace is only reported on std::cerr, such that MPI is always finalized.
 inline void Finalize()
 {
+    try {
+        vmc::Tracer::finalize();
+    }
+    catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+    }
 #if USE_MPI == 1
     MPIMCI::finalize();
 #endif
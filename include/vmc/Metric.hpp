@@ -1,6 +1,8 @@
 #ifndef VMC_METRIC_HPP
 #define VMC_METRIC_HPP
 
+#include <memory>
+
 namespace vmc
 {
 
@@ -11,17 +13,33 @@ protected:
 
     explicit Metric(int nspacedim): _nspacedim(nspacedim) {}
 
+    // return a new independent copy of the metric (with own scratch memory)
+    virtual Metric * _clone() const = 0;    // --- MUST BE IMPLEMENTED
+
 public:
     virtual ~Metric() = default;
 
     int getNSpaceDim() const { return _nspacedim; }
 
+    std::unique_ptr<Metric> clone() const { return std::unique_ptr<Metric>(_clone()); }
+
     // --- Methods that must be implemented
     virtual double dist(const double * r1, const double * r2) = 0;
 
     virtual void distD1(const double * r1, const double * r2, double * out) = 0;
 
     virtual void distD2(const double * r1, const double * r2, double * out) = 0;
+
+
+    // --- Walker-batched versions for n pairs of points at once
+    // SoA layout: coordinate i of the k-th point is r1s[i*n + k], outputs are out[k] (dist) or
+    // out[i*n + k] for i < 2*nspacedim (D1, D2). The defaults loop over the methods above,
+    // derived metrics may override them to vectorize across the n points.
+    virtual void distBatch(int n, const double * r1s, const double * r2s, double * out);
+
+    virtual void distD1Batch(int n, const double * r1s, const double * r2s, double * out);
+
+    virtual void distD2Batch(int n, const double * r1s, const double * r2s, double * out);
 };
 } // namespace vmc
 
@@ -4,6 +4,7 @@
 
 #include "vmc/WaveFunction.hpp"
 
+#include <memory>
 #include <vector>
 
 namespace vmc
@@ -13,12 +14,13 @@ class MultiComponentWaveFunction final: public WaveFunction
 {
 private:
     std::vector<WaveFunction *> _wfs;
+    std::vector<std::unique_ptr<WaveFunction>> _ownedWFs; // components we own (e.g. on clones)
 
     mci::SamplingFunctionInterface * _clone() const final
-    {
+    { // deep copy, the clone owns copies of the components
         auto newwf = new MultiComponentWaveFunction(_nspacedim, _npart, _flag_vd1, _flag_d1vd1, _flag_d2vd1);
         for (auto &wf : _wfs) {
-            newwf->addWaveFunction(wf);
+            newwf->addWaveFunction(wf->cloneWaveFunction());
         }
         return newwf;
     }
@@ -37,6 +39,8 @@ public:
 
 
     void addWaveFunction(WaveFunction * wf);
+    // add a component and take ownership of it
+    void addWaveFunction(std::unique_ptr<WaveFunction> wf);
 
     void setVP(const double vp[]) final;
 
@@ -1,7 +1,9 @@
 #ifndef VMC_NMSIMPLEXMINIMIZATION_HPP
 #define VMC_NMSIMPLEXMINIMIZATION_HPP
 
+#include "vmc/Checkpoint.hpp"
 #include "vmc/VMC.hpp"
+#include "vmc/OptimizerTelemetry.hpp"
 
 namespace vmc
 {
@@ -13,6 +15,12 @@ protected:
     const double _iota, _kappa, _lambda;
     const double _rstart, _rend;
     const size_t _max_n_iter;
+    int _ngroups = 1; // number of rank groups evaluating simplex points concurrently
+    OptimizerTelemetry * _telemetry = nullptr; // optional per-iteration records
+    OptimizerCheckpoint * _checkpoint = nullptr; // optional periodic checkpoints
+
+    void _minimizeEnergyGSL(VMC &vmc);
+    void _minimizeEnergyBatched(VMC &vmc);
 public:
     NMSimplexMinimization(int64_t Nmc, double iota, double kappa, double lambda, double rstart = 1.0, double rend = 0.01, size_t max_n_iter = 0):
             _Nmc(Nmc), _iota(iota), _kappa(kappa), _lambda(lambda), _rstart(rstart), _rend(rend), _max_n_iter(static_cast<size_t>(max_n_iter)) {}
@@ -25,6 +33,24 @@ public:
     double getREnd() { return _rend; }
     size_t getMaxNIter() { return _max_n_iter; }
 
+    // Parallel simplex-vertex evaluation: With ngroups > 1, the MPI ranks are split into ngroups groups
+    // and a batched Nelder-Mead variant is used, which evaluates the initial vertices, the reflection/
+    // expansion/contraction candidates and shrink steps concurrently (each point on one group, with Nmc
+    // split among the group's ranks). Without MPI the batches are evaluated one after another.
+    // In both modes the simplex size compared to rend is the rms distance of the vertices from their center.
+    void setNGroups(int ngroups) { _ngroups = ngroups; }
+    int getNGroups() { return _ngroups; }
+
+    // Stream a telemetry record for every iteration to telemetry (nullptr disables it, the default)
+    // The record contains the best vertex and its cost as f, the simplex size and the MC steps used.
+    void setTelemetry(OptimizerTelemetry * telemetry) { _telemetry = telemetry; }
+
+    // Write a checkpoint every checkpoint->getInterval() iterations (nullptr disables it, the default)
+    // and resume from the checkpoint file, if it exists when minimizeEnergy() is called. The batched mode stores
+    // and restores the whole simplex, the GSL mode only the best vertex (around which a new simplex is started).
+    // In both modes the iteration count continues, i.e. max_n_iter applies to the total over all runs.
+    void setCheckpoint(OptimizerCheckpoint * checkpoint) { _checkpoint = checkpoint; }
+
     // optimization
     void minimizeEnergy(VMC &vmc);
 };
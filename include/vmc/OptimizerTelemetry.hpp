@@ -0,0 +1,74 @@
+#ifndef VMC_OPTIMIZERTELEMETRY_HPP
+#define VMC_OPTIMIZERTELEMETRY_HPP
+
+#include "vmc/Profiler.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vmc
+{
+
+// One telemetry record, i.e. one target function evaluation (gradient-based optimizers) or one iteration
+// (NMSimplexMinimization). Values which were not computed are NaN and written as null.
+struct TelemetryRecord
+{
+    std::string optimizer; // "gradient", "sr", "lm" or "nmsimplex"
+    std::string kind; // "f", "grad", "fgrad" (target function evaluations) or "iteration"
+    std::vector<double> vp; // variational parameters (NM simplex: best vertex)
+    double f = std::numeric_limits<double>::quiet_NaN(); // target value (energy, incl. regularization / NM simplex cost)
+    double df = std::numeric_limits<double>::quiet_NaN(); // its error
+    double gradNorm = std::numeric_limits<double>::quiet_NaN(); // norm of the gradient (SR/LM: of the update direction)
+    double dgradNorm = std::numeric_limits<double>::quiet_NaN(); // norm of the gradient error vector
+    int64_t nmc = 0; // MC steps used
+    double acceptance = std::numeric_limits<double>::quiet_NaN(); // acceptance rate of the last integration
+    double srCondition = std::numeric_limits<double>::quiet_NaN(); // condition number of the SR matrix S_ij
+    double simplexSize = std::numeric_limits<double>::quiet_NaN(); // NM simplex size
+    double seconds = 0.; // wall time of the evaluation/iteration
+    std::vector<std::pair<std::string, double>> phases; // wall time per profiler phase (only with USE_PROFILING=1)
+
+    std::string toJSON(int64_t iter) const;
+};
+
+
+// Per-iteration optimizer telemetry, streamed as JSON lines (one record per line) to a file
+//
+// Pass a pointer to the minimizers (minimizeEnergy<GradT>(..., &telemetry) or NMSimplexMinimization::setTelemetry)
+// to record every evaluation/iteration, e.g. to tune Nmc schedules or detect stalls. Only rank 0 writes, but
+// all ranks must call the same methods. For the gradient-based optimizers of NoisyFunMin, which do not expose
+// their iterations, every target function evaluation is a record (usually one "fgrad" per iteration).
+//
+// Usage by the minimizers: begin(optimizer, kind), set fields of current(), end(). The record
+// counter "iter" starts at 0 and the file is flushed after every record.
+class OptimizerTelemetry
+{
+private:
+    std::ofstream _file;
+    const bool _isWriter; // only rank 0 writes
+    int64_t _nrecords = 0;
+
+    TelemetryRecord _current;
+    std::chrono::steady_clock::time_point _start;
+    ProfileReport _profileStart;
+
+public:
+    explicit OptimizerTelemetry(const std::string &filename, bool append = false);
+
+    int64_t getNRecords() const { return _nrecords; }
+
+    // start a new record (starts the timer)
+    void begin(const std::string &optimizer, const std::string &kind);
+    TelemetryRecord &current() { return _current; }
+    // set vp, f/df and the norms of grad/dgrad (of size nvp, may be nullptr) of the current record
+    void setResult(const double * vp, int nvp, double f, double df, const double * grad = nullptr, const double * dgrad = nullptr);
+    // finish and write the current record
+    void end();
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef VMC_PARAMETERSCAN_HPP
+#define VMC_PARAMETERSCAN_HPP
+
+#include "vmc/VMC.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vmc
+{
+
+// Result of one point of a ParameterScan
+struct ScanResult
+{
+    std::vector<double> vp; // variational parameters of the point
+    double E[4]{}; // energies in the layout of VMC::computeEnergy()
+    double dE[4]{}; // and their errors
+    int rank = 0; // rank and thread which evaluated the point
+    int thread = 0;
+    bool warm = false; // started from the walkers of the previous point
+};
+
+// Energy scan over a list of variational parameter vectors, e.g. 1D curves or 2D parameter landscapes
+//
+// The points are grouped into chains of chainLength consecutive points (see setWarmStart()), which are split into
+// contiguous blocks over the ranks, and the threads of every rank take the chains of its block one at a time.
+// Every thread samples with its own VMC, on clones of the prototype VMC's wave function and Hamiltonian.
+// The first point of a chain starts cold (random walkers, the prototype's MRT2 step sizes, findMRT2step and
+// decorrelation), while the following points reuse the walkers and step sizes of the preceding point (warm start)
+// and only decorrelate for a fraction of the decorrelation steps. So consecutive points should be neighbors in
+// parameter space, as produced by makeGrid(). Every point is integrated with Nmc steps by one thread (there is no
+// reduction over ranks) and with a random stream keyed on the point index, so the results do not depend on the
+// scheduling, nor on the number of threads and ranks.
+//
+// Results are streamed to a file (if set) as soon as they are available, one line per point:
+//     ipoint vp[0] ... vp[nvp-1] E[0] dE[0] ... E[3] dE[3]
+// With more than one rank, every rank writes its own file with the rank appended (filename.rank).
+class ParameterScan
+{
+public:
+    using SetupFunction = std::function<void(VMC &vmc)>;
+
+protected:
+    VMC &_vmc; // prototype, only used to create the per-thread VMCs
+    const int64_t _Nmc; // MC steps per point
+    int _nthreads;
+    uint64_t _seed = 0;
+    bool _warmstart = true;
+    int _chainLength = 8; // points per chain of warm starts
+    double _warmFraction = 0.1; // fraction of the decorrelation steps on warm starts
+    std::string _filename; // empty: no output file
+    SetupFunction _setup; // optional extra setup of every per-thread VMC
+
+public:
+    ParameterScan(VMC &vmc, int64_t Nmc, int nthreads = 0); // nthreads = 0: hardware concurrency
+
+    // Settings
+    void setNThreads(int nthreads); // 0 for hardware concurrency
+    int getNThreads() const { return _nthreads; }
+    void setSeed(uint64_t seed) { _seed = seed; }
+    uint64_t getSeed() const { return _seed; }
+    // Enable warm starts (default) in chains of chainLength points, decorrelating for warmFraction of the
+    // decorrelation steps. Longer chains save more equilibration, shorter ones balance the threads better.
+    void setWarmStart(bool warmstart, int chainLength = 8, double warmFraction = 0.1);
+    bool getWarmStart() const { return _warmstart; }
+    int getChainLength() const { return _chainLength; }
+    double getWarmFraction() const { return _warmFraction; }
+    void setOutputFile(const std::string &filename) { _filename = filename; }
+    const std::string &getOutputFile() const { return _filename; }
+
+    // The per-thread VMCs copy the number of findMRT2step iterations, decorrelation steps and the MRT2 step sizes
+    // of the prototype's MCI. Everything else (e.g. the trial move type) may be set up by this function, which
+    // is called once for every per-thread VMC.
+    void setSetupFunction(const SetupFunction &setup) { _setup = setup; }
+
+    // Scan the energy at all points (collective with MPI), every vp vector must have getNVP() elements.
+    // Returns the results of all points (on all ranks), in the order of vps.
+    std::vector<ScanResult> run(const std::vector<std::vector<double>> &vps);
+
+    // Cartesian grid of the values of every axis (one axis per variational parameter), in serpentine order:
+    // the last axis runs fastest and changes direction at every step of the previous ones, so that
+    // consecutive points always differ in a single parameter by one grid step.
+    static std::vector<std::vector<double>> makeGrid(const std::vector<std::vector<double>> &axes);
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef VMC_PHILOX_HPP
+#define VMC_PHILOX_HPP
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace vmc
+{
+
+// Counter-based random number generator Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11)
+//
+// The n-th random number of a stream is a pure function of (seed, stream, n): a 128-bit counter built from the
+// stream id and the block index n/2 is encrypted with the 64-bit seed as key. Hence every (seed, stream) pair
+// gives an independent, reproducible sequence without any state besides the counter, and skipping ahead is O(1).
+// Use streamID() to key streams on (rank, thread, walker). For results that don't depend on how the work is
+// split over ranks and threads, key the streams on a global walker index only, i.e. streamID(0, 0, walker).
+//
+// Satisfies the UniformRandomBitGenerator requirements, i.e. it can be used with the std:: distributions.
+class Philox
+{
+public:
+    using result_type = uint64_t;
+
+protected:
+    uint64_t _seed; // key
+    uint64_t _stream; // upper 64 bits of the counter
+    uint64_t _block = 0; // lower 64 bits of the counter (index of the next block)
+    uint32_t _out[4] = {0, 0, 0, 0}; // current output block
+    int _pos = 2; // next unused 64-bit word of _out (2 = block exhausted)
+
+    static void _mulhilo(const uint32_t a, const uint32_t b, uint32_t &hi, uint32_t &lo)
+    {
+        const uint64_t prod = static_cast<uint64_t>(a)*b;
+        hi = static_cast<uint32_t>(prod >> 32);
+        lo = static_cast<uint32_t>(prod);
+    }
+
+    void _generateBlock()
+    {
+        uint32_t c[4] = {static_cast<uint32_t>(_block), static_cast<uint32_t>(_block >> 32),
+                         static_cast<uint32_t>(_stream), static_cast<uint32_t>(_stream >> 32)};
+        uint32_t k[2] = {static_cast<uint32_t>(_seed), static_cast<uint32_t>(_seed >> 32)};
+        for (int r = 0; r < 10; ++r) {
+            uint32_t hi0, lo0, hi1, lo1;
+            _mulhilo(0xD2511F53u, c[0], hi0, lo0);
+            _mulhilo(0xCD9E8D57u, c[2], hi1, lo1);
+            c[0] = hi1 ^ c[1] ^ k[0];
+            c[1] = lo1;
+            c[2] = hi0 ^ c[3] ^ k[1];
+            c[3] = lo0;
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        for (int i = 0; i < 4; ++i) { _out[i] = c[i]; }
+        ++_block;
+        _pos = 0;
+    }
+
+public:
+    explicit Philox(const uint64_t seed = 0, const uint64_t stream = 0): _seed(seed), _stream(stream) {}
+
+    // Pack (rank, thread, walker) into a stream id (rank < 2^24, thread < 2^16, walker < 2^24)
+    static uint64_t streamID(const int64_t rank, const int64_t thread = 0, const int64_t walker = 0)
+    {
+        if (rank < 0 || rank >= (1ll << 24) || thread < 0 || thread >= (1ll << 16) || walker < 0 || walker >= (1ll << 24)) {
+            throw std::invalid_argument("[Philox::streamID] rank, thread or walker index out of range.");
+        }
+        return (static_cast<uint64_t>(rank) << 40) | (static_cast<uint64_t>(thread) << 24) | static_cast<uint64_t>(walker);
+    }
+
+    // restart at the beginning of the (seed, stream) sequence
+    void seed(const uint64_t seed, const uint64_t stream = 0)
+    {
+        _seed = seed;
+        _stream = stream;
+        _block = 0;
+        _pos = 2;
+    }
+
+    uint64_t getSeed() const { return _seed; }
+    uint64_t getStream() const { return _stream; }
+    uint64_t getPosition() const { return 2*_block - (2 - _pos); } // number of values drawn so far
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        if (_pos == 2) { _generateBlock(); }
+        const result_type val = (static_cast<uint64_t>(_out[2*_pos + 1]) << 32) | _out[2*_pos];
+        ++_pos;
+        return val;
+    }
+
+    // skip the next n values
+    void discard(const uint64_t n)
+    {
+        const uint64_t pos = this->getPosition() + n;
+        _block = pos/2;
+        _pos = 2;
+        if (pos%2 == 1) { // regenerate the current block and skip its first word
+            _generateBlock();
+            _pos = 1;
+        }
+    }
+
+    // access the raw 4x32 bit block of a given counter (e.g. for known-answer tests)
+    static void block(const uint64_t seed, const uint64_t stream, const uint64_t block, uint32_t * out)
+    {
+        Philox rng(seed, stream);
+        rng._block = block;
+        rng._generateBlock();
+        for (int i = 0; i < 4; ++i) { out[i] = rng._out[i]; }
+    }
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef VMC_PROFILER_HPP
+#define VMC_PROFILER_HPP
+
+#include "vmc/HardwareCounters.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vmc
+{
+
+// Phases of the hot path, recorded by the VMC_PROFILE_SCOPE macro
+enum class ProfilePhase: int
+{
+    ProtoFunction = 0, // WaveFunction::protoFunction
+    AcceptanceFunction, // WaveFunction::acceptanceFunction
+    ComputeAllDerivatives, // WaveFunction::computeAllDerivatives
+    ObservableFunction, // Hamiltonian / MC observables
+    Integrate, // MC integration calls (incl. MCI's findMRT2step/decorrelation and its internal reduction)
+    MPIReduce, // explicit MPI reductions of VMC++
+    TargetFunction, // evaluations of the target functions (f/grad/fgrad)
+    GradientSolve, // linear algebra of SR / Linear Method
+    Count // number of phases
+};
+
+struct ProfileEntry
+{
+    std::string name;
+    int64_t calls;
+    double seconds;
+    std::vector<int64_t> hwCounts; // per HardwareEvent, -1 if not measured
+};
+
+// Cumulative times and call counts per phase (of the calling process, i.e. MPI rank)
+struct ProfileReport
+{
+    bool enabled; // was the library compiled with USE_PROFILING=1?
+    int rank;
+    bool hwCounters; // were hardware counters enabled (see Profiler::enableHardwareCounters)?
+    std::vector<ProfileEntry> entries;
+
+    std::string toJSON() const;
+};
+
+
+// Low-overhead, compile-time switchable phase profiler
+//
+// If compiled with USE_PROFILING=1, every VMC_PROFILE_SCOPE(Phase) measures the time until the end of
+// the enclosing scope and adds it to the phase. Times are inclusive and only the outermost scope of
+// a phase is counted (e.g. protoFunction calls of wave function components inside a wrapper's
+// protoFunction). Every thread records into own counters, which are summed up by getReport().
+// Without USE_PROFILING the macro expands to nothing and the report contains zeros.
+//
+// Optionally, hardware events (cycles, instructions, cache and branch misses, see HardwareCounters.hpp)
+// are counted per phase as well, to tell e.g. memory-bound (many cache misses per instruction) from
+// compute-bound (high instructions per cycle) kernels. This costs two read syscalls (~1 microsecond) per
+// outermost scope, which are included in the counts of enclosing phases. Restrict it to the phases of interest.
+//
+// NOTE: Phases inside MCI (proposals, findMRT2step, decorrelation) can only be recorded as far
+// as MCI calls into VMC++ code (wave functions, observables), the rest is part of Integrate.
+class Profiler
+{
+public:
+    static constexpr int NPHASES = static_cast<int>(ProfilePhase::Count);
+
+    static const char * getPhaseName(ProfilePhase phase);
+
+    static void add(ProfilePhase phase, int64_t nanoseconds, int64_t calls = 1);
+    // add one call from begin to end, which is also traced if the Tracer is active
+    static void record(ProfilePhase phase, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+    static ProfileReport getReport();
+    static void reset();
+
+    // Count hardware events for the given phases (all phases if empty). Returns false, leaving the
+    // counting disabled, if no hardware event is available (checked in the calling thread).
+    static bool enableHardwareCounters(const std::vector<ProfilePhase> &phases = {});
+    static void disableHardwareCounters();
+    static bool isCountingHardware(const ProfilePhase phase)
+    {
+        return (_hwPhaseMask.load(std::memory_order_relaxed) & (1u << static_cast<int>(phase))) != 0;
+    }
+    // add hardware event counts of one call, from the counts at begin to the counts at end
+    static void addHardwareCounts(ProfilePhase phase, const int64_t * begin, const int64_t * end);
+
+    // RAII timer for one phase
+    class Scope
+    {
+    private:
+        const ProfilePhase _phase;
+        const bool _outer;
+        bool _hw = false;
+        std::chrono::steady_clock::time_point _start;
+        int64_t _hwStart[HardwareCounters::NEVENTS];
+
+        static int * _depths()
+        {
+            thread_local int depths[NPHASES] = {};
+            return depths;
+        }
+
+    public:
+        explicit Scope(const ProfilePhase phase):
+                _phase(phase), _outer(_depths()[static_cast<int>(phase)]++ == 0)
+        {
+            if (_outer) {
+                if (Profiler::isCountingHardware(phase)) { _hw = HardwareCounters::read(_hwStart); }
+                _start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Scope()
+        {
+            --_depths()[static_cast<int>(_phase)];
+            if (_outer) {
+                const auto end = std::chrono::steady_clock::now();
+                if (_hw) {
+                    int64_t hwEnd[HardwareCounters::NEVENTS];
+                    HardwareCounters::read(hwEnd);
+                    Profiler::addHardwareCounts(_phase, _hwStart, hwEnd);
+                }
+                Profiler::record(_phase, _start, end);
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+private:
+    static std::atomic<uint32_t> _hwPhaseMask; // bit i: count hardware events for phase i
+};
+} // namespace vmc
+
+
+#if USE_PROFILING == 1
+#define VMC_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VMC_PROFILE_CONCAT(a, b) VMC_PROFILE_CONCAT_IMPL(a, b)
+#define VMC_PROFILE_SCOPE(phase) const vmc::Profiler::Scope VMC_PROFILE_CONCAT(vmc_profile_scope_, __LINE__)(vmc::ProfilePhase::phase)
+#else
+#define VMC_PROFILE_SCOPE(phase)
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef VMC_REWEIGHTING_HPP
+#define VMC_REWEIGHTING_HPP
+
+#include "vmc/WaveFunction.hpp"
+
+#include <cmath>
+
+namespace vmc
+{
+
+// Reweighting helpers, shared by CorrelatedSampling, CorrelatedEvaluation and TrajectoryReplay
+//
+// Samples x drawn from Psi_ref^2 estimate the expectation value of e under Psi^2 by the ratio estimator
+//     E = sum w*e / sum w,    w(x) = |Psi(x) / Psi_ref(x)|^2
+// whose linearized error follows from the (co)variances of the sums A = sum w*e and B = sum w (over
+// uncorrelated samples or block sums). The effective sample size (sum w)^2 / sum w^2 monitors the reweighting.
+
+// Reweighting factor w(x) of wf, given the proto values protoref of the reference wave function at x, which
+// must be compatible with wf (e.g. the same wave function at other parameters). protonew is a buffer of wf.getNProto().
+inline double reweightingFactor(WaveFunction &wf, const double * x, const double * protoref, double * protonew)
+{
+    wf.protoFunction(x, protonew);
+    return wf.acceptanceFunction(protoref, protonew); // ratio of Psi^2
+}
+
+// Linearized error of the ratio estimator E = A/B, from the variances of A and B and their covariance
+inline double ratioEstimatorError(const double E, const double B, const double varA, const double covAB, const double varB)
+{
+    const double var = varA - 2.*E*covAB + E*E*varB;
+    return (var > 0.) ? sqrt(var)/fabs(B) : 0.;
+}
+
+// Effective sample size of weights with sum sumw and sum of squares sumw2
+inline double effectiveSampleSize(const double sumw, const double sumw2)
+{
+    return (sumw2 > 0.) ? sumw*sumw/sumw2 : 0.;
+}
+} // namespace vmc
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef VMC_SHAREDVP_HPP
+#define VMC_SHAREDVP_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vmc
+{
+
+// Versioned block of variational parameters, shared by an object and its clones
+//
+// Every publish() stores a new immutable snapshot of the parameters (O(nvp)) and increments the version.
+// Readers poll getVersion(), which is a single lock-free atomic load, and only load() the new snapshot
+// when the version changed, so the evaluation hot path never takes a lock. Snapshots stay valid as long
+// as a reader holds them, even if new versions are published meanwhile.
+class SharedVP
+{
+public:
+    struct Snapshot
+    {
+        uint64_t version;
+        std::vector<double> vp;
+    };
+
+private:
+    const int _nvp;
+    std::shared_ptr<const Snapshot> _snapshot; // only accessed via std::atomic_load/atomic_store
+    std::atomic<uint64_t> _version;
+    std::mutex _publishMutex; // serializes concurrent publishers
+
+public:
+    SharedVP(const double * vp, const int nvp):
+            _nvp(nvp), _snapshot(std::make_shared<const Snapshot>(Snapshot{1, std::vector<double>(vp, vp + nvp)})), _version(1) {}
+
+    int getNVP() const { return _nvp; }
+
+    // current version (starts at 1)
+    uint64_t getVersion() const { return _version.load(std::memory_order_acquire); }
+
+    // current snapshot of version and parameters
+    std::shared_ptr<const Snapshot> load() const { return std::atomic_load(&_snapshot); }
+
+    // publish new parameters vp[nvp], returns the new version
+    uint64_t publish(const double * vp)
+    {
+        std::lock_guard<std::mutex> lock(_publishMutex);
+        const uint64_t version = _version.load(std::memory_order_relaxed) + 1;
+        std::atomic_store(&_snapshot, std::make_shared<const Snapshot>(Snapshot{version, std::vector<double>(vp, vp + _nvp)}));
+        _version.store(version, std::memory_order_release);
+        return version;
+    }
+};
+} // namespace vmc
+
+#endif
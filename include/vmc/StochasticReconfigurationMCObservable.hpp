@@ -60,6 +60,7 @@ public:
     // mci::ObservableFunctionInterface implementation
     void observableFunction(const double * in, double * out) final
     {
+        VMC_PROFILE_SCOPE(ObservableFunction);
         // out is made in this way (nvp is the number of variational parameters):
         // out[0:nvp-1] = Oi
         // out[nvp:2*nvp-1] = HOi
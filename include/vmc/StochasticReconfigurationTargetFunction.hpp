@@ -1,29 +1,107 @@
 #ifndef VMC_STOCHASTICRECONFIGURATIONTARGETFUNCTION_HPP
 #define VMC_STOCHASTICRECONFIGURATIONTARGETFUNCTION_HPP
 
-#include "vmc/VMC.hpp"
-#include "nfm/NoisyFunction.hpp"
+#include "vmc/VMCTargetFunction.hpp"
+
+#include <stdexcept>
+#include <vector>
 
 namespace vmc
 {
 
-class StochasticReconfigurationTargetFunction: public nfm::NoisyFunctionWithGradient
+// Solve for the SR direction grad_E (and its rough error dgrad_E, if not nullptr), given the integrated
+// observables obs/dobs in the layout [H (4 energies), O_i, H*O_i, O_i*O_j] (see StochasticReconfigurationMCObservable)
+// If condition is not nullptr, the condition number of the matrix S_ij (ratio of its extreme singular values) is stored.
+void computeSRDirection(int nvp, const double * obs, const double * dobs, double * grad_E, double * dgrad_E = nullptr, double * condition = nullptr);
+
+// Distributed variant of computeSRDirection, for many variational parameters
+// All ranks pass the same reduced obs/dobs, but only the first 4 + 2*nvp values (H, O_i, H*O_i), and OiOjRows holds
+// only the row block of this rank (see MPIVMC::RowOffsets) of the reduced O_i*O_j array. S_ij is never assembled:
+// the ranks solve the system cooperatively by conjugate gradients, where every iteration only gathers the
+// nvp-length product of S_ij with the search direction. Starting from zero, CG converges towards the
+// pseudo-inverse solution of computeSRDirection; a diagonal shift (shift times the largest diagonal element
+// of S_ij) keeps nearly singular systems stable. CG stops at a relative residual of tolerance or after maxIter
+// iterations (0 means nvp). The error dgrad_E (if not nullptr) only propagates the errors of the forces.
+// If condition is not nullptr, it receives the condition number of the (shifted) S_ij as estimated from the CG
+// coefficients (extreme eigenvalues of the Lanczos matrix). It is exact if CG took nvp iterations, otherwise a lower bound.
+// Returns the number of CG iterations (of the direction solve).
+// Note that only the solve is distributed: every rank still samples into a full nvp x nvp O_i*O_j accumulator
+// (MCI) and buffer before the reduce-scatter, i.e. the memory per rank remains of order nvp^2.
+int computeSRDirectionDistributed(int nvp, const double * obs, const double * dobs, const double * OiOjRows, double * grad_E,
+                                  double * dgrad_E = nullptr, double tolerance = 1.e-8, int maxIter = 0, double shift = 1.e-9,
+                                  double * condition = nullptr);
+
+// Combine the SR observables [H (4 energies), O_i, H*O_i, O_i*O_j] of independent integrations on all ranks (in-place),
+// like MPIVMC::ReduceResults. If singlePrecision is true, O_i*O_j are reduced in float32, but as the covariances
+// <O_i O_j> - <O_i><O_j> of every rank (of its own averages, centered in double precision), which scale with the
+// fluctuations instead of the means of O_i. The products of the averages O_i of all ranks are gathered and added
+// back in double precision, so the float32 rounding stays far below the statistical noise even for large means.
+void reduceSRResults(int nvp, double * obs, double * dobs, bool singlePrecision = false);
+
+// Distributed variant of reduceSRResults for computeSRDirectionDistributed: obs/dobs receive the reduced first
+// 4 + 2*nvp values of this rank's integration results lobs/ldobs, and OiOjRows the row block of this rank
+// (see MPIVMC::RowOffsets) of the reduced O_i*O_j (without errors). The O_i*O_j part of lobs is overwritten.
+void reduceScatterSRResults(int nvp, double * lobs, const double * ldobs, double * obs, double * dobs,
+                            std::vector<double> &OiOjRows, bool singlePrecision = false);
+
+class StochasticReconfigurationTargetFunction: public VMCTargetFunction
 {
 protected:
-    VMC &_vmc; // the VMC object containing WaveFunction, Hamiltonian and MCI
-    const int64_t _E_Nmc; // number of MC steps for energy calculation
-    const int64_t _grad_E_Nmc; // number of MC steps for gradient calculation
-    const double _lambda_reg; // vp regularization factor
+    // distributed S_ij reduction and solve (see setDistributedSolve())
+    bool _distributedSolve = false;
+    double _cgTolerance = 1.e-8;
+    int _cgMaxIter = 0;
+    bool _singlePrecisionReduction = false; // reduce O_i*O_j as float32 (see setSinglePrecisionReduction())
 
     void _integrate(const double * vp, double * obs, double * dobs, bool flag_grad = false, bool flag_dgrad = false);
+    void _integrateDistributed(const double * vp, double * obs, double * dobs, std::vector<double> &OiOjRows, bool flag_dgrad);
     void _calcObs(const double * vp, double &f, double &df, double * grad_E = nullptr, double * dgrad_E = nullptr);
 public:
     StochasticReconfigurationTargetFunction(VMC &vmc, int64_t E_Nmc, int64_t grad_E_Nmc, bool useGradErr, double lambda_reg = 0.):
-            nfm::NoisyFunctionWithGradient(vmc.getNVP(), useGradErr), _vmc(vmc),
-            _E_Nmc(E_Nmc), _grad_E_Nmc(grad_E_Nmc), _lambda_reg(lambda_reg) {}
+            VMCTargetFunction(vmc, E_Nmc, grad_E_Nmc, useGradErr, lambda_reg) {}
 
     ~StochasticReconfigurationTargetFunction() final = default;
 
+    // Distribute the S_ij matrix over the ranks (disabled by default)
+    // If enabled, gradient evaluations reduce-scatter the O_i*O_j array in row blocks instead of reducing it
+    // completely on every rank, and the ranks solve for the SR direction together by conjugate gradients
+    // (see computeSRDirectionDistributed), instead of repeating the SVD on every rank. Recommended for large
+    // numbers of variational parameters. Errors of O_i*O_j are not reduced, so dgrad_E is a rougher estimate,
+    // and target-error adaptive gradient sampling takes precedence (it requires the fully reduced arrays).
+    // It saves the nvp^2 reduction result and the SVD work per rank, but not the nvp^2 sampling memory per rank
+    // (see computeSRDirectionDistributed). Cannot be combined with overlap sampling (see setOverlapSampling()).
+    void setDistributedSolve(bool distributedSolve, double cgTolerance = 1.e-8, int cgMaxIter = 0)
+    {
+        if (cgTolerance <= 0. || cgMaxIter < 0) {
+            throw std::invalid_argument("[StochasticReconfigurationTargetFunction] CG tolerance must be positive and maxIter non-negative.");
+        }
+        if (distributedSolve && _overlapNchunk > 0) {
+            throw std::invalid_argument("[StochasticReconfigurationTargetFunction] The distributed solve does not support overlap sampling.");
+        }
+        _distributedSolve = distributedSolve;
+        _cgTolerance = cgTolerance;
+        _cgMaxIter = cgMaxIter;
+    }
+    bool isDistributedSolve() const { return _distributedSolve; }
+
+    // See VMCTargetFunction, not supported together with the distributed solve (the gradient evaluations
+    // reduce-scatter on this rank's own samples, without overlap)
+    void setOverlapSampling(int64_t Nchunk, double warmFraction = 0.1) final
+    {
+        if (Nchunk > 0 && _distributedSolve) {
+            throw std::invalid_argument("[StochasticReconfigurationTargetFunction] Overlap sampling is not supported with the distributed solve.");
+        }
+        VMCTargetFunction::setOverlapSampling(Nchunk, warmFraction);
+    }
+
+    // Reduce the O_i*O_j array of gradient evaluations over the ranks in single precision (disabled by default)
+    // The per-rank covariances are reduced (see reduceSRResults), whose statistical noise is far above the float32
+    // precision, so this halves the dominating reduction volume for large nvp without noticeable loss of accuracy.
+    // Energies, O_i and H*O_i are still reduced in double, and the sampling (Nmc split among the ranks) is unchanged.
+    // Applies to the default and the distributed solve, but not to target-error adaptive or overlapped sampling.
+    void setSinglePrecisionReduction(bool singlePrecision) { _singlePrecisionReduction = singlePrecision; }
+    bool isSinglePrecisionReduction() const { return _singlePrecisionReduction; }
+
     // NoisyFunctionWithGradient implementation
     nfm::NoisyValue f(const std::vector<double> &vp) final;
     void grad(const std::vector<double> &vp, nfm::NoisyGradient &grad) final;
@@ -3,6 +3,8 @@
 
 #include "vmc/WaveFunction.hpp"
 
+#include <memory>
+
 namespace vmc
 {
 
@@ -24,6 +26,7 @@ class SymmetrizerWaveFunction: public WaveFunction
       in practice for more than a handful of particles.
     */
 protected:
+    std::unique_ptr<WaveFunction> _ownedWF; // set if we own the wrapped wavefunction (e.g. on clones)
     WaveFunction * const _wf; // we wrap around an existing wavefunction
     const bool _flag_antisymmetric; // should we use the antisymmetrizer instead of symmetrizer?
 
@@ -36,7 +39,7 @@ protected:
 
     mci::SamplingFunctionInterface * _clone() const final
     {
-        return new SymmetrizerWaveFunction(_wf, _flag_antisymmetric);
+        return new SymmetrizerWaveFunction(_wf->cloneWaveFunction(), _flag_antisymmetric); // deep copy
     }
 
     // we have a ProtoFunctionInterface as member (_wf), so we need to implement these:
@@ -48,6 +51,13 @@ public:
             WaveFunction(wf->getNSpaceDim(), wf->getNPart(), 1, wf->getNVP(), wf->hasVD1(), wf->hasD1VD1(), wf->hasD2VD1()),
             _wf(wf), _flag_antisymmetric(flag_antisymmetric) {}
 
+    // symmetrizer taking ownership of the wrapped wavefunction
+    explicit SymmetrizerWaveFunction(std::unique_ptr<WaveFunction> wf, bool flag_antisymmetric = false):
+            SymmetrizerWaveFunction(wf.get(), flag_antisymmetric)
+    {
+        _ownedWF = std::move(wf);
+    }
+
     ~SymmetrizerWaveFunction() override = default;
 
     void setVP(const double * vp) override;
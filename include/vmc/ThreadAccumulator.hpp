@@ -0,0 +1,129 @@
+#ifndef VMC_THREADACCUMULATOR_HPP
+#define VMC_THREADACCUMULATOR_HPP
+
+#include "vmc/AlignedAllocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vmc
+{
+
+// Lock-free accumulation of observable samples (e.g. the energies of a Hamiltonian or the arrays of
+// EnergyGradientMCObservable / StochasticReconfigurationMCObservable) by several threads
+//
+// Every thread accumulates only into its own slot (accumulate(ithread, values)), which is aligned and padded
+// to full cache lines, so that threads never share a cache line on the hot path. After the threads finished,
+// getResult() merges the slots in thread order, so the result is bitwise reproducible if every thread
+// accumulates the same samples in the same order (e.g. a fixed assignment of walkers to threads).
+// Samples may carry weights (e.g. reweighting factors), then weighted averages (ratio estimators) are computed.
+//
+// Modes (like the MCI accumulators):
+//     blocksize == 0: simple, the error is estimated from the (weighted) sample variance (uncorrelated samples)
+//     blocksize > 0:  blocking, the error is estimated from the variance of the block averages. By default every
+//                     thread forms blocks of blocksize consecutive samples and only complete blocks enter the error
+//                     (incomplete blocks only enter the average). If samples are added with their global index,
+//                     block ib contains the samples ib*blocksize..(ib+1)*blocksize-1, no matter which threads
+//                     added them, and all non-empty blocks enter the error. Don't mix both ways.
+class ThreadAccumulator
+{
+private:
+    static constexpr size_t CACHELINE = 64; // bytes
+
+    // per-thread data, one cache line per slot header
+    // sums: [sum w*x (nobs), sum w*x^2 (nobs), sum w, sum w^2, nsamples]
+    // blocks: [block index, nsamples, sum w, sum w*x (nobs)] per (partial) block, the last one is the current block
+    struct alignas(CACHELINE) Slot
+    {
+        std::vector<double, AlignedAllocator<double, CACHELINE>> sums;
+        std::vector<double, AlignedAllocator<double, CACHELINE>> blocks;
+        bool indexed = false; // blocks by global sample index
+    };
+
+    const int _nobs;
+    const int _nthreads;
+    const int64_t _blocksize;
+    std::vector<Slot, AlignedAllocator<Slot, CACHELINE>> _slots;
+
+    size_t _blockLength() const { return static_cast<size_t>(_nobs) + 3; }
+    double * _newBlock(Slot &slot, int64_t iblock);
+    // merged block sums (in the layout of Slot::blocks) of all blocks that enter the error
+    std::vector<double> _mergedBlocks() const;
+
+    void _add(Slot &slot, const double * values, const double weight)
+    {
+        double * const sum = slot.sums.data();
+        double * const sum2 = sum + _nobs;
+        for (int i = 0; i < _nobs; ++i) {
+            const double wx = weight*values[i];
+            sum[i] += wx;
+            sum2[i] += wx*values[i];
+        }
+        sum[2*_nobs] += weight;
+        sum[2*_nobs + 1] += weight*weight;
+        sum[2*_nobs + 2] += 1.;
+    }
+
+    void _addToBlock(double * block, const double * values, const double weight)
+    {
+        block[1] += 1.;
+        block[2] += weight;
+        for (int i = 0; i < _nobs; ++i) { block[3 + i] += weight*values[i]; }
+    }
+
+public:
+    ThreadAccumulator(int nobs, int nthreads, int64_t blocksize = 0);
+
+    int getNObs() const { return _nobs; }
+    int getNThreads() const { return _nthreads; }
+    int64_t getBlockSize() const { return _blocksize; }
+    bool isBlocking() const { return _blocksize > 0; }
+
+    void reset();
+    // (Re)allocate the empty slot of ithread from the calling thread, i.e. on its NUMA node (first touch).
+    // Optional, the constructor and reset() allocate all slots from the calling thread.
+    void initThread(int ithread);
+
+    // add one sample values[nobs] with weight of thread ithread (only call with the calling thread's own index)
+    void accumulate(int ithread, const double * values, double weight = 1.)
+    {
+        Slot &slot = _slots[ithread];
+        this->_add(slot, values, weight);
+        if (isBlocking()) {
+            const size_t blen = _blockLength();
+            double * block = slot.blocks.empty() ? nullptr : &slot.blocks[slot.blocks.size() - blen];
+            if (block == nullptr || block[1] == static_cast<double>(_blocksize)) {
+                block = _newBlock(slot, (block == nullptr) ? 0 : static_cast<int64_t>(block[0]) + 1);
+            }
+            _addToBlock(block, values, weight);
+        }
+    }
+
+    // add the sample with global index isample (non-decreasing for every thread), see blocking mode above
+    void accumulate(int ithread, const double * values, double weight, int64_t isample)
+    {
+        Slot &slot = _slots[ithread];
+        this->_add(slot, values, weight);
+        if (isBlocking()) {
+            slot.indexed = true;
+            const int64_t iblock = isample/_blocksize;
+            const size_t blen = _blockLength();
+            double * block = slot.blocks.empty() ? nullptr : &slot.blocks[slot.blocks.size() - blen];
+            if (block == nullptr || static_cast<int64_t>(block[0]) != iblock) { block = _newBlock(slot, iblock); }
+            _addToBlock(block, values, weight);
+        }
+    }
+
+    // --- merged results (call after all threads finished accumulating)
+    int64_t getNSamples() const;
+    int64_t getNSamples(int ithread) const { return static_cast<int64_t>(_slots[ithread].sums[2*_nobs + 2]); }
+    int64_t getNBlocks() const; // blocks that enter the error (blocking mode)
+    // average and error of the nobs observables, over all ranks if allRanks is true (collective)
+    void getResult(double * average, double * error, bool allRanks = false) const;
+    // effective sample size (sum w)^2/(sum w^2), i.e. the number of samples if all weights are equal
+    double getESS(bool allRanks = false) const;
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef VMC_THREADAFFINITY_HPP
+#define VMC_THREADAFFINITY_HPP
+
+#include <vector>
+
+namespace vmc
+{
+
+// NUMA topology of the CPUs this process may run on (Linux, read from /sys/devices/system/node)
+//
+// Without NUMA information all allowed CPUs form a single node 0. On non-Linux systems the topology
+// is unknown, i.e. there is one node without CPUs and threads cannot be pinned.
+class NumaTopology
+{
+public:
+    // allowed CPUs of every (non-empty) node, determined once at the first call
+    static const std::vector<std::vector<int>> &getNodeCPUs();
+    static int getNNodes() { return static_cast<int>(getNodeCPUs().size()); }
+
+    // Placement of worker ithread out of nthreads: workers are distributed in contiguous, balanced
+    // groups over the nodes and round-robin over the CPUs of their node. getWorkerCPU returns -1 if unknown.
+    static int getWorkerNode(int ithread, int nthreads);
+    static int getWorkerCPU(int ithread, int nthreads);
+};
+
+
+// Pins the calling thread to a set of CPUs for the lifetime of the object and restores the previous
+// affinity afterwards. Memory which the pinned thread touches first is then (by the default Linux policy)
+// allocated on the node of these CPUs. If pinning fails or cpus is empty, nothing is changed.
+class ThreadPin
+{
+private:
+    std::vector<int> _oldcpus; // previous affinity, empty if not pinned
+
+public:
+    explicit ThreadPin(const std::vector<int> &cpus);
+    ~ThreadPin();
+
+    ThreadPin(const ThreadPin &) = delete;
+    ThreadPin &operator=(const ThreadPin &) = delete;
+
+    bool isPinned() const { return !_oldcpus.empty(); }
+};
+} // namespace vmc
+
+#endif
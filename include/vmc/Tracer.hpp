@@ -0,0 +1,55 @@
+#ifndef VMC_TRACER_HPP
+#define VMC_TRACER_HPP
+
+#include "vmc/Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace vmc
+{
+
+// Timeline tracer, exporting the profiled phases in Chrome trace-event JSON format
+//
+// While active, every recorded Profiler scope (see Profiler.hpp, i.e. requires USE_PROFILING=1 for the
+// built-in instrumentation) additionally stores a begin/end span for the calling rank and thread.
+// The resulting file can be opened in chrome://tracing or https://ui.perfetto.dev, with one process
+// per MPI rank, to visualize load imbalance between sampling, reductions and solver phases.
+// The per-step phases (protoFunction, acceptanceFunction, computeAllDerivatives, observableFunction)
+// are only traced if traceSteps is true, because they produce a span per MC step. Since MCI's integrate
+// reduces internally, waiting ranks then show up as the gap between their last per-step span and the
+// end of the enclosing integrate span.
+//
+// Usage:
+//     Tracer::start("trace.json"); // collective, aligns the time origin of all ranks by a barrier
+//     ... optimization ...
+//     MPIVMC::Finalize(); // or Tracer::finalize(), gathers and writes the spans of all ranks (collective)
+//
+// NOTE: Every thread stores at most maxSpansPerThread spans, later ones are dropped (and counted).
+class Tracer
+{
+private:
+    static std::atomic<bool> _active;
+
+public:
+    // Start recording spans, to be written to filename (by rank 0) on finalize()
+    static void start(const std::string &filename, bool traceSteps = false, size_t maxSpansPerThread = 1000000);
+    static void stop(); // stop recording, keeping the recorded spans
+    static bool isActive() { return _active.load(std::memory_order_relaxed); }
+    static bool isStepPhase(ProfilePhase phase) { return phase <= ProfilePhase::ObservableFunction; }
+
+    // Record a span of the calling thread (used by Profiler scopes)
+    static void addSpan(ProfilePhase phase, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+    static size_t getNSpans(); // spans recorded by this process
+    static size_t getNDropped(); // spans dropped by this process because of maxSpansPerThread
+
+    // Stop recording, merge the spans of all ranks and write them to the file passed to start() (collective).
+    // Does nothing if start() was not called since the last finalize().
+    static void finalize();
+};
+} // namespace vmc
+
+#endif
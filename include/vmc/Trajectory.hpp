@@ -0,0 +1,135 @@
+#ifndef VMC_TRAJECTORY_HPP
+#define VMC_TRAJECTORY_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vmc
+{
+
+// Streaming binary trajectory files, e.g. for per-step configurations used in post-processing
+//
+// Every record consists of ndim walker coordinates, nproto proto values and nobs observables (e.g. the
+// 4 local energies), all stored as doubles. Records are grouped into chunks, which are optionally compressed
+// with zlib (requires building with USE_ZLIB=1). File layout (native endianness):
+//     header: magic "VMCTRAJ\0", uint32 version, int32 ndim, int32 nproto, int32 nobs
+//     chunk:  uint32 nrecords, uint32 compressed flag, uint64 payload bytes, payload (padded to 8 bytes)
+struct TrajectoryFormat
+{
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_BYTES = 24;
+    static constexpr size_t CHUNK_HEADER_BYTES = 16;
+    static const char MAGIC[8];
+
+    static bool hasCompression(); // was the library built with zlib support?
+};
+
+
+// Writes a trajectory file, double-buffered on a background thread
+//
+// append() only copies the record into the front buffer. Full chunks are handed over to a background
+// thread which (optionally compresses and) writes them, while sampling continues into the other buffer.
+// append() only blocks if the previous chunk is still being written when the next one is full.
+// IO errors of the background thread are rethrown (as std::runtime_error) by the next append/flush/close.
+class TrajectoryWriter
+{
+protected:
+    const int _ndim, _nproto, _nobs;
+    const size_t _reclen; // doubles per record
+    const int _chunksize; // records per chunk
+    const bool _compress;
+
+    std::ofstream _file;
+    int64_t _nrecords = 0; // total appended records
+
+    // double buffering
+    std::vector<double> _front, _back; // _front is filled by append, _back written by the thread
+    int _nfront = 0, _nback = 0; // records in _front / _back
+    bool _pending = false; // _back contains a chunk to be written
+    bool _stop = false;
+    std::string _error; // error message from the background thread
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::thread _thread;
+
+    void _run(); // background thread loop
+    void _writeChunk(const double * data, int nrec); // called by the background thread
+    void _handOver(); // move the front buffer to the background thread
+    void _waitIdle(); // wait until the background thread is done with _back
+    void _checkError();
+
+public:
+    TrajectoryWriter(const std::string &filename, int ndim, int nproto, int nobs, int chunksize = 4096, bool compress = false);
+    ~TrajectoryWriter(); // closes the file (errors are ignored, call close() to handle them)
+
+    TrajectoryWriter(const TrajectoryWriter &) = delete;
+    TrajectoryWriter &operator=(const TrajectoryWriter &) = delete;
+
+    int getNDim() const { return _ndim; }
+    int getNProto() const { return _nproto; }
+    int getNObs() const { return _nobs; }
+    int getChunkSize() const { return _chunksize; }
+    bool isCompressed() const { return _compress; }
+    int64_t getNRecords() const { return _nrecords; }
+
+    // Append one record (proto/obs may be nullptr if nproto/nobs is 0)
+    void append(const double * x, const double * proto = nullptr, const double * obs = nullptr);
+
+    void flush(); // write the current (partial) chunk and wait until it is written
+    void close(); // flush and close the file, stop the background thread
+};
+
+
+// Reads a trajectory file via mmap (POSIX)
+//
+// The chunk index is built on construction. Uncompressed chunks are accessed without copying,
+// compressed ones are decompressed into a buffer provided by the caller. Since the reader itself
+// is never modified after construction, the chunks may be read concurrently from several threads.
+class TrajectoryReader
+{
+protected:
+    int _ndim = 0, _nproto = 0, _nobs = 0;
+    size_t _reclen = 0;
+
+    const char * _map = nullptr; // mapped file
+    size_t _mapsize = 0;
+
+    // chunk index
+    std::vector<size_t> _chunk_offset; // payload offsets
+    std::vector<size_t> _chunk_bytes; // payload bytes
+    std::vector<int> _chunk_nrec;
+    std::vector<bool> _chunk_compressed;
+    std::vector<int64_t> _chunk_first; // index of the first record of the chunk
+    int64_t _nrecords = 0;
+
+public:
+    explicit TrajectoryReader(const std::string &filename);
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader &) = delete;
+    TrajectoryReader &operator=(const TrajectoryReader &) = delete;
+
+    int getNDim() const { return _ndim; }
+    int getNProto() const { return _nproto; }
+    int getNObs() const { return _nobs; }
+    size_t getRecordLength() const { return _reclen; } // doubles per record: x, proto, obs
+    int64_t getNRecords() const { return _nrecords; }
+    int64_t getNChunks() const { return static_cast<int64_t>(_chunk_nrec.size()); }
+    int getChunkNRecords(int64_t ichunk) const { return _chunk_nrec[ichunk]; }
+    int64_t getChunkFirstRecord(int64_t ichunk) const { return _chunk_first[ichunk]; }
+
+    // Pointer to the records of chunk ichunk (getChunkNRecords()*getRecordLength() doubles). The buffer is
+    // only used (and then owns the data) for compressed chunks, otherwise the pointer points into the map.
+    const double * getChunk(int64_t ichunk, std::vector<double> &buffer) const;
+
+    // Copy the record with global index irec into out (getRecordLength() doubles)
+    void getRecord(int64_t irec, double * out) const;
+};
+} // namespace vmc
+
+#endif
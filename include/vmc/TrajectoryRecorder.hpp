@@ -0,0 +1,76 @@
+#ifndef VMC_TRAJECTORYRECORDER_HPP
+#define VMC_TRAJECTORYRECORDER_HPP
+
+#include "mci/ObservableFunctionInterface.hpp"
+#include "mci/DependentObservableInterface.hpp"
+#include "vmc/DependencyHelpers.hpp"
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/Trajectory.hpp"
+#include "vmc/WaveFunction.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace vmc
+{
+
+// MC Observable streaming the configurations of the VMC's Markov chain to a TrajectoryWriter (see VMC::recordTrajectory)
+//
+// Every evaluation appends one record of the walker position, the proto values of the wave function and
+// the 4 local energies of the Hamiltonian, which are read from the Hamiltonian observable (so it must be
+// added after the Hamiltonian, with the same nskip). The proto values are recomputed on a private clone
+// of the wave function, which therefore must have the same variational parameters as the sampled one.
+// The observable itself has a single dummy value (0). The writer is not owned.
+//
+// NOTE: Remember the necessary dependency binding just as in the case of Hamiltonian.
+class TrajectoryRecorder: public mci::ObservableFunctionInterface, public mci::DependentObservableInterface
+{
+protected:
+    const std::unique_ptr<WaveFunction> _wf; // clone, for the proto values
+    TrajectoryWriter &_writer;
+    std::vector<double> _proto;
+
+    const double * _E = nullptr; // bound via registerDeps(), energies of the Hamiltonian
+
+    mci::ObservableFunctionInterface * _clone() const final
+    {
+        return new TrajectoryRecorder(*_wf, _writer);
+    }
+public:
+    TrajectoryRecorder(const WaveFunction &wf, TrajectoryWriter &writer):
+            mci::ObservableFunctionInterface(wf.getTotalNDim(), 1, false),
+            mci::DependentObservableInterface(true),
+            _wf(wf.cloneWaveFunction()), _writer(writer), _proto(static_cast<size_t>(wf.getNProto()))
+    {
+        if (writer.getNDim() != wf.getTotalNDim() || writer.getNProto() != wf.getNProto() || writer.getNObs() != 4) {
+            throw std::invalid_argument("[TrajectoryRecorder] Record layout of the TrajectoryWriter doesn't match.");
+        }
+    }
+
+    ~TrajectoryRecorder() final = default;
+
+    bool isBound() const { return (_E != nullptr); }
+
+    // Methods to register/deregister Hamiltonian dependency (called by MCI)
+    void registerDeps(const mci::SamplingFunctionContainer &/*pdfcont*/, const std::vector<mci::AccumulatorInterface *> &accus, int selfIdx) final
+    {
+        _E = fetchEnergyDep<Hamiltonian>(accus, selfIdx, "TrajectoryRecorder::registerDeps");
+    }
+
+    void deregisterDeps() final
+    {
+        _E = nullptr;
+    }
+
+    // mci::ObservableFunctionInterface implementation
+    void observableFunction(const double * in, double * out) final
+    {
+        _wf->protoFunction(in, _proto.data());
+        _writer.append(in, _proto.data(), _E);
+        out[0] = 0.;
+    }
+};
+} // namespace vmc
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef VMC_TRAJECTORYREPLAY_HPP
+#define VMC_TRAJECTORYREPLAY_HPP
+
+#include "vmc/Trajectory.hpp"
+#include "vmc/WaveFunction.hpp"
+#include "mci/ObservableFunctionInterface.hpp"
+
+#include <cstdint>
+#include <functional>
+
+namespace vmc
+{
+
+// Offline evaluation of observables on the configurations of a stored trajectory
+//
+// Decouples the expensive Metropolis sampling (see ConfigurationSampler::record()) from post-hoc estimation:
+// Any observable may be evaluated on the stored configurations, together with any WaveFunction whose
+// derivatives are computed on every configuration before the observable (as MCI would do).
+// If reweighting is enabled, every configuration is weighted by
+//     w(x) = |Psi(x) / Psi_stored(x)|^2 = wf.acceptanceFunction(proto_stored, proto(x))
+// which requires the stored proto values to be compatible with the passed WaveFunction. If the passed
+// wf equals the sampled one, all weights are exactly 1.
+//
+// The chunks of the trajectory are processed concurrently by nthreads threads, every thread working on
+// own clones of the WaveFunction and observable. The clone of the observable is bound to the thread's
+// WaveFunction clone by the binding function (the default binds Hamiltonians via bindWaveFunction()).
+// Errors are estimated by (ratio-estimator) block averages over blocks of blocksize consecutive records,
+// which should be much longer than the autocorrelation time. With MPI, every rank replays its own
+// trajectory and the results are combined.
+//
+// With setPinThreads(true), the threads are pinned to cores, spread evenly over the NUMA nodes (see NumaTopology).
+// Every thread then creates its clones and its accumulator slot (see ThreadAccumulator) itself, i.e. on its own node.
+// Since every thread only holds the error blocks it contributed to, merging the threads costs O(total blocks).
+class TrajectoryReplay
+{
+public:
+    using BindFunction = std::function<void(WaveFunction &wf, mci::ObservableFunctionInterface &obs)>;
+
+protected:
+    const TrajectoryReader &_reader;
+    int _nthreads;
+    bool _pinthreads = false;
+    int64_t _blocksize = 1000; // records per error block
+    int64_t _nskip = 1; // use only every nskip-th record
+    double _ess = 0.; // effective sample size of the last evaluation (sum over ranks)
+
+public:
+    explicit TrajectoryReplay(const TrajectoryReader &reader, int nthreads = 0); // nthreads = 0: hardware concurrency
+
+    void setNThreads(int nthreads); // 0 for hardware concurrency
+    int getNThreads() const { return _nthreads; }
+    void setPinThreads(bool pinthreads) { _pinthreads = pinthreads; }
+    bool getPinThreads() const { return _pinthreads; }
+    void setBlockSize(int64_t blocksize);
+    int64_t getBlockSize() const { return _blocksize; }
+    void setNSkip(int64_t nskip);
+    int64_t getNSkip() const { return _nskip; }
+    double getESS() const { return _ess; } // ESS = (sum w)^2 / sum w^2 of the last evaluation
+
+    // Evaluate obs (with wf) on the stored configurations, average/error have obs.getNObs() elements.
+    // Returns the number of used records (sum over ranks).
+    int64_t evaluate(const WaveFunction &wf, const mci::ObservableFunctionInterface &obs, double * average, double * error,
+                     bool reweight = true, const BindFunction &bind = nullptr);
+};
+} // namespace vmc
+
+#endif
@@ -5,7 +5,9 @@
 #include "vmc/TwoBodyPseudoPotential.hpp"
 #include "vmc/WaveFunction.hpp"
 
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace vmc
 {
@@ -20,12 +22,16 @@ u is a 2-body pseudopotential, and must be implemented as TwoBodyPseudoPotential
 class TwoBodyJastrow: public WaveFunction
 {
 private:
+    std::unique_ptr<TwoBodyPseudoPotential> _ownedU2; // set if we own the pseudopotential (e.g. on clones)
     TwoBodyPseudoPotential * const _u2;
     ParticleArrayHelper * _pah;
 
+    // pair contributions used by the batched methods
+    std::vector<double> _bu, _bd1, _bd2, _bvd1;
+
     mci::SamplingFunctionInterface * _clone() const final
     {
-        return new TwoBodyJastrow(_npart, _u2);
+        return new TwoBodyJastrow(_npart, _u2->clone()); // deep copy, the clone owns a copy of u2
     }
 public:
     TwoBodyJastrow(int npart, TwoBodyPseudoPotential * u2):
@@ -40,14 +46,20 @@ public:
             throw std::invalid_argument("TwoBodyJastrow derivative d2vd1 requires vd1 and d1vd1");
         }
     }
+    // Jastrow taking ownership of the pseudopotential
+    TwoBodyJastrow(int npart, std::unique_ptr<TwoBodyPseudoPotential> u2):
+            TwoBodyJastrow(npart, u2.get())
+    {
+        _ownedU2 = std::move(u2);
+    }
     ~TwoBodyJastrow() override
     {
         delete _pah;
     }
 
 
-    void setVP(const double * vp) override { _u2->setVP(vp); }
-    void getVP(double * vp) const override { _u2->getVP(vp); }
+    void setVP(const double * vp) override { _u2->publishVP(vp); } // reaches the clones of a sharing u2
+    void getVP(double * vp) const override { _u2->getLatestVP(vp); }
 
 
     void protoFunction(const double * x, double * protov) override;
@@ -57,6 +69,11 @@ public:
     void computeAllDerivatives(const double * x) override;
 
     double computeWFValue(const double * protovalues) const override;
+
+    // vectorized across the walkers
+    void protoFunctionBatch(int nwalkers, const double * xs, double * protovs) override;
+
+    void computeAllDerivativesBatch(int nwalkers, const double * xs, double * d1s, double * d2s, double * vd1s = nullptr) override;
 };
 } // namespace vmc
 
@@ -2,6 +2,11 @@
 #define VMC_TWOBODYPSEUDOPOTENTIAL_HPP
 
 #include "vmc/Metric.hpp"
+#include "vmc/SharedVP.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace vmc
 {
@@ -10,6 +15,11 @@ class TwoBodyPseudoPotential
 {
 protected:
     Metric * _metric;
+    std::unique_ptr<Metric> _ownedMetric; // set on clones, which own a copy of the metric
+
+    // parameter block shared with the clones (only after shareVP()) and the version we use
+    std::shared_ptr<SharedVP> _sharedVP;
+    uint64_t _vpversion = 0;
     int _ndim2;
     int _nvp;
 
@@ -31,14 +41,46 @@ protected:
     double * _vfoo1;
     double * _vfoo2;
 
+    // arrays used for batched computations
+    std::vector<double> _br, _bud1, _bud2, _bfoo, _bfoo2;
+
+    void _pullVP();
+
     TwoBodyPseudoPotential(Metric * metric, int nvp, bool flag_vd1 = false, bool flag_d1vd1 = false, bool flag_d2vd1 = false);
 
+    // return a new pseudopotential of the same type and flags (using the same _metric is fine,
+    // clone() replaces it by a copy and copies the variational parameters afterwards)
+    virtual TwoBodyPseudoPotential * _clone() const = 0;    // --- MUST BE IMPLEMENTED
+
 public:
     virtual ~TwoBodyPseudoPotential();
 
     int getNSpaceDim() const { return _metric->getNSpaceDim(); }
     int getNVP() const { return _nvp; }
 
+    // Deep copy: the clone has its own metric copy and scratch arrays and starts with the same variational
+    // parameters, so clones can be evaluated concurrently (e.g. one per thread).
+    std::unique_ptr<TwoBodyPseudoPotential> clone() const;
+
+    // --- Parameters shared with the clones
+    // After shareVP(), this pseudopotential and all clones created from it (or from its clones) reference a single
+    // versioned parameter block: publishVP() on any of them sets the parameters of all, for O(nvp) cost. The other
+    // clones pick up the new version lock-free at the start of their next evaluation (see syncVP()). Clones created before
+    // shareVP() and calls of setVP() stay private.
+    void shareVP();
+    bool isSharingVP() const { return static_cast<bool>(_sharedVP); }
+    // set the parameters and, if shared, publish them to all clones
+    void publishVP(const double * vp);
+    // get the parameters, if shared the latest published ones (getVP() may lag behind until the next evaluation)
+    void getLatestVP(double * vp) const;
+    // apply the latest shared parameters, if they changed (one atomic load otherwise)
+    // Not done by the evaluation methods below, so that all pairs of one evaluation use the same parameters.
+    // Owners (e.g. TwoBodyJastrow) call it once at the start of every evaluation.
+    void syncVP()
+    {
+        if (_sharedVP && _sharedVP->getVersion() != _vpversion) { _pullVP(); }
+    }
+
     // -- Pair pseudopotential
     double u(const double * r1, const double * r2);
 
@@ -56,6 +98,13 @@ public:
     bool hasD1VD1() const { return _flag_d1vd1; }
     bool hasD2VD1() const { return _flag_d2vd1; }
 
+    // --- Walker-batched versions for n particle pairs at once (SoA layout, see Metric)
+    // Pair pseudopotentials out[k]
+    void uBatch(int n, const double * r1s, const double * r2s, double * out);
+    // Derivatives d1s/d2s[i*n + k] (i < 2*nspacedim) and, if hasVD1() and vd1s != nullptr, vd1s[ivp*n + k].
+    // The cross derivatives are not available in batched form.
+    void computeDerivativesBatch(int n, const double * r1s, const double * r2s, double * d1s, double * d2s, double * vd1s = nullptr);
+
 
     // --- Methods that must be implemented
     // manage variational parameters
@@ -68,6 +117,13 @@ public:
     virtual void urVD1(double r, double * vd1) = 0;            // e.g. -1/r^5
     virtual void urD1VD1(double r, double * d1vd1) = 0;        // e.g. 5/r^6
     virtual void urD2VD1(double r, double * d1vd1) = 0;        // e.g. -30/r^7
+
+    // batched functions of n distances r[k], with outputs out[k] (vd1s[ivp*n + k])
+    // The defaults loop over the methods above, override them to vectorize across the distances.
+    virtual void urBatch(int n, const double * r, double * out);
+    virtual void urD1Batch(int n, const double * r, double * out);
+    virtual void urD2Batch(int n, const double * r, double * out);
+    virtual void urVD1Batch(int n, const double * r, double * vd1s);
 };
 } // namespace vmc
 
@@ -3,11 +3,18 @@
 
 #include "vmc/Hamiltonian.hpp"
 #include "vmc/WaveFunction.hpp"
+#include "vmc/Profiler.hpp"
+#include "vmc/Trajectory.hpp"
 #include "mci/MCIntegrator.hpp"
 
+#include <functional>
 #include <stdexcept>
 #include <memory>
 
+#if USE_MPI == 1
+#include <mpi.h>
+#endif
+
 namespace vmc
 {
 
@@ -25,6 +32,10 @@ protected:
     // blocksize to use for energy/gradient evaluation, defaults to auto-blocking
     const int _blksize_eg;
 
+    // if true, the next energy computation skips findMRT2step/decorrelation (see skipNextEquilibration())
+    bool _skip_equil = false;
+    void _applySkipEquilibration(bool &doFindMRT2step, bool &doDecorrelation);
+
 public:
     // Constructors
     VMC(std::unique_ptr<WaveFunction> wf, std::unique_ptr<Hamiltonian> H, int nskip_eg = 1, int blksize_eg = 1); // move unique pointers into VMC
@@ -51,10 +62,56 @@ public:
     void setVP(const double * vp) { _wf->setVP(vp); }
     void getVP(double * vp) const { _wf->getVP(vp); }
 
+    // Let the next energy computation (of any kind) skip findMRT2step and decorrelation,
+    // e.g. because the walker and step sizes were restored from a checkpoint
+    void skipNextEquilibration() { _skip_equil = true; }
+    bool willSkipNextEquilibration() const { return _skip_equil; }
+
+    // Cumulative time and calls per hot-path phase (of this process/rank, see Profiler.hpp)
+    // Requires compilation with USE_PROFILING=1, otherwise the report is empty. Export via toJSON().
+    static ProfileReport getProfile() { return Profiler::getReport(); }
+    static void resetProfile() { Profiler::reset(); }
+
 
     // Computation of the energy according to contained Hamiltonian and WaveFunction
     // Other contained observables will be calculated as well and stored behind the energy values
     void computeEnergy(int64_t Nmc, double * E, double * dE, bool doFindMRT2step = true, bool doDecorrelation = true);
+
+    // Like computeEnergy, but without reduction over the ranks (for observables that are reduced in a custom
+    // way, e.g. the distributed SR solve). As in computeEnergy, Nmc is the total over all ranks, i.e. every rank
+    // samples its share of Nmc/MPIVMC::Size() steps and stores the averages/errors of only its own walkers.
+    void computeEnergyUnreduced(int64_t Nmc, double * E, double * dE, bool doFindMRT2step = true, bool doDecorrelation = true);
+
+#if USE_MPI == 1
+    // Like computeEnergy, but reduced over the ranks of comm only (Nmc is the total over these ranks), e.g. for
+    // rank groups evaluating different parameters concurrently (see MPIVMC::IntegrateOnComm)
+    void computeEnergyOnComm(MPI_Comm comm, int64_t Nmc, double * E, double * dE, bool doFindMRT2step = true, bool doDecorrelation = true);
+#endif
+
+    // Like computeEnergy (Nmc in total), but with non-blocking reduction over the ranks (see MPIVMC::IntegrateOverlapped)
+    // While the reduction is in flight, the walkers keep sampling in chunks of Nchunk steps (results discarded),
+    // after removing the last npop observables (e.g. temporary gradient observables). These are removed in any
+    // case, i.e. also without MPI. Returns the number of MC steps sampled during the reduction (on this rank).
+    int64_t computeEnergyOverlapped(int64_t Nmc, int64_t Nchunk, double * E, double * dE, int npop = 0,
+                                    bool doFindMRT2step = true, bool doDecorrelation = true);
+
+    // Like computeEnergy, but every configuration the energy is evaluated on (every nskip_eg steps of the walkers
+    // of this rank) is also appended to writer, with the proto values and the 4 local energies (see TrajectoryRecorder).
+    // The writer's record layout must be ndim, WF's nproto and 4 observables. Under MPI, use one writer (file) per rank.
+    void recordTrajectory(int64_t Nmc, TrajectoryWriter &writer, double * E, double * dE, bool doFindMRT2step = true, bool doDecorrelation = true);
+
+    // Target-error adaptive computation of the energy (see MPIVMC::IntegrateAdaptive for details)
+    // Samples in increments, starting with Ninit steps, until dE[ElocID::ETot] <= targetError or a total of
+    // Nmax steps is reached. Optionally, a custom errorFunction(E, dE) on all contained observables can be
+    // used as stopping criterion instead. Returns the total number of steps used.
+    int64_t computeEnergyAdaptive(double targetError, int64_t Ninit, int64_t Nmax, double * E, double * dE, bool doFindMRT2step = true, bool doDecorrelation = true,
+                                  const std::function<double(const double *, const double *)> &errorFunction = nullptr);
+
+    // Wall-clock budgeted computation of the energy (see MPIVMC::IntegrateTimed for details)
+    // Every rank samples in chunks of Nchunk steps for budget seconds (or until the error of the total
+    // energy is below targetError, if > 0). Returns the total number of samples.
+    int64_t computeEnergyTimed(double budget, int64_t Nchunk, double * E, double * dE, double targetError = 0., double checkInterval = 1.,
+                               bool doFindMRT2step = true, bool doDecorrelation = true);
 };
 } // namespace vmc
 
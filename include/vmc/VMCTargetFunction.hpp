@@ -0,0 +1,125 @@
+#ifndef VMC_VMCTARGETFUNCTION_HPP
+#define VMC_VMCTARGETFUNCTION_HPP
+
+#include "vmc/Checkpoint.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/OptimizerTelemetry.hpp"
+#include "vmc/VMC.hpp"
+#include "nfm/NoisyFunction.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace vmc
+{
+
+// Common base of the target functions for gradient-based wave function optimization
+// (EnergyGradientTargetFunction, StochasticReconfigurationTargetFunction, LinearMethodTargetFunction),
+// holding the sampling settings shared by all of them.
+class VMCTargetFunction: public nfm::NoisyFunctionWithGradient
+{
+protected:
+    VMC &_vmc; // the VMC object containing WaveFunction, Hamiltonian and MCI
+    const int64_t _E_Nmc; // number of MC steps for energy calculation
+    const int64_t _grad_E_Nmc; // number of MC steps for gradient calculation
+    const double _lambda_reg; // vp regularization factor
+
+    // target-error adaptive sampling (see setTargetErrors())
+    double _E_targetErr = 0.; // target error of the energy
+    double _grad_targetErr = 0.; // target error norm of the energy gradient
+    int _maxNmcFactor = 10; // at most this factor times E_Nmc/grad_E_Nmc steps are used
+
+    // sampling during the MPI reduction (see setOverlapSampling())
+    int64_t _overlapNchunk = 0; // MC steps per overlap chunk (0 = disabled)
+    double _warmFraction = 0.1; // fraction of the decorrelation steps used after warm reductions
+    int64_t _overlapSteps = 0; // MC steps sampled during the last reduction (on this rank)
+
+    OptimizerTelemetry * _telemetry = nullptr; // optional per-evaluation records (see setTelemetry())
+    OptimizerCheckpoint * _checkpoint = nullptr; // optional periodic checkpoints (see setCheckpoint())
+
+    VMCTargetFunction(VMC &vmc, int64_t E_Nmc, int64_t grad_E_Nmc, bool useGradErr, double lambda_reg):
+            nfm::NoisyFunctionWithGradient(vmc.getNVP(), useGradErr), _vmc(vmc),
+            _E_Nmc(E_Nmc), _grad_E_Nmc(grad_E_Nmc), _lambda_reg(lambda_reg) {}
+
+    // VMC::computeEnergyOverlapped with the overlap settings, popping the last npop observables before the overlap sampling.
+    // If doDecorrelation and the walkers of all ranks (collective) kept sampling for a full decorrelation phase during
+    // the last reduction, only a short decorrelation is performed (the walkers moved under the previous parameters).
+    void _computeEnergyOverlapped(const int64_t Nmc, double * obs, double * dobs, const int npop, const bool doDecorrelation)
+    {
+        mci::MCI &mci = _vmc.getMCI();
+        const int64_t ndecorr = mci.getNdecorrelationSteps();
+        bool warm = false;
+        if (doDecorrelation && ndecorr > 0) {
+            double ncold = (_overlapSteps >= ndecorr) ? 0. : 1.;
+            MPIVMC::AllreduceSum(&ncold, 1);
+            warm = (ncold == 0.);
+        }
+        if (warm) { mci.setNdecorrelationSteps(std::max<int64_t>(1, static_cast<int64_t>(std::ceil(_warmFraction*ndecorr)))); }
+        try {
+            _overlapSteps = _vmc.computeEnergyOverlapped(Nmc, _overlapNchunk, obs, dobs, npop, true, doDecorrelation);
+        }
+        catch (...) {
+            mci.setNdecorrelationSteps(ndecorr);
+            throw;
+        }
+        mci.setNdecorrelationSteps(ndecorr);
+    }
+
+    // to be called after every gradient evaluation at vp (one optimizer iteration)
+    void _checkpointIteration(const std::vector<double> &vp)
+    {
+        if (_checkpoint != nullptr) { _checkpoint->iterate(_vmc, vp); }
+    }
+
+public:
+    ~VMCTargetFunction() override = default;
+
+    // Enable target-error adaptive sampling (a value of 0 disables it, the default)
+    // If enabled, E_Nmc and grad_E_Nmc are only the initial sampling increments and sampling continues until the
+    // error of the total energy is at most E_targetErr, or the norm of the error vector of the energy gradient
+    // (or of the direction returned as gradient) is at most grad_targetErr, respectively.
+    // At most maxNmcFactor times E_Nmc/grad_E_Nmc steps are used.
+    void setTargetErrors(double E_targetErr, double grad_targetErr, int maxNmcFactor = 10)
+    {
+        if (E_targetErr < 0. || grad_targetErr < 0. || maxNmcFactor < 1) {
+            throw std::invalid_argument("[VMCTargetFunction::setTargetErrors] Target errors must be non-negative and maxNmcFactor positive.");
+        }
+        _E_targetErr = E_targetErr;
+        _grad_targetErr = grad_targetErr;
+        _maxNmcFactor = maxNmcFactor;
+    }
+    double getEnergyTargetError() const { return _E_targetErr; }
+    double getGradientTargetError() const { return _grad_targetErr; }
+    int getMaxNmcFactor() const { return _maxNmcFactor; }
+
+    // Overlap the MPI reduction of every evaluation with continued sampling (a value of 0 disables it, the default)
+    // If enabled, every rank keeps moving its walkers in chunks of Nchunk MC steps (with temporary gradient
+    // observables removed, results discarded) until the non-blocking reduction completed. If these steps add up
+    // to a full decorrelation phase on all ranks, the next evaluation decorrelates only for warmFraction of the
+    // decorrelation steps (under the new parameters). Target-error adaptive sampling takes precedence, because
+    // it needs the reduced errors to decide on every increment.
+    virtual void setOverlapSampling(int64_t Nchunk, double warmFraction = 0.1)
+    {
+        if (Nchunk < 0 || warmFraction <= 0. || warmFraction > 1.) {
+            throw std::invalid_argument("[VMCTargetFunction::setOverlapSampling] Nchunk must be non-negative and warmFraction within (0, 1].");
+        }
+        _overlapNchunk = Nchunk;
+        _warmFraction = warmFraction;
+        _overlapSteps = 0;
+    }
+    int64_t getOverlapSampling() const { return _overlapNchunk; }
+    double getOverlapWarmFraction() const { return _warmFraction; }
+    int64_t getLastOverlapSteps() const { return _overlapSteps; }
+
+    // Stream a telemetry record for every evaluation to telemetry (nullptr disables it, the default)
+    void setTelemetry(OptimizerTelemetry * telemetry) { _telemetry = telemetry; }
+
+    // Count every gradient evaluation as optimizer iteration of checkpoint (nullptr disables it, the default),
+    // which then periodically stores the VMC and the evaluated parameters (see OptimizerCheckpoint)
+    void setCheckpoint(OptimizerCheckpoint * checkpoint) { _checkpoint = checkpoint; }
+};
+} // namespace vmc
+
+#endif
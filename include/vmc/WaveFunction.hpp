@@ -2,8 +2,10 @@
 #define VMC_WAVEFUNCTION_HPP
 
 #include "mci/SamplingFunctionInterface.hpp"
+#include "vmc/Profiler.hpp"
 
 #include <iostream>
+#include <memory>
 
 namespace vmc
 {
@@ -79,6 +81,11 @@ public:
     int getNPart() const { return _npart; }
     int getNVP() const { return _nvp; }
 
+    // Clone as WaveFunction, with the same variational parameters. Composite wave functions implement _clone()
+    // as deep copy (cloning their components and pseudopotentials), so the clone shares no mutable state
+    // with the original and can be used concurrently, e.g. one per thread.
+    std::unique_ptr<WaveFunction> cloneWaveFunction() const;
+
 
     // --- interface for manipulating the variational parameters
     virtual void setVP(const double * vp) = 0;    // --- MUST BE IMPLEMENTED
@@ -99,6 +106,16 @@ public:
     // This method is also used to provide MCI's samplingFunction method.
     virtual double computeWFValue(const double * protovalues) const = 0;    // --- MUST BE IMPLEMENTED
 
+
+    // --- walker-batched evaluation
+    // Evaluate nwalkers configurations at once, in SoA layout: coordinate i of walker w is xs[i*nwalkers + w],
+    // and likewise for the outputs protovs[iproto*nwalkers + w], d1s/d2s[i*nwalkers + w] and vd1s[ivp*nwalkers + w]
+    // (vd1s may be nullptr, it is ignored without hasVD1()). The cross derivatives are not part of the batched API.
+    // The defaults loop over protoFunction/computeAllDerivatives (overwriting the stored derivatives),
+    // derived classes may override them to vectorize across the walkers (e.g. TwoBodyJastrow).
+    virtual void protoFunctionBatch(int nwalkers, const double * xs, double * protovs);
+    virtual void computeAllDerivativesBatch(int nwalkers, const double * xs, double * d1s, double * d2s, double * vd1s = nullptr);
+
     double samplingFunction(const double protovalues[]) const final
     { // mainly for use by certain MCI trial moves
         const double wfval = this->computeWFValue(protovalues);
@@ -107,6 +124,7 @@ public:
 
     void observationCallback(const double x[], const double /*protov*/[]) override
     {
+        VMC_PROFILE_SCOPE(ComputeAllDerivatives);
         this->computeAllDerivatives(x);
     }
 
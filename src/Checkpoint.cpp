@@ -0,0 +1,257 @@
+#include "vmc/Checkpoint.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Philox.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace vmc
+{
+
+namespace
+{
+const char MAGIC[8] = {'V', 'M', 'C', 'C', 'K', 'P', 'T', '\0'};
+
+template <typename T>
+void writePOD(std::ofstream &out, const T &val) { out.write(reinterpret_cast<const char *>(&val), sizeof(T)); }
+
+void writeVec(std::ofstream &out, const std::vector<double> &vec)
+{
+    writePOD(out, static_cast<uint64_t>(vec.size()));
+    out.write(reinterpret_cast<const char *>(vec.data()), static_cast<std::streamsize>(vec.size()*sizeof(double)));
+}
+
+template <typename T>
+T readPOD(std::ifstream &in)
+{
+    T val;
+    in.read(reinterpret_cast<char *>(&val), sizeof(T));
+    if (!in) { throw std::runtime_error("[Checkpoint::read] Unexpected end of file."); }
+    return val;
+}
+
+std::vector<double> readVec(std::ifstream &in)
+{
+    const auto n = readPOD<uint64_t>(in);
+    if (n > (1ull << 32)) { throw std::runtime_error("[Checkpoint::read] Corrupted vector size."); }
+    std::vector<double> vec(n);
+    in.read(reinterpret_cast<char *>(vec.data()), static_cast<std::streamsize>(n*sizeof(double)));
+    if (!in) { throw std::runtime_error("[Checkpoint::read] Unexpected end of file."); }
+    return vec;
+}
+} // namespace
+
+constexpr uint32_t Checkpoint::VERSION;
+
+
+// --- Capture
+
+void Checkpoint::addVMC(VMC &vmc, const uint64_t seed)
+{
+    VMCState state;
+    state.seed = seed;
+    state.vp.resize(static_cast<size_t>(vmc.getNVP()));
+    vmc.getVP(state.vp.data());
+    const int ndim = vmc.getNTotalDim();
+    for (int i = 0; i < ndim; ++i) {
+        state.x.push_back(vmc.getMCI().getX(i));
+        state.mrt2step.push_back(vmc.getMCI().getMRT2Step(i));
+    }
+    _vmcs.push_back(std::move(state));
+}
+
+void Checkpoint::addSampler(const ConfigurationSampler &sampler)
+{
+    SamplerState state;
+    state.seed = sampler.getRNG().getSeed();
+    state.stream = sampler.getRNG().getStream();
+    state.position = sampler.getRNG().getPosition();
+    state.step = sampler.getStepSize();
+    state.x.assign(sampler.getX(), sampler.getX() + sampler.getNDim());
+    _samplers.push_back(std::move(state));
+}
+
+void Checkpoint::setOptimizerState(const int64_t iteration, const std::vector<double> &x, const std::vector<double> &extra)
+{
+    _opt_iter = iteration;
+    _opt_x = x;
+    _opt_extra = extra;
+}
+
+void Checkpoint::clear()
+{
+    _vmcs.clear();
+    _samplers.clear();
+    _opt_iter = 0;
+    _opt_x.clear();
+    _opt_extra.clear();
+}
+
+
+// --- Restore
+
+void Checkpoint::restoreVMC(const int i, VMC &vmc) const
+{
+    if (i < 0 || i >= this->getNVMC()) {
+        throw std::invalid_argument("[Checkpoint::restoreVMC] Invalid VMC index.");
+    }
+    const VMCState &state = _vmcs[i];
+    if (static_cast<int>(state.vp.size()) != vmc.getNVP() || static_cast<int>(state.x.size()) != vmc.getNTotalDim()) {
+        throw std::invalid_argument("[Checkpoint::restoreVMC] Stored state doesn't match the passed VMC's dimensions.");
+    }
+    vmc.setVP(state.vp.data());
+    vmc.getMCI().setX(state.x.data());
+    for (size_t j = 0; j < state.mrt2step.size(); ++j) {
+        vmc.getMCI().setMRT2Step(static_cast<int>(j), state.mrt2step[j]);
+    }
+
+    // reseed from (seed, rank, generation), such that a resumed run doesn't repeat random numbers
+    Philox rng(state.seed, Philox::streamID(MPIVMC::MyRank()));
+    rng.discard(_generation);
+    vmc.getMCI().setSeed(rng());
+
+    vmc.skipNextEquilibration();
+}
+
+void Checkpoint::restoreSampler(const int i, ConfigurationSampler &sampler) const
+{
+    if (i < 0 || i >= this->getNSampler()) {
+        throw std::invalid_argument("[Checkpoint::restoreSampler] Invalid sampler index.");
+    }
+    const SamplerState &state = _samplers[i];
+    if (static_cast<int>(state.x.size()) != sampler.getNDim()) {
+        throw std::invalid_argument("[Checkpoint::restoreSampler] Stored state doesn't match the passed sampler's dimension.");
+    }
+    sampler.setSeed(state.seed, state.stream);
+    sampler.getRNG().discard(state.position);
+    sampler.setStepSize(state.step);
+    sampler.setX(state.x.data()); // recomputes the proto values
+}
+
+
+// --- File IO
+
+void Checkpoint::write(const std::string &filename)
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out) { throw std::runtime_error("[Checkpoint::write] Could not open file " + filename + "."); }
+
+    ++_generation;
+    out.write(MAGIC, sizeof(MAGIC));
+    writePOD(out, VERSION);
+    writePOD(out, _generation);
+
+    writePOD(out, static_cast<uint64_t>(_vmcs.size()));
+    for (const auto &state : _vmcs) {
+        writePOD(out, state.seed);
+        writeVec(out, state.vp);
+        writeVec(out, state.x);
+        writeVec(out, state.mrt2step);
+    }
+
+    writePOD(out, static_cast<uint64_t>(_samplers.size()));
+    for (const auto &state : _samplers) {
+        writePOD(out, state.seed);
+        writePOD(out, state.stream);
+        writePOD(out, state.position);
+        writePOD(out, state.step);
+        writeVec(out, state.x);
+    }
+
+    writePOD(out, _opt_iter);
+    writeVec(out, _opt_x);
+    writeVec(out, _opt_extra);
+
+    if (!out) { throw std::runtime_error("[Checkpoint::write] Failed writing to file " + filename + "."); }
+}
+
+void Checkpoint::read(const std::string &filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) { throw std::runtime_error("[Checkpoint::read] Could not open file " + filename + "."); }
+
+    char magic[sizeof(MAGIC)];
+    in.read(magic, sizeof(MAGIC));
+    if (!in || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("[Checkpoint::read] File " + filename + " is not a VMC checkpoint.");
+    }
+    const auto version = readPOD<uint32_t>(in);
+    if (version != VERSION) {
+        throw std::runtime_error("[Checkpoint::read] Unsupported checkpoint version " + std::to_string(version) + ".");
+    }
+
+    this->clear();
+    _generation = readPOD<uint64_t>(in);
+
+    const auto nvmc = readPOD<uint64_t>(in);
+    for (uint64_t i = 0; i < nvmc; ++i) {
+        VMCState state;
+        state.seed = readPOD<uint64_t>(in);
+        state.vp = readVec(in);
+        state.x = readVec(in);
+        state.mrt2step = readVec(in);
+        _vmcs.push_back(std::move(state));
+    }
+
+    const auto nsampler = readPOD<uint64_t>(in);
+    for (uint64_t i = 0; i < nsampler; ++i) {
+        SamplerState state;
+        state.seed = readPOD<uint64_t>(in);
+        state.stream = readPOD<uint64_t>(in);
+        state.position = readPOD<uint64_t>(in);
+        state.step = readPOD<double>(in);
+        state.x = readVec(in);
+        _samplers.push_back(std::move(state));
+    }
+
+    _opt_iter = readPOD<int64_t>(in);
+    _opt_x = readVec(in);
+    _opt_extra = readVec(in);
+}
+
+
+// --- OptimizerCheckpoint
+
+OptimizerCheckpoint::OptimizerCheckpoint(const std::string &filename, const int interval, const uint64_t seed):
+        _filename((MPIVMC::Size() > 1) ? filename + "." + std::to_string(MPIVMC::MyRank()) : filename),
+        _interval(interval), _seed(seed)
+{
+    if (interval < 0) { throw std::invalid_argument("[OptimizerCheckpoint] interval must be non-negative."); }
+}
+
+bool OptimizerCheckpoint::resume(VMC &vmc)
+{
+    double nexist = std::ifstream(_filename).good() ? 1. : 0.;
+    MPIVMC::AllreduceSum(&nexist, 1);
+    if (nexist == 0.) { return false; }
+    if (nexist < MPIVMC::Size()) {
+        throw std::runtime_error("[OptimizerCheckpoint::resume] Checkpoint files exist only for some of the ranks.");
+    }
+
+    _checkpoint.read(_filename);
+    if (_checkpoint.getNVMC() != 1 || static_cast<int>(_checkpoint.getOptimizerX().size()) != vmc.getNVP()) {
+        throw std::runtime_error("[OptimizerCheckpoint::resume] Checkpoint " + _filename + " doesn't match the optimization.");
+    }
+    _checkpoint.restoreVMC(0, vmc);
+    _iteration = _checkpoint.getOptimizerIteration();
+    return true;
+}
+
+bool OptimizerCheckpoint::iterate(VMC &vmc, const std::vector<double> &x, const std::vector<double> &extra)
+{
+    ++_iteration;
+    if (_interval == 0 || _iteration%_interval != 0) { return false; }
+
+    _checkpoint.clear();
+    _checkpoint.addVMC(vmc, _seed);
+    _checkpoint.setOptimizerState(_iteration, x, extra);
+    const std::string tmpname = _filename + ".tmp";
+    _checkpoint.write(tmpname);
+    if (std::rename(tmpname.c_str(), _filename.c_str()) != 0) {
+        throw std::runtime_error("[OptimizerCheckpoint::iterate] Failed to replace checkpoint " + _filename + ".");
+    }
+    return true;
+}
+} // namespace vmc
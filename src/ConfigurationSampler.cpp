@@ -0,0 +1,100 @@
+#include "vmc/ConfigurationSampler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vmc
+{
+
+ConfigurationSampler::ConfigurationSampler(WaveFunction &wf, const uint64_t seed, const double step):
+        _wf(wf), _ndim(wf.getTotalNDim()),
+        _x(static_cast<size_t>(_ndim), 0.), _xnew(static_cast<size_t>(_ndim), 0.),
+        _protoold(static_cast<size_t>(wf.getNProto()), 0.), _protonew(static_cast<size_t>(wf.getNProto()), 0.),
+        _step(step), _rgen(seed), _rd(-1., 1.), _nacc(0), _nrej(0)
+{
+    refreshProtoValues();
+}
+
+
+void ConfigurationSampler::setX(const double * const x)
+{
+    std::copy(x, x + _ndim, _x.begin());
+    refreshProtoValues();
+}
+
+void ConfigurationSampler::refreshProtoValues()
+{
+    _wf.protoFunction(_x.data(), _protoold.data());
+}
+
+
+bool ConfigurationSampler::step()
+{
+    for (int i = 0; i < _ndim; ++i) {
+        _xnew[i] = _x[i] + _step*_rd(_rgen);
+    }
+    double acc;
+    { // explicit scopes, to also profile wave functions without own instrumentation
+        VMC_PROFILE_SCOPE(ProtoFunction);
+        _wf.protoFunction(_xnew.data(), _protonew.data());
+    }
+    {
+        VMC_PROFILE_SCOPE(AcceptanceFunction);
+        acc = _wf.acceptanceFunction(_protoold.data(), _protonew.data());
+    }
+    if (acc >= 1. || 0.5*(_rd(_rgen) + 1.) < acc) {
+        std::swap(_x, _xnew);
+        std::swap(_protoold, _protonew);
+        ++_nacc;
+        return true;
+    }
+    ++_nrej;
+    return false;
+}
+
+void ConfigurationSampler::tuneStepSize(const int niter, const int nsteps, const double targetrate)
+{
+    for (int it = 0; it < niter; ++it) {
+        this->resetAcceptanceRate();
+        for (int i = 0; i < nsteps; ++i) { this->step(); }
+        // scale the step proportionally to the acceptance mismatch, but limit the change per iteration
+        const double fac = std::max(0.5, std::min(2., this->getAcceptanceRate()/targetrate));
+        _step *= fac;
+    }
+    this->resetAcceptanceRate();
+}
+
+void ConfigurationSampler::decorrelate(const int64_t nsteps)
+{
+    for (int64_t i = 0; i < nsteps; ++i) { this->step(); }
+}
+
+void ConfigurationSampler::sample(const int64_t nconf, const int nskip, std::vector<double> &confs, std::vector<double> * const protos)
+{
+    const auto nproto = static_cast<int64_t>(_protoold.size());
+    confs.reserve(confs.size() + nconf*_ndim);
+    if (protos != nullptr) { protos->reserve(protos->size() + nconf*nproto); }
+    for (int64_t i = 0; i < nconf; ++i) {
+        for (int j = 0; j < nskip; ++j) { this->step(); }
+        confs.insert(confs.end(), _x.begin(), _x.end());
+        if (protos != nullptr) { protos->insert(protos->end(), _protoold.begin(), _protoold.end()); }
+    }
+}
+
+void ConfigurationSampler::record(const int64_t nconf, const int nskip, TrajectoryWriter &writer, Hamiltonian * const H)
+{
+    const int nobs = (H != nullptr) ? 4 : 0;
+    if (writer.getNDim() != _ndim || writer.getNProto() != static_cast<int>(_protoold.size()) || writer.getNObs() != nobs) {
+        throw std::invalid_argument("[ConfigurationSampler::record] Record layout of the TrajectoryWriter doesn't match.");
+    }
+    double eloc[4];
+    for (int64_t i = 0; i < nconf; ++i) {
+        for (int j = 0; j < nskip; ++j) { this->step(); }
+        if (H != nullptr) {
+            _wf.computeAllDerivatives(_x.data());
+            H->observableFunction(_x.data(), eloc);
+        }
+        writer.append(_x.data(), _protoold.data(), eloc);
+    }
+}
+} // namespace vmc
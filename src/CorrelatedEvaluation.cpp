@@ -0,0 +1,218 @@
+#include "vmc/CorrelatedEvaluation.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Reweighting.hpp"
+
+#include "mci/ObservableFunctionInterface.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace vmc
+{
+
+// Evaluates the candidates on the samples of the guide chain, the values are accumulated by MCI (see header)
+class CorrelatedEvaluation::Observable: public mci::ObservableFunctionInterface
+{
+protected:
+    CorrelatedEvaluation * const _owner;
+
+    mci::ObservableFunctionInterface * _clone() const final
+    {
+        return new Observable(_ndim, _nobs, _owner);
+    }
+
+public:
+    Observable(int ntotaldim, int nvalues, CorrelatedEvaluation * owner):
+            mci::ObservableFunctionInterface(ntotaldim, nvalues, false), _owner(owner) {}
+
+    void observableFunction(const double in[], double out[]) final { _owner->_computeValues(in, out); }
+};
+
+
+CorrelatedEvaluation::CorrelatedEvaluation(VMC &vmc, const int64_t blocksize):
+        _vmc(vmc), _blocksize(1), _guide(vmc.getWF().cloneWaveFunction())
+{
+    this->setBlockSize(blocksize);
+}
+
+CorrelatedEvaluation::~CorrelatedEvaluation() = default;
+
+void CorrelatedEvaluation::setBlockSize(const int64_t blocksize)
+{
+    if (blocksize < 1) { throw std::invalid_argument("[CorrelatedEvaluation] blocksize must be positive."); }
+    _blocksize = blocksize;
+}
+
+int CorrelatedEvaluation::addCandidate(const WaveFunction &wf, const Hamiltonian &H)
+{
+    if (wf.getTotalNDim() != _vmc.getNTotalDim() || H.getTotalNDim() != _vmc.getNTotalDim()) {
+        throw std::invalid_argument("[CorrelatedEvaluation::addCandidate] Dimension of wf or H doesn't match the guide.");
+    }
+    _wfs.push_back(wf.cloneWaveFunction());
+    _Hs.push_back(H.cloneHamiltonian());
+    _Hs.back()->bindWaveFunction(_wfs.back().get());
+    _obs.clear(); // results of previous evaluations are invalid
+    _dobs.clear();
+    _nsamples = 0;
+    return this->getNCandidates() - 1;
+}
+
+
+int CorrelatedEvaluation::_nvalues() const
+{
+    const int ncand = this->getNCandidates();
+    return ncand*NVALUES + 2*ncand*(ncand - 1);
+}
+
+size_t CorrelatedEvaluation::_pairOffset(const int k, const int l) const
+{
+    const auto ncand = _wfs.size();
+    const auto uk = static_cast<size_t>(k), ul = static_cast<size_t>(l);
+    const size_t ipair = uk*(2*ncand - uk - 1)/2 + (ul - uk - 1); // index of (k, l) among the pairs k < l
+    return ncand*NVALUES + 4*ipair;
+}
+
+double CorrelatedEvaluation::_cov(const size_t i, const size_t j, const size_t ij) const
+{
+    return 0.5*(_dobs[ij]*_dobs[ij] - _dobs[i]*_dobs[i] - _dobs[j]*_dobs[j]);
+}
+
+void CorrelatedEvaluation::_computeValues(const double * const x, double * const values)
+{
+    const int ncand = this->getNCandidates();
+    _guide->protoFunction(x, _proto.data());
+    const double psig = _guide->computeWFValue(_proto.data());
+
+    double eloc[4];
+    for (int k = 0; k < ncand; ++k) {
+        WaveFunction &wf = *_wfs[k];
+        wf.protoFunction(x, _proto.data());
+        const double ratio = wf.computeWFValue(_proto.data())/psig;
+        const double w = ratio*ratio;
+        wf.computeAllDerivatives(x);
+        _Hs[k]->observableFunction(x, eloc);
+
+        double * const kvalues = values + k*NVALUES;
+        kvalues[0] = w;
+        kvalues[1] = w*w;
+        for (int c = 0; c < 4; ++c) {
+            kvalues[2 + c] = w*eloc[c];
+            kvalues[6 + c] = w*eloc[c] + w;
+        }
+    }
+    for (int k = 0; k < ncand; ++k) { // sums of the total energy values of all pairs
+        const double Ak = values[k*NVALUES + 2], Bk = values[k*NVALUES];
+        for (int l = k + 1; l < ncand; ++l) {
+            const double Al = values[l*NVALUES + 2], Bl = values[l*NVALUES];
+            double * const pvalues = values + this->_pairOffset(k, l);
+            pvalues[0] = Ak + Al;
+            pvalues[1] = Ak + Bl;
+            pvalues[2] = Bk + Al;
+            pvalues[3] = Bk + Bl;
+        }
+    }
+}
+
+
+void CorrelatedEvaluation::evaluate(const int64_t Nmc, double * const guideE, double * const guideDE, const bool doFindMRT2step, const bool doDecorrelation)
+{
+    const int ncand = this->getNCandidates();
+    if (ncand == 0) { throw std::runtime_error("[CorrelatedEvaluation::evaluate] No candidates added."); }
+
+    // the guide clone follows the current parameters of the VMC
+    std::vector<double> vp(static_cast<size_t>(_vmc.getNVP()));
+    _vmc.getVP(vp.data());
+    _guide->setVP(vp.data());
+
+    int nproto = _guide->getNProto();
+    for (const auto &wf : _wfs) { nproto = std::max(nproto, wf->getNProto()); }
+    _proto.resize(static_cast<size_t>(nproto));
+
+    // sample with the candidates' observable added (MCI clones it, the clone still points to this), with block
+    // averages and their plain variance, which is bilinear as needed for the covariances
+    mci::MCI &mci = _vmc.getMCI();
+    const int nvalues = this->_nvalues();
+    mci.addObservable(Observable(_vmc.getNTotalDim(), nvalues, this), static_cast<int>(_blocksize), _vmc.getNSkipEG(), false, false);
+    const int nobs = mci.getNObsDim(); // the guide's energies first, our values last
+    _obs.assign(static_cast<size_t>(nobs), 0.);
+    _dobs.assign(_obs.size(), 0.);
+    try {
+        _vmc.computeEnergyUnreduced(Nmc, _obs.data(), _dobs.data(), doFindMRT2step, doDecorrelation);
+    }
+    catch (...) {
+        mci.popObservable();
+        _obs.clear();
+        _dobs.clear();
+        throw;
+    }
+    mci.popObservable();
+    MPIVMC::ReduceResults(_obs.data(), _dobs.data(), nobs); // averages over ranks, errors as independent
+    _nsamples = MPIVMC::Size()*((Nmc/MPIVMC::Size())/_vmc.getNSkipEG()); // see VMC::computeEnergyUnreduced
+
+    if (guideE != nullptr) { std::copy(_obs.begin(), _obs.begin() + 4, guideE); }
+    if (guideDE != nullptr) { std::copy(_dobs.begin(), _dobs.begin() + 4, guideDE); }
+    _obs.erase(_obs.begin(), _obs.end() - nvalues); // keep the candidates' values only
+    _dobs.erase(_dobs.begin(), _dobs.end() - nvalues);
+}
+
+
+void CorrelatedEvaluation::getEnergy(const int k, double * const E, double * const dE) const
+{
+    if (k < 0 || k >= this->getNCandidates() || _obs.empty()) {
+        throw std::invalid_argument("[CorrelatedEvaluation::getEnergy] Invalid candidate index or no evaluation yet.");
+    }
+    const size_t iw = static_cast<size_t>(k)*NVALUES;
+    for (int c = 0; c < 4; ++c) {
+        const size_t iA = iw + 2 + c;
+        E[c] = _obs[iA]/_obs[iw];
+        dE[c] = ratioEstimatorError(E[c], _obs[iw], _dobs[iA]*_dobs[iA], this->_cov(iA, iw, iw + 6 + c), _dobs[iw]*_dobs[iw]);
+    }
+}
+
+void CorrelatedEvaluation::getEnergyDifference(const int k, const int l, double &diff, double &ddiff) const
+{
+    if (k < 0 || k >= this->getNCandidates() || l < 0 || l >= this->getNCandidates() || _obs.empty()) {
+        throw std::invalid_argument("[CorrelatedEvaluation::getEnergyDifference] Invalid candidate index or no evaluation yet.");
+    }
+    if (k == l) {
+        diff = 0.;
+        ddiff = 0.;
+        return;
+    }
+    // covariance matrix of the averages v = (A_k, B_k, A_l, B_l)
+    const size_t ik = static_cast<size_t>(k)*NVALUES, il = static_cast<size_t>(l)*NVALUES;
+    const size_t iv[4] = {ik + 2, ik, il + 2, il};
+    const size_t ip = this->_pairOffset(std::min(k, l), std::max(k, l));
+    const size_t ipair[2][2] = {{ip, ip + 1}, {ip + 2, ip + 3}}; // [A_min/B_min][A_max/B_max]
+    double cov[4][4];
+    for (int a = 0; a < 2; ++a) {
+        for (int b = 0; b < 2; ++b) {
+            cov[a][b] = (a == b) ? _dobs[iv[a]]*_dobs[iv[a]] : this->_cov(iv[0], iv[1], ik + 6);
+            cov[2 + a][2 + b] = (a == b) ? _dobs[iv[2 + a]]*_dobs[iv[2 + a]] : this->_cov(iv[2], iv[3], il + 6);
+            const size_t ij = (k < l) ? ipair[a][b] : ipair[b][a];
+            cov[a][2 + b] = cov[2 + b][a] = this->_cov(iv[a], iv[2 + b], ij);
+        }
+    }
+    const double Ek = _obs[ik + 2]/_obs[ik];
+    const double El = _obs[il + 2]/_obs[il];
+
+    // linearized: delta = (A_k - Ek*B_k)/W_k - (A_l - El*B_l)/W_l = g^T v
+    const double g[4] = {1./_obs[ik], -Ek/_obs[ik], -1./_obs[il], El/_obs[il]};
+    double var = 0.;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) { var += g[i]*cov[i][j]*g[j]; }
+    }
+    diff = Ek - El;
+    ddiff = (var > 0.) ? sqrt(var) : 0.;
+}
+
+double CorrelatedEvaluation::getESS(const int k) const
+{
+    if (k < 0 || k >= this->getNCandidates() || _obs.empty()) {
+        throw std::invalid_argument("[CorrelatedEvaluation::getESS] Invalid candidate index or no evaluation yet.");
+    }
+    const size_t iw = static_cast<size_t>(k)*NVALUES;
+    return _nsamples*effectiveSampleSize(_obs[iw], _obs[iw + 1]); // averages instead of sums
+}
+} // namespace vmc
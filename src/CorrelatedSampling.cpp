@@ -0,0 +1,148 @@
+#include "vmc/CorrelatedSampling.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Reweighting.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace vmc
+{
+
+CorrelatedSampling::CorrelatedSampling(VMC &vmc, const int64_t nconf, const int nskip, const uint_fast64_t seed):
+        _wf(vmc.getWF().cloneWaveFunction()), _H(vmc.getH().cloneHamiltonian()),
+        _sampler(*_wf, seed),
+        _nvp(vmc.getNVP()), _nconf(nconf), _nskip(nskip),
+        _vp_ref(static_cast<size_t>(vmc.getNVP()))
+{
+    if (_nconf < 1 || _nskip < 1) {
+        throw std::invalid_argument("[CorrelatedSampling] nconf and nskip must be positive.");
+    }
+    _H->bindWaveFunction(_wf.get());
+    _sampler.setSeed(seed, Philox::streamID(MPIVMC::MyRank())); // independent stream per rank
+    vmc.getVP(_vp_ref.data());
+
+    // start from the current walker position of the VMC's integrator
+    const int ndim = vmc.getNTotalDim();
+    double x[ndim];
+    for (int i = 0; i < ndim; ++i) { x[i] = vmc.getMCI().getX(i); }
+    _sampler.setX(x);
+}
+
+
+void CorrelatedSampling::sample(const double * const vp)
+{
+    std::copy(vp, vp + _nvp, _vp_ref.begin());
+    this->sample();
+}
+
+void CorrelatedSampling::sample()
+{
+    _wf->setVP(_vp_ref.data());
+    _sampler.refreshProtoValues();
+
+    // equilibrate the walker at the reference parameters
+    _sampler.tuneStepSize();
+    _sampler.decorrelate(_ndecorr);
+
+    // store new configurations and their reference proto values
+    _confs.clear();
+    _protos.clear();
+    _sampler.sample(_nconf, _nskip, _confs, &_protos);
+    ++_nsample;
+}
+
+
+double CorrelatedSampling::_evaluate(const double * const vp, double * const E, double * const dE)
+{
+    const int ndim = _wf->getTotalNDim();
+    const int nproto = _wf->getNProto();
+    const auto nconf = static_cast<size_t>(_nconf);
+
+    _weights.resize(nconf);
+    _elocs.resize(4*nconf);
+    _wf->setVP(vp);
+
+    // sums[0] = sum w, sums[1] = sum w^2, then 4 each of sum w*e, sum w^2*e, sum w^2*e^2
+    double sums[14];
+    std::fill(sums, sums + 14, 0.);
+    double protonew[nproto];
+    for (size_t i = 0; i < nconf; ++i) {
+        const double * const x = _confs.data() + i*ndim;
+        double * const eloc = _elocs.data() + 4*i;
+        const double w = reweightingFactor(*_wf, x, _protos.data() + i*nproto, protonew);
+        _wf->computeAllDerivatives(x);
+        _H->observableFunction(x, eloc);
+
+        _weights[i] = w;
+        sums[0] += w;
+        sums[1] += w*w;
+        for (int k = 0; k < 4; ++k) {
+            sums[2 + k] += w*eloc[k];
+            sums[6 + k] += w*w*eloc[k];
+            sums[10 + k] += w*w*eloc[k]*eloc[k];
+        }
+    }
+    MPIVMC::AllreduceSum(sums, 14);
+
+    // reweighted averages and errors (linearized ratio estimator of independent samples A = w*e, B = w)
+    for (int k = 0; k < 4; ++k) {
+        E[k] = sums[2 + k]/sums[0];
+        dE[k] = ratioEstimatorError(E[k], sums[0], sums[10 + k], sums[6 + k], sums[1]);
+    }
+    return effectiveSampleSize(sums[0], sums[1]);
+}
+
+
+void CorrelatedSampling::computeEnergy(const double * const vp, double * const E, double * const dE)
+{
+    if (_nsample == 0) { this->sample(); }
+    _ess = this->_evaluate(vp, E, dE);
+    if (_ess < _min_ess_ratio*_nconf*MPIVMC::Size()) { // reweighting became too inefficient
+        this->sample(vp);
+        _ess = this->_evaluate(vp, E, dE);
+    }
+}
+
+
+void CorrelatedSampling::computeEnergyDifference(const double * const vp1, const double * const vp2, double &diff, double &ddiff)
+{
+    const auto nconf = static_cast<size_t>(_nconf);
+    double E1[4], dE1[4], E2[4], dE2[4];
+    std::vector<double> w1, e1;
+
+    if (_nsample == 0) { this->sample(); }
+    for (int itry = 0; itry < 2; ++itry) {
+        const double ess1 = this->_evaluate(vp1, E1, dE1);
+        w1 = _weights;
+        e1.resize(nconf);
+        for (size_t i = 0; i < nconf; ++i) { e1[i] = _elocs[4*i]; }
+        const double ess2 = this->_evaluate(vp2, E2, dE2);
+        _ess = std::min(ess1, ess2);
+        if (itry > 0 || _ess >= _min_ess_ratio*_nconf*MPIVMC::Size()) { break; }
+
+        // resample in the middle between both parameter sets and try again
+        double vpm[_nvp];
+        for (int i = 0; i < _nvp; ++i) { vpm[i] = 0.5*(vp1[i] + vp2[i]); }
+        this->sample(vpm);
+    }
+
+    // normalizations
+    double wsums[2] = {0., 0.};
+    for (size_t i = 0; i < nconf; ++i) {
+        wsums[0] += w1[i];
+        wsums[1] += _weights[i];
+    }
+    MPIVMC::AllreduceSum(wsums, 2);
+
+    // linearized error of the difference, taking the correlation of both estimates into account
+    double var = 0.;
+    for (size_t i = 0; i < nconf; ++i) {
+        const double delta = w1[i]*(e1[i] - E1[0])/wsums[0] - _weights[i]*(_elocs[4*i] - E2[0])/wsums[1];
+        var += delta*delta;
+    }
+    MPIVMC::AllreduceSum(&var, 1);
+
+    diff = E1[0] - E2[0];
+    ddiff = sqrt(var);
+}
+} // namespace vmc
@@ -8,13 +8,23 @@ namespace vmc
 
 nfm::NoisyValue EnergyGradientTargetFunction::f(const std::vector<double> &vp)
 {
+    VMC_PROFILE_SCOPE(TargetFunction);
+    if (_telemetry != nullptr) { _telemetry->begin("gradient", "f"); }
     // set the variational parameters given as input
     _vmc.setVP(vp.data());
     // perform the integral and store the values
     double obs[4];
     double dobs[4];
-    _vmc.computeEnergy(_E_Nmc, obs, dobs, true, true);
-    MPIVMC::Integrate(_vmc.getMCI(), _E_Nmc, obs, dobs, true, true);
+    int64_t nmc = _E_Nmc;
+    if (_E_targetErr > 0.) {
+        nmc = _vmc.computeEnergyAdaptive(_E_targetErr, _E_Nmc, _maxNmcFactor*_E_Nmc, obs, dobs, true, true);
+    }
+    else if (_overlapNchunk > 0) {
+        this->_computeEnergyOverlapped(_E_Nmc, obs, dobs, 0, true);
+    }
+    else {
+        _vmc.computeEnergy(_E_Nmc, obs, dobs, true, true);
+    }
     nfm::NoisyValue f{obs[0], dobs[0]};
 
     if (_lambda_reg > 0.) { // compute the regularization term
@@ -22,6 +32,12 @@ nfm::NoisyValue EnergyGradientTargetFunction::f(const std::vector<double> &vp)
         f.val += _lambda_reg*norm/_vmc.getNVP();
     }
 
+    if (_telemetry != nullptr) {
+        _telemetry->current().nmc = nmc;
+        _telemetry->current().acceptance = _vmc.getMCI().getAcceptanceRate();
+        _telemetry->setResult(vp.data(), _vmc.getNVP(), f.val, f.err);
+        _telemetry->end();
+    }
     return f;
 }
 
@@ -34,18 +50,32 @@ void EnergyGradientTargetFunction::grad(const std::vector<double> &vp, nfm::Nois
 
 nfm::NoisyValue EnergyGradientTargetFunction::fgrad(const std::vector<double> &vp, nfm::NoisyGradient &grad)
 {
+    VMC_PROFILE_SCOPE(TargetFunction);
+    if (_telemetry != nullptr) { _telemetry->begin("gradient", "fgrad"); }
     const int nvp = _vmc.getNVP();
 
     // set the variational parameters given as input
     _vmc.setVP(vp.data());
     // add gradient obs to MCI
-    const int blocksize = this->hasGradErr() ? _vmc.getBlockSizeEG() : 0;
+    const int blocksize = (this->hasGradErr() || _grad_targetErr > 0.) ? _vmc.getBlockSizeEG() : 0;
     _vmc.getMCI().addObservable(EnergyGradientMCObservable(_vmc.getNTotalDim(), nvp), blocksize, _vmc.getNSkipEG(), false, blocksize > 0); // skipping equlibiration for gradients
     // perform the integral and store the values
     double obs[4 + 2*nvp];
     double dobs[4 + 2*nvp];
-    _vmc.computeEnergy(_grad_E_Nmc, obs, dobs, true, true);
-    _vmc.getMCI().popObservable(); // remove the gradient obs (it will be deleted)
+    int64_t nmc = _grad_E_Nmc;
+    if (_grad_targetErr > 0.) {
+        nmc = _vmc.computeEnergyAdaptive(_grad_targetErr, _grad_E_Nmc, _maxNmcFactor*_grad_E_Nmc, obs, dobs, true, true,
+                                   [nvp](const double * o, const double * d) { return energyGradientErrorNorm(nvp, o, d); });
+    }
+    else if (_overlapNchunk > 0) { // pops the gradient obs before the overlap sampling
+        this->_computeEnergyOverlapped(_grad_E_Nmc, obs, dobs, 1, true);
+    }
+    else {
+        _vmc.computeEnergy(_grad_E_Nmc, obs, dobs, true, true);
+    }
+    if (_overlapNchunk <= 0 || _grad_targetErr > 0.) {
+        _vmc.getMCI().popObservable(); // remove the gradient obs (it will be deleted)
+    }
     // create pointers for ease of use and readability
     const double * const H = obs;
     const double * const dH = dobs;
@@ -72,6 +102,13 @@ nfm::NoisyValue EnergyGradientTargetFunction::fgrad(const std::vector<double> &v
         for (int i = 0; i < nvp; ++i) { grad.val[i] -= 2.*fac*vp[i]; }
     }
 
+    if (_telemetry != nullptr) {
+        _telemetry->current().nmc = nmc;
+        _telemetry->current().acceptance = _vmc.getMCI().getAcceptanceRate();
+        _telemetry->setResult(vp.data(), nvp, f.val, f.err, grad.val.data(), this->hasGradErr() ? grad.err.data() : nullptr);
+        _telemetry->end();
+    }
+    this->_checkpointIteration(vp);
     return f;
 }
 } // namespace vmc
@@ -34,4 +34,55 @@ void EuclideanMetric::distD2(const double * r1, const double * r2, double * out)
         out[getNSpaceDim() + i] = (rpow2 - ripow2)/rpow3;
     }
 }
+
+
+void EuclideanMetric::distBatch(const int n, const double * r1s, const double * r2s, double * out)
+{
+    for (int k = 0; k < n; ++k) { out[k] = 0.; }
+    for (int i = 0; i < getNSpaceDim(); ++i) {
+        const double * const x1 = r1s + i*n;
+        const double * const x2 = r2s + i*n;
+        for (int k = 0; k < n; ++k) {
+            const double dx = x1[k] - x2[k];
+            out[k] += dx*dx;
+        }
+    }
+    for (int k = 0; k < n; ++k) { out[k] = sqrt(out[k]); }
+}
+
+void EuclideanMetric::distD1Batch(const int n, const double * r1s, const double * r2s, double * out)
+{
+    _rbuf.resize(static_cast<size_t>(n));
+    double * const invr = _rbuf.data();
+    distBatch(n, r1s, r2s, invr);
+    for (int k = 0; k < n; ++k) { invr[k] = 1./invr[k]; }
+    for (int i = 0; i < getNSpaceDim(); ++i) {
+        const double * const x1 = r1s + i*n;
+        const double * const x2 = r2s + i*n;
+        double * const out1 = out + i*n;
+        double * const out2 = out + (getNSpaceDim() + i)*n;
+        for (int k = 0; k < n; ++k) {
+            out1[k] = (x1[k] - x2[k])*invr[k];
+            out2[k] = -out1[k];
+        }
+    }
+}
+
+void EuclideanMetric::distD2Batch(const int n, const double * r1s, const double * r2s, double * out)
+{
+    _rbuf.resize(static_cast<size_t>(n));
+    double * const r = _rbuf.data();
+    distBatch(n, r1s, r2s, r);
+    for (int i = 0; i < getNSpaceDim(); ++i) {
+        const double * const x1 = r1s + i*n;
+        const double * const x2 = r2s + i*n;
+        double * const out1 = out + i*n;
+        double * const out2 = out + (getNSpaceDim() + i)*n;
+        for (int k = 0; k < n; ++k) {
+            const double dx = x1[k] - x2[k];
+            out1[k] = (r[k]*r[k] - dx*dx)/(r[k]*r[k]*r[k]);
+            out2[k] = out1[k];
+        }
+    }
+}
 } // namespace vmc
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "vmc/HardwareCounters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+namespace vmc
+{
+
+namespace
+{
+const int NEVENTS = HardwareCounters::NEVENTS;
+
+#ifdef __linux__
+const uint64_t EVENT_CONFIGS[NEVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// the counter group of one thread
+class ThreadGroup
+{
+private:
+    int _fds[NEVENTS]; // -1 if not available
+    int _index[NEVENTS]; // position of the event in the group read, -1 if not available
+    int _nopen = 0;
+    int _leader = -1;
+
+    static int _open(const uint64_t config, const int group_fd)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = (group_fd == -1) ? 1 : 0; // the leader starts the whole group
+        attr.exclude_kernel = 1; // allows counting with perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */, group_fd, 0));
+    }
+
+public:
+    ThreadGroup()
+    {
+        for (int i = 0; i < NEVENTS; ++i) {
+            _fds[i] = _open(EVENT_CONFIGS[i], _leader);
+            _index[i] = -1;
+            if (_fds[i] >= 0) {
+                _index[i] = _nopen++;
+                if (_leader == -1) { _leader = _fds[i]; }
+            }
+        }
+        if (_leader != -1) {
+            ioctl(_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    ~ThreadGroup()
+    {
+        for (const int fd : _fds) {
+            if (fd >= 0) { close(fd); }
+        }
+    }
+
+    ThreadGroup(const ThreadGroup &) = delete;
+    ThreadGroup &operator=(const ThreadGroup &) = delete;
+
+    bool isAvailable(const int i) const { return _fds[i] >= 0; }
+    bool isAvailable() const { return _leader != -1; }
+
+    bool read(int64_t * counts) const
+    {
+        for (int i = 0; i < NEVENTS; ++i) { counts[i] = -1; }
+        if (_leader == -1) { return false; }
+
+        uint64_t buf[3 + NEVENTS]; // nr, time_enabled, time_running, values
+        if (::read(_leader, buf, sizeof(buf)) < static_cast<ssize_t>((3 + _nopen)*sizeof(uint64_t))) { return false; }
+        // extrapolate if the group was not always on the PMU
+        const double scale = (buf[2] > 0 && buf[2] < buf[1]) ? static_cast<double>(buf[1])/buf[2] : 1.;
+        for (int i = 0; i < NEVENTS; ++i) {
+            if (_index[i] >= 0) { counts[i] = static_cast<int64_t>(scale*buf[3 + _index[i]]); }
+        }
+        return true;
+    }
+};
+
+const ThreadGroup &threadGroup()
+{
+    thread_local ThreadGroup group;
+    return group;
+}
+#endif
+} // namespace
+
+constexpr int HardwareCounters::NEVENTS;
+
+
+const char * HardwareCounters::getEventName(const HardwareEvent event)
+{
+    switch (event) {
+    case HardwareEvent::Cycles:
+        return "cycles";
+    case HardwareEvent::Instructions:
+        return "instructions";
+    case HardwareEvent::CacheMisses:
+        return "cacheMisses";
+    case HardwareEvent::BranchMisses:
+        return "branchMisses";
+    default:
+        return "unknown";
+    }
+}
+
+bool HardwareCounters::isAvailable(const HardwareEvent event)
+{
+#ifdef __linux__
+    return threadGroup().isAvailable(static_cast<int>(event));
+#else
+    (void) event;
+    return false;
+#endif
+}
+
+bool HardwareCounters::isAvailable()
+{
+#ifdef __linux__
+    return threadGroup().isAvailable();
+#else
+    return false;
+#endif
+}
+
+bool HardwareCounters::read(int64_t * counts)
+{
+#ifdef __linux__
+    return threadGroup().read(counts);
+#else
+    for (int i = 0; i < NEVENTS; ++i) { counts[i] = -1; }
+    return false;
+#endif
+}
+} // namespace vmc
@@ -0,0 +1,200 @@
+#include "vmc/LinearMethodTargetFunction.hpp"
+#include "vmc/LinearMethodMCObservable.hpp"
+#include "vmc/EnergyGradientMCObservable.hpp"
+
+#include <gsl/gsl_complex.h>
+#include <gsl/gsl_eigen.h>
+
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace vmc
+{
+
+LinearMethodTargetFunction::LinearMethodTargetFunction(VMC &vmc, const int64_t E_Nmc, const int64_t grad_E_Nmc, const bool useGradErr, const double lambda_reg, const double stabilization):
+        VMCTargetFunction(vmc, E_Nmc, grad_E_Nmc, useGradErr, lambda_reg), _stabilization(stabilization)
+{
+    if (!_vmc.getWF().hasVD1() || !_vmc.getWF().hasD2VD1()) {
+        throw std::invalid_argument("[LinearMethodTargetFunction] The WaveFunction must provide the VD1 and D2VD1 derivatives.");
+    }
+}
+
+
+void LinearMethodTargetFunction::_integrate(const double * const vp, double * const obs, double * const dobs, const bool flag_grad, const bool flag_dgrad)
+{
+    // set the variational parameters given as input
+    _vmc.setVP(vp);
+
+    // set up the MC integrator
+    if (flag_grad) { // add linear method obs if necessary
+        // skip MC error for grad if flag_dgrad is false (and we don't sample adaptively)
+        const int blocksize = (flag_dgrad || _grad_targetErr > 0.) ? _vmc.getBlockSizeEG() : 0;
+        _vmc.getMCI().addObservable(LinearMethodMCObservable(_vmc.getNTotalDim(), _vmc.getNVP()),
+                                    blocksize, _vmc.getNSkipEG(), false, blocksize > 0);
+    }
+
+    // perform the integral and store the values (skip extra burning phase on gradient runs (only findMRT2))
+    const double targetErr = flag_grad ? _grad_targetErr : _E_targetErr;
+    int64_t nmc = flag_grad ? _grad_E_Nmc : _E_Nmc;
+    if (targetErr > 0.) {
+        const int64_t Ninit = flag_grad ? _grad_E_Nmc : _E_Nmc;
+        const int nvp = _vmc.getNVP();
+        std::function<double(const double *, const double *)> errfun; // defaults to the energy error
+        if (flag_grad) { errfun = [nvp](const double * o, const double * d) { return energyGradientErrorNorm(nvp, o, d); }; }
+        nmc = _vmc.computeEnergyAdaptive(targetErr, Ninit, _maxNmcFactor*Ninit, obs, dobs, true, !flag_grad, errfun);
+    }
+    else if (_overlapNchunk > 0) { // pops the linear method obs before the overlap sampling
+        this->_computeEnergyOverlapped(nmc, obs, dobs, flag_grad ? 1 : 0, !flag_grad);
+    }
+    else {
+        _vmc.computeEnergy(nmc, obs, dobs, true, !flag_grad);
+    }
+    if (_telemetry != nullptr) {
+        _telemetry->current().nmc += nmc;
+        _telemetry->current().acceptance = _vmc.getMCI().getAcceptanceRate();
+    }
+
+    // remove linear method obs again
+    if (flag_grad && (_overlapNchunk <= 0 || targetErr > 0.)) { _vmc.getMCI().popObservable(); }
+}
+
+void LinearMethodTargetFunction::_calcObs(const double * const vp, double &f, double &df, double * const grad_E, double * const dgrad_E)
+{
+    VMC_PROFILE_SCOPE(TargetFunction);
+    const auto nvp = static_cast<size_t>(_vmc.getNVP());
+    const bool flag_grad = (grad_E != nullptr);
+    const bool flag_dgrad = (dgrad_E != nullptr);
+
+    double obs[flag_grad ? 4 + 3*nvp + 2*nvp*nvp : 4];
+    double dobs[flag_grad ? 4 + 3*nvp + 2*nvp*nvp : 4];
+
+    _integrate(vp, obs, dobs, flag_grad, flag_dgrad);
+
+    f = obs[0];
+    df = dobs[0];
+
+    if (flag_grad) {
+        VMC_PROFILE_SCOPE(GradientSolve);
+        // create pointers for ease of use and readability
+        const double * const H = obs;
+        const double * const dH = dobs;
+        const double * const Oi = obs + 4;
+        const double * const dOi = dobs + 4;
+        const double * const HOi = obs + 4 + nvp;
+        const double * const HDi = obs + 4 + 2*nvp;
+        const double * const dHDi = dobs + 4 + 2*nvp;
+        const double * const OiOj = obs + 4 + 3*nvp;
+        const double * const OiHDj = obs + 4 + 3*nvp + nvp*nvp;
+        const double E = H[0];
+
+        // --- assemble the matrices in the basis {Psi, Psi_i}, with Psi_i = (O_i - <O_i>) Psi
+        const size_t nb = nvp + 1;
+        gsl_matrix * hmat = gsl_matrix_alloc(nb, nb);
+        gsl_matrix * smat = gsl_matrix_alloc(nb, nb);
+        gsl_matrix_set(hmat, 0, 0, E);
+        gsl_matrix_set(smat, 0, 0, 1.);
+        for (size_t i = 0; i < nvp; ++i) {
+            gsl_matrix_set(hmat, i + 1, 0, HOi[i] - Oi[i]*E);
+            gsl_matrix_set(hmat, 0, i + 1, HDi[i] - Oi[i]*E);
+            gsl_matrix_set(smat, i + 1, 0, 0.);
+            gsl_matrix_set(smat, 0, i + 1, 0.);
+            for (size_t j = 0; j < nvp; ++j) {
+                const double hij = OiHDj[i*nvp + j] - Oi[i]*HDi[j] - Oi[j]*HOi[i] + Oi[i]*Oi[j]*E;
+                gsl_matrix_set(hmat, i + 1, j + 1, (i == j) ? hij + _stabilization : hij);
+                gsl_matrix_set(smat, i + 1, j + 1, OiOj[i*nvp + j] - Oi[i]*Oi[j]);
+            }
+        }
+
+        // --- solve the (non-symmetric) generalized eigenproblem
+        gsl_vector_complex * alpha = gsl_vector_complex_alloc(nb);
+        gsl_vector * beta = gsl_vector_alloc(nb);
+        gsl_matrix_complex * evec = gsl_matrix_complex_alloc(nb, nb);
+        gsl_eigen_genv_workspace * work = gsl_eigen_genv_alloc(nb);
+        const int status = gsl_eigen_genv(hmat, smat, alpha, beta, evec, work);
+
+        // select the lowest real eigenvalue whose eigenvector has a non-vanishing Psi component
+        const double EIG_TINY = 1.0e-12;
+        size_t imin = nb; // invalid
+        double emin = std::numeric_limits<double>::max();
+        if (status == 0) {
+            for (size_t k = 0; k < nb; ++k) {
+                const double b = gsl_vector_get(beta, k);
+                const gsl_complex a = gsl_vector_complex_get(alpha, k);
+                if (fabs(b) < EIG_TINY || fabs(GSL_IMAG(a)) > EIG_TINY*fabs(GSL_REAL(a)) + EIG_TINY) { continue; }
+                if (fabs(GSL_REAL(gsl_matrix_complex_get(evec, 0, k))) < EIG_TINY) { continue; }
+                const double ek = GSL_REAL(a)/b;
+                if (ek < emin) {
+                    emin = ek;
+                    imin = k;
+                }
+            }
+        }
+
+        // --- finally find the direction to follow
+        for (size_t i = 0; i < nvp; ++i) {
+            if (imin < nb) {
+                grad_E[i] = GSL_REAL(gsl_matrix_complex_get(evec, i + 1, imin))/GSL_REAL(gsl_matrix_complex_get(evec, 0, imin));
+            }
+            else {
+                grad_E[i] = 0.; // no acceptable solution, so don't move
+            }
+            if (flag_dgrad) { // not correct, just a rough estimation via the relative error of H_0i
+                const double h0i = HDi[i] - Oi[i]*E;
+                const double dh0i = sqrt(dHDi[i]*dHDi[i] + E*E*dOi[i]*dOi[i] + Oi[i]*Oi[i]*dH[0]*dH[0]);
+                dgrad_E[i] = (h0i != 0.) ? fabs(grad_E[i]*dh0i/h0i) : 0.;
+            }
+        }
+
+        // free resources
+        gsl_eigen_genv_free(work);
+        gsl_matrix_complex_free(evec);
+        gsl_vector_free(beta);
+        gsl_vector_complex_free(alpha);
+        gsl_matrix_free(smat);
+        gsl_matrix_free(hmat);
+    }
+}
+
+
+nfm::NoisyValue LinearMethodTargetFunction::f(const std::vector<double> &vp)
+{
+    if (_telemetry != nullptr) { _telemetry->begin("lm", "f"); }
+    nfm::NoisyValue f;
+    _calcObs(vp.data(), f.val, f.err);
+    if (_lambda_reg > 0.) { // compute the regularization term
+        const double norm = std::inner_product(vp.begin(), vp.end(), vp.begin(), 0.);
+        f.val += _lambda_reg*norm/_vmc.getNVP();
+    }
+    if (_telemetry != nullptr) {
+        _telemetry->setResult(vp.data(), _vmc.getNVP(), f.val, f.err);
+        _telemetry->end();
+    }
+    return f;
+}
+
+void LinearMethodTargetFunction::grad(const std::vector<double> &vp, nfm::NoisyGradient &grad)
+{
+    fgrad(vp, grad);
+}
+
+nfm::NoisyValue LinearMethodTargetFunction::fgrad(const std::vector<double> &vp, nfm::NoisyGradient &grad)
+{
+    if (_telemetry != nullptr) { _telemetry->begin("lm", "fgrad"); }
+    nfm::NoisyValue f;
+    _calcObs(vp.data(), f.val, f.err, grad.val.data(), this->hasGradErr() ? grad.err.data() : nullptr);
+    if (_lambda_reg > 0.) { // compute the regularization terms
+        const int nvp = _vmc.getNVP();
+        const double norm = std::inner_product(vp.begin(), vp.end(), vp.begin(), 0.);
+        const double fac = _lambda_reg/nvp;
+        f.val += fac*norm;
+        for (int i = 0; i < nvp; ++i) { grad.val[i] -= 2.*fac*vp[i]; }
+    }
+    if (_telemetry != nullptr) {
+        _telemetry->setResult(vp.data(), _vmc.getNVP(), f.val, f.err, grad.val.data(), this->hasGradErr() ? grad.err.data() : nullptr);
+        _telemetry->end();
+    }
+    this->_checkpointIteration(vp);
+    return f;
+}
+} // namespace vmc
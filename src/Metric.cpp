@@ -0,0 +1,50 @@
+#include "vmc/Metric.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace vmc
+{
+
+namespace
+{
+// copy point k of the SoA array rs into r
+void gatherPoint(const int nspacedim, const int n, const int k, const double * rs, double * r)
+{
+    for (int i = 0; i < nspacedim; ++i) { r[i] = rs[i*n + k]; }
+}
+} // namespace
+
+
+void Metric::distBatch(const int n, const double * r1s, const double * r2s, double * out)
+{
+    std::vector<double> r1(static_cast<size_t>(_nspacedim)), r2(static_cast<size_t>(_nspacedim));
+    for (int k = 0; k < n; ++k) {
+        gatherPoint(_nspacedim, n, k, r1s, r1.data());
+        gatherPoint(_nspacedim, n, k, r2s, r2.data());
+        out[k] = this->dist(r1.data(), r2.data());
+    }
+}
+
+void Metric::distD1Batch(const int n, const double * r1s, const double * r2s, double * out)
+{
+    std::vector<double> r1(static_cast<size_t>(_nspacedim)), r2(static_cast<size_t>(_nspacedim)), d1(2*static_cast<size_t>(_nspacedim));
+    for (int k = 0; k < n; ++k) {
+        gatherPoint(_nspacedim, n, k, r1s, r1.data());
+        gatherPoint(_nspacedim, n, k, r2s, r2.data());
+        this->distD1(r1.data(), r2.data(), d1.data());
+        for (int i = 0; i < 2*_nspacedim; ++i) { out[i*n + k] = d1[i]; }
+    }
+}
+
+void Metric::distD2Batch(const int n, const double * r1s, const double * r2s, double * out)
+{
+    std::vector<double> r1(static_cast<size_t>(_nspacedim)), r2(static_cast<size_t>(_nspacedim)), d2(2*static_cast<size_t>(_nspacedim));
+    for (int k = 0; k < n; ++k) {
+        gatherPoint(_nspacedim, n, k, r1s, r1.data());
+        gatherPoint(_nspacedim, n, k, r2s, r2.data());
+        this->distD2(r1.data(), r2.data(), d2.data());
+        for (int i = 0; i < 2*_nspacedim; ++i) { out[i*n + k] = d2[i]; }
+    }
+}
+} // namespace vmc
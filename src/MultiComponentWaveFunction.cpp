@@ -5,7 +5,7 @@ namespace vmc
 
 void MultiComponentWaveFunction::computeAllDerivatives(const double x[])
 {
-
+    VMC_PROFILE_SCOPE(ComputeAllDerivatives);
     for (auto &wf : _wfs) {
         wf->computeAllDerivatives(x);
     }
@@ -125,6 +125,7 @@ double MultiComponentWaveFunction::computeWFValue(const double protovalues[]) co
 
 double MultiComponentWaveFunction::acceptanceFunction(const double protoold[], const double protonew[]) const
 {
+    VMC_PROFILE_SCOPE(AcceptanceFunction);
     double acceptance = 1.;
     int contproto = 0;
     for (WaveFunction * wf : _wfs) {
@@ -147,6 +148,7 @@ double MultiComponentWaveFunction::updatedAcceptance(const mci::WalkerState &wlk
 
 void MultiComponentWaveFunction::protoFunction(const double in[], double out[])
 {
+    VMC_PROFILE_SCOPE(ProtoFunction);
     int contproto = 0;
     for (WaveFunction * wf : _wfs) {
         wf->protoFunction(in, out + contproto);
@@ -199,6 +201,13 @@ void MultiComponentWaveFunction::addWaveFunction(WaveFunction * wf)
 }
 
 
+void MultiComponentWaveFunction::addWaveFunction(std::unique_ptr<WaveFunction> wf)
+{
+    addWaveFunction(wf.get()); // may throw, then wf is deleted
+    _ownedWFs.push_back(std::move(wf));
+}
+
+
 void MultiComponentWaveFunction::_newToOld()
 {
     for (auto &wf : _wfs) {
@@ -3,6 +3,12 @@
 
 #include <gsl/gsl_multimin.h>
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
 namespace vmc
 {
 
@@ -16,6 +22,7 @@ struct vmc_nms
     double rstart;
     double rend;
     size_t max_n_iter;
+    int64_t nevals = 0; // number of cost function evaluations
 
     vmc_nms(VMC &vmc, NMSimplexMinimization &nms): vmc(vmc)
     {
@@ -36,6 +43,7 @@ double vmc_cost(const gsl_vector * v, void * params)
     const double iota = (static_cast<struct vmc_nms *>(params))->iota;
     const double kappa = (static_cast<struct vmc_nms *>(params))->kappa;
     const double lambda = (static_cast<struct vmc_nms *>(params))->lambda;
+    ++(static_cast<struct vmc_nms *>(params))->nevals;
 
     const auto nvp = static_cast<size_t>(vmc.getNVP());
     double vpar[nvp];
@@ -63,7 +71,61 @@ double vmc_cost(const gsl_vector * v, void * params)
 };
 
 
-void NMSimplexMinimization::minimizeEnergy(VMC &vmc)
+// Evaluates the cost function for a batch of points, distributing them over the rank groups
+struct vmc_nms_batch
+{
+    vmc_nms &w;
+    int ngroups;
+    int groupid;
+    bool isGroupRoot;
+#if USE_MPI == 1
+    MPI_Comm comm;
+#endif
+
+    vmc_nms_batch(vmc_nms &w, int ngroups): w(w), ngroups(ngroups), groupid(0), isGroupRoot(true)
+    {
+#if USE_MPI == 1
+        comm = MPIVMC::SplitGroups(this->ngroups, groupid);
+        int grouprank;
+        MPI_Comm_rank(comm, &grouprank);
+        isGroupRoot = (grouprank == 0);
+#else
+        this->ngroups = 1;
+#endif
+    }
+
+    ~vmc_nms_batch()
+    {
+#if USE_MPI == 1
+        MPI_Comm_free(&comm);
+#endif
+    }
+
+    void operator()(const std::vector<std::vector<double>> &points, std::vector<double> &costs)
+    {
+        costs.assign(points.size(), 0.);
+        w.nevals += static_cast<int64_t>(points.size());
+        for (size_t k = 0; k < points.size(); ++k) {
+            if (static_cast<int>(k%ngroups) != groupid) { continue; }
+            const std::vector<double> &vp = points[k];
+            w.vmc.setVP(vp.data());
+
+            double energy[w.vmc.getMCI().getNObsDim()]; // energy
+            double d_energy[w.vmc.getMCI().getNObsDim()]; // energy error bar
+#if USE_MPI == 1
+            w.vmc.computeEnergyOnComm(comm, w.Nmc, energy, d_energy, true, true);
+#else
+            w.vmc.computeEnergy(w.Nmc, energy, d_energy, true, true);
+#endif
+            const double norm = sqrt(std::inner_product(vp.begin(), vp.end(), vp.begin(), 0.))/vp.size();
+            if (isGroupRoot) { costs[k] = w.iota*energy[0] + w.kappa*d_energy[0] + w.lambda*norm; }
+        }
+        MPIVMC::AllreduceSum(costs.data(), static_cast<int>(costs.size())); // now every rank knows all costs
+    }
+};
+
+
+void NMSimplexMinimization::_minimizeEnergyGSL(VMC &vmc)
 {
     const gsl_multimin_fminimizer_type * T = gsl_multimin_fminimizer_nmsimplex2;
     gsl_multimin_fminimizer * s = nullptr;
@@ -77,7 +139,14 @@ void NMSimplexMinimization::minimizeEnergy(VMC &vmc)
     // Starting point
     const auto nvp = static_cast<size_t>(vmc.getNVP());
     double vpar[nvp];
-    vmc.getVP(vpar);
+    size_t iter = 0;
+    if (_checkpoint != nullptr && _checkpoint->resume(vmc)) { // best vertex of the last checkpoint
+        std::copy(_checkpoint->getCheckpoint().getOptimizerX().begin(), _checkpoint->getCheckpoint().getOptimizerX().end(), vpar);
+        iter = static_cast<size_t>(_checkpoint->getIteration());
+    }
+    else {
+        vmc.getVP(vpar);
+    }
 
     x = gsl_vector_alloc(nvp);
     for (size_t i = 0; i < nvp; ++i) {
@@ -96,9 +165,10 @@ void NMSimplexMinimization::minimizeEnergy(VMC &vmc)
     s = gsl_multimin_fminimizer_alloc(T, nvp);
     gsl_multimin_fminimizer_set(s, &minex_func, x, ss);
 
-    size_t iter = 0;
     int status;
     do {
+        if (_telemetry != nullptr) { _telemetry->begin("nmsimplex", "iteration"); }
+        const int64_t nevals0 = w.nevals;
         status = gsl_multimin_fminimizer_iterate(s);
 
         if (status != 0) { break; }
@@ -106,6 +176,18 @@ void NMSimplexMinimization::minimizeEnergy(VMC &vmc)
         double size = gsl_multimin_fminimizer_size(s);
         status = gsl_multimin_test_size(size, _rend);
 
+        const gsl_vector * xbest = gsl_multimin_fminimizer_x(s);
+        for (size_t i = 0; i < nvp; ++i) { vpar[i] = gsl_vector_get(xbest, i); }
+        if (_checkpoint != nullptr) { _checkpoint->iterate(vmc, std::vector<double>(vpar, vpar + nvp)); }
+
+        if (_telemetry != nullptr) {
+            _telemetry->current().nmc = (w.nevals - nevals0)*_Nmc;
+            _telemetry->current().acceptance = vmc.getMCI().getAcceptanceRate();
+            _telemetry->current().simplexSize = size;
+            _telemetry->setResult(vpar, static_cast<int>(nvp), s->fval, std::numeric_limits<double>::quiet_NaN());
+            _telemetry->end();
+        }
+
         if (myrank == 0) {
             if (status == GSL_SUCCESS) {
                 std::cout << "converged to minimum at" << std::endl;
@@ -119,4 +201,165 @@ void NMSimplexMinimization::minimizeEnergy(VMC &vmc)
     gsl_vector_free(ss);
     gsl_multimin_fminimizer_free(s);
 }
+
+
+void NMSimplexMinimization::minimizeEnergy(VMC &vmc)
+{
+    if (_ngroups > 1) {
+        _minimizeEnergyBatched(vmc);
+    }
+    else {
+        _minimizeEnergyGSL(vmc);
+    }
+}
+
+
+void NMSimplexMinimization::_minimizeEnergyBatched(VMC &vmc)
+{
+    // Nelder-Mead simplex (standard coefficients), where all points of one step are evaluated as batch
+    // and the expansion/contraction candidates are evaluated speculatively together with the reflection
+    const int myrank = MPIVMC::MyRank();
+
+    vmc_nms w(vmc, *this);
+    vmc_nms_batch evalBatch(w, _ngroups);
+    const auto width = static_cast<size_t>(evalBatch.ngroups); // how many points are evaluated concurrently
+
+    // Starting simplex, or the one of the last checkpoint (stored as extra values: vertices, then costs)
+    const auto nvp = static_cast<size_t>(vmc.getNVP());
+    std::vector<std::vector<double>> xs(nvp + 1, std::vector<double>(nvp));
+    std::vector<double> fs;
+    size_t iter = 0;
+    if (_checkpoint != nullptr && _checkpoint->resume(vmc)) {
+        const std::vector<double> &extra = _checkpoint->getCheckpoint().getOptimizerExtra();
+        if (extra.size() != (nvp + 1)*(nvp + 1)) {
+            throw std::runtime_error("[NMSimplexMinimization::minimizeEnergy] Checkpoint doesn't contain a batched simplex.");
+        }
+        for (size_t k = 0; k <= nvp; ++k) { std::copy(extra.begin() + k*nvp, extra.begin() + (k + 1)*nvp, xs[k].begin()); }
+        fs.assign(extra.begin() + (nvp + 1)*nvp, extra.end());
+        iter = static_cast<size_t>(_checkpoint->getIteration());
+    }
+    else {
+        vmc.getVP(xs[0].data());
+        for (size_t i = 0; i < nvp; ++i) {
+            xs[i + 1] = xs[0];
+            xs[i + 1][i] += _rstart;
+        }
+        evalBatch(xs, fs);
+    }
+
+    const double coeffs[4] = {1., 2., 0.5, -0.5}; // reflection, expansion, outside/inside contraction
+    std::vector<size_t> order(nvp + 1);
+    std::vector<double> centroid(nvp);
+    std::vector<std::vector<double>> cands(4, std::vector<double>(nvp));
+    std::vector<double> fcands(4);
+    std::vector<double> extra((nvp + 1)*(nvp + 1));
+    bool converged = false;
+    do {
+        if (_telemetry != nullptr) { _telemetry->begin("nmsimplex", "iteration"); }
+        const int64_t nevals0 = w.nevals;
+        // sort vertices by cost
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&fs](size_t a, size_t b) { return fs[a] < fs[b]; });
+        const size_t ib = order[0], isw = order[nvp - 1], iw = order[nvp];
+
+        // candidate points along the line through the worst vertex and the centroid of the others
+        std::fill(centroid.begin(), centroid.end(), 0.);
+        for (size_t k = 0; k < nvp; ++k) {
+            for (size_t i = 0; i < nvp; ++i) { centroid[i] += xs[order[k]][i]/nvp; }
+        }
+        for (size_t c = 0; c < 4; ++c) {
+            for (size_t i = 0; i < nvp; ++i) { cands[c][i] = centroid[i] + coeffs[c]*(centroid[i] - xs[iw][i]); }
+        }
+        bool have[4] = {false, false, false, false};
+        auto need = [&](size_t c) { // evaluate candidate c (and speculatively the following ones, if there is room)
+            if (have[c]) { return fcands[c]; }
+            std::vector<std::vector<double>> batch;
+            std::vector<size_t> ids;
+            for (size_t d = c; d < 4 && batch.size() < width; ++d) {
+                if (!have[d]) {
+                    batch.push_back(cands[d]);
+                    ids.push_back(d);
+                }
+            }
+            std::vector<double> fb;
+            evalBatch(batch, fb);
+            for (size_t k = 0; k < ids.size(); ++k) {
+                fcands[ids[k]] = fb[k];
+                have[ids[k]] = true;
+            }
+            return fcands[c];
+        };
+
+        // standard decision sequence
+        int accepted = -1;
+        const double fr = need(0);
+        if (fr < fs[ib]) {
+            accepted = (need(1) < fr) ? 1 : 0;
+        }
+        else if (fr < fs[isw]) {
+            accepted = 0;
+        }
+        else if (fr < fs[iw]) {
+            if (need(2) <= fr) { accepted = 2; }
+        }
+        else {
+            if (need(3) < fs[iw]) { accepted = 3; }
+        }
+
+        if (accepted >= 0) {
+            xs[iw] = cands[accepted];
+            fs[iw] = fcands[accepted];
+        }
+        else { // shrink towards the best vertex
+            std::vector<std::vector<double>> batch;
+            for (size_t k = 1; k <= nvp; ++k) {
+                std::vector<double> &x = xs[order[k]];
+                for (size_t i = 0; i < nvp; ++i) { x[i] = xs[ib][i] + 0.5*(x[i] - xs[ib][i]); }
+                batch.push_back(x);
+            }
+            std::vector<double> fb;
+            evalBatch(batch, fb);
+            for (size_t k = 1; k <= nvp; ++k) { fs[order[k]] = fb[k - 1]; }
+        }
+
+        // simplex size as rms distance of the vertices from their center (like GSL's nmsimplex2)
+        std::fill(centroid.begin(), centroid.end(), 0.);
+        for (const auto &x : xs) {
+            for (size_t i = 0; i < nvp; ++i) { centroid[i] += x[i]/(nvp + 1); }
+        }
+        double size = 0.;
+        for (const auto &x : xs) {
+            for (size_t i = 0; i < nvp; ++i) { size += (x[i] - centroid[i])*(x[i] - centroid[i]); }
+        }
+        size = sqrt(size/(nvp + 1));
+        converged = (size < _rend);
+
+        const size_t ibest = static_cast<size_t>(std::min_element(fs.begin(), fs.end()) - fs.begin());
+        if (_checkpoint != nullptr) {
+            for (size_t k = 0; k <= nvp; ++k) { std::copy(xs[k].begin(), xs[k].end(), extra.begin() + k*nvp); }
+            std::copy(fs.begin(), fs.end(), extra.begin() + (nvp + 1)*nvp);
+            _checkpoint->iterate(vmc, xs[ibest], extra);
+        }
+
+        if (_telemetry != nullptr) {
+            _telemetry->current().nmc = (w.nevals - nevals0)*_Nmc;
+            _telemetry->current().acceptance = vmc.getMCI().getAcceptanceRate();
+            _telemetry->current().simplexSize = size;
+            _telemetry->setResult(xs[ibest].data(), static_cast<int>(nvp), fs[ibest], std::numeric_limits<double>::quiet_NaN());
+            _telemetry->end();
+        }
+
+        if (myrank == 0) {
+            if (converged) {
+                std::cout << "converged to minimum at" << std::endl;
+            }
+            std::cout << iter << " f() = " << fs[ibest] << " size = " << size << std::endl;
+        }
+        ++iter;
+    } while (!converged && (_max_n_iter <= 0 || iter < _max_n_iter));
+
+    // set the best vertex
+    const size_t ibest = static_cast<size_t>(std::min_element(fs.begin(), fs.end()) - fs.begin());
+    vmc.setVP(xs[ibest].data());
+}
 } // namespace vmc
@@ -0,0 +1,104 @@
+#include "vmc/OptimizerTelemetry.hpp"
+#include "vmc/MPIVMC.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace vmc
+{
+
+namespace
+{
+void writeNumber(std::ostream &out, const double value)
+{
+    if (std::isfinite(value)) { out << value; }
+    else { out << "null"; }
+}
+
+double norm(const double * v, const int n)
+{
+    double sum = 0.;
+    for (int i = 0; i < n; ++i) { sum += v[i]*v[i]; }
+    return sqrt(sum);
+}
+} // namespace
+
+
+std::string TelemetryRecord::toJSON(const int64_t iter) const
+{
+    std::ostringstream out;
+    out << std::setprecision(12);
+    out << "{\"iter\": " << iter << ", \"optimizer\": \"" << optimizer << "\", \"kind\": \"" << kind << "\", \"f\": ";
+    writeNumber(out, f);
+    out << ", \"df\": ";
+    writeNumber(out, df);
+    out << ", \"gradNorm\": ";
+    writeNumber(out, gradNorm);
+    out << ", \"dgradNorm\": ";
+    writeNumber(out, dgradNorm);
+    out << ", \"nmc\": " << nmc << ", \"acceptance\": ";
+    writeNumber(out, acceptance);
+    out << ", \"srCondition\": ";
+    writeNumber(out, srCondition);
+    out << ", \"simplexSize\": ";
+    writeNumber(out, simplexSize);
+    out << ", \"seconds\": " << seconds << ", \"phases\": {";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        out << (i > 0 ? ", " : "") << "\"" << phases[i].first << "\": " << phases[i].second;
+    }
+    out << "}, \"vp\": [";
+    for (size_t i = 0; i < vp.size(); ++i) {
+        out << (i > 0 ? ", " : "");
+        writeNumber(out, vp[i]);
+    }
+    out << "]}";
+    return out.str();
+}
+
+
+OptimizerTelemetry::OptimizerTelemetry(const std::string &filename, const bool append):
+        _isWriter(MPIVMC::MyRank() == 0)
+{
+    if (_isWriter) {
+        _file.open(filename, append ? std::ios::app : std::ios::trunc);
+        if (!_file) { throw std::runtime_error("[OptimizerTelemetry] Could not open file " + filename + "."); }
+    }
+}
+
+void OptimizerTelemetry::begin(const std::string &optimizer, const std::string &kind)
+{
+    _current = TelemetryRecord();
+    _current.optimizer = optimizer;
+    _current.kind = kind;
+    _profileStart = Profiler::getReport();
+    _start = std::chrono::steady_clock::now();
+}
+
+void OptimizerTelemetry::setResult(const double * const vp, const int nvp, const double f, const double df, const double * const grad, const double * const dgrad)
+{
+    _current.vp.assign(vp, vp + nvp);
+    _current.f = f;
+    _current.df = df;
+    if (grad != nullptr) { _current.gradNorm = norm(grad, nvp); }
+    if (dgrad != nullptr) { _current.dgradNorm = norm(dgrad, nvp); }
+}
+
+void OptimizerTelemetry::end()
+{
+    _current.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    const ProfileReport profile = Profiler::getReport();
+    if (profile.enabled) { // time spent per phase during this record
+        for (size_t i = 0; i < profile.entries.size(); ++i) {
+            _current.phases.emplace_back(profile.entries[i].name, profile.entries[i].seconds - _profileStart.entries[i].seconds);
+        }
+    }
+
+    if (_isWriter) {
+        _file << _current.toJSON(_nrecords) << std::endl;
+        if (!_file) { throw std::runtime_error("[OptimizerTelemetry] Failed writing record."); }
+    }
+    ++_nrecords;
+}
+} // namespace vmc
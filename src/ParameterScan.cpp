@@ -0,0 +1,179 @@
+#include "vmc/ParameterScan.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Philox.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace vmc
+{
+
+ParameterScan::ParameterScan(VMC &vmc, const int64_t Nmc, const int nthreads):
+        _vmc(vmc), _Nmc(Nmc), _nthreads(1)
+{
+    if (Nmc < 1) { throw std::invalid_argument("[ParameterScan] Nmc must be positive."); }
+    this->setNThreads(nthreads);
+}
+
+void ParameterScan::setNThreads(const int nthreads)
+{
+    if (nthreads < 0) { throw std::invalid_argument("[ParameterScan] nthreads must be non-negative."); }
+    _nthreads = (nthreads > 0) ? nthreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+
+void ParameterScan::setWarmStart(const bool warmstart, const int chainLength, const double warmFraction)
+{
+    if (chainLength < 1 || warmFraction <= 0. || warmFraction > 1.) {
+        throw std::invalid_argument("[ParameterScan::setWarmStart] chainLength must be positive and warmFraction within (0, 1].");
+    }
+    _warmstart = warmstart;
+    _chainLength = chainLength;
+    _warmFraction = warmFraction;
+}
+
+
+std::vector<ScanResult> ParameterScan::run(const std::vector<std::vector<double>> &vps)
+{
+    const int nvp = _vmc.getNVP();
+    const int npoints = static_cast<int>(vps.size());
+    for (const auto &vp : vps) {
+        if (static_cast<int>(vp.size()) != nvp) {
+            throw std::invalid_argument("[ParameterScan::run] Every vp vector must have getNVP() elements.");
+        }
+    }
+
+    // contiguous block of chains (and their points) of this rank
+    const int chainLength = _warmstart ? _chainLength : 1;
+    const int nchains = (npoints + chainLength - 1)/chainLength;
+    const int myrank = MPIVMC::MyRank();
+    const std::vector<int> chainOffsets = MPIVMC::RowOffsets(nchains);
+    std::vector<int> offsets; // points
+    for (const int ic : chainOffsets) { offsets.push_back(std::min(npoints, ic*chainLength)); }
+    const int first = offsets[myrank];
+    const int nlocal = offsets[myrank + 1] - first;
+    const int nlocalChains = chainOffsets[myrank + 1] - chainOffsets[myrank];
+    const int nthreads = std::max(1, std::min(_nthreads, nlocalChains));
+
+    // per-thread VMCs, created here to keep the prototype's use single-threaded
+    mci::MCI &protomci = _vmc.getMCI();
+    const int64_t ndecorr = protomci.getNdecorrelationSteps();
+    const int64_t nwarmDecorr = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(_warmFraction*ndecorr)));
+    std::vector<double> mrt2steps(static_cast<size_t>(protomci.getNDim()));
+    for (int i = 0; i < protomci.getNDim(); ++i) { mrt2steps[i] = protomci.getMRT2Step(i); }
+    std::vector<std::unique_ptr<VMC>> vmcs;
+    for (int it = 0; it < nthreads; ++it) {
+        vmcs.emplace_back(new VMC(_vmc.getWF(), _vmc.getH(), _vmc.getNSkipEG(), _vmc.getBlockSizeEG()));
+        mci::MCI &mci = vmcs.back()->getMCI();
+        mci.setNfindMRT2Iterations(protomci.getNfindMRT2Iterations());
+        mci.setNdecorrelationSteps(ndecorr);
+        for (int i = 0; i < protomci.getNDim(); ++i) { mci.setMRT2Step(i, mrt2steps[i]); }
+        if (_setup) { _setup(*vmcs.back()); }
+    }
+
+    std::ofstream file;
+    if (!_filename.empty()) {
+        file.open((MPIVMC::Size() > 1) ? _filename + "." + std::to_string(myrank) : _filename);
+        if (!file) { throw std::runtime_error("[ParameterScan::run] Failed to open output file " + _filename + "."); }
+        file.precision(12);
+    }
+
+    // the threads take the local chains in order (the results don't depend on which thread runs which chain)
+    std::atomic<int> nextChain(0);
+    std::mutex mutex; // guards file
+
+    // local results: E[4], dE[4], thread, warm
+    const int NRES = 10;
+    const auto chainSize = static_cast<size_t>(chainLength)*NRES;
+    std::vector<double> local(nlocalChains*chainSize); // the last chain may be incomplete
+    std::vector<std::exception_ptr> errors(static_cast<size_t>(nthreads));
+
+    const auto worker = [&](const int ithread) {
+        try {
+            VMC &vmc = *vmcs[ithread];
+            mci::MCI &mci = vmc.getMCI();
+            for (int ichain = nextChain++; ichain < nlocalChains; ichain = nextChain++) {
+                const int ibegin = ichain*chainLength;
+                const int iend = std::min(nlocal, ibegin + chainLength);
+                for (int ilocal = ibegin; ilocal < iend; ++ilocal) {
+                    const int ipoint = first + ilocal;
+                    const bool warm = (ilocal > ibegin);
+                    Philox rng(_seed, Philox::streamID(0, 0, ipoint)); // independent of rank/thread
+                    mci.setSeed(rng());
+                    if (!warm) { // same cold start, no matter what the thread's VMC did before
+                        for (int i = 0; i < mci.getNDim(); ++i) { mci.setMRT2Step(i, mrt2steps[i]); }
+                        mci.newRandomX();
+                    }
+                    mci.setNdecorrelationSteps(warm ? nwarmDecorr : ndecorr);
+                    vmc.setVP(vps[ipoint].data());
+                    double * const res = local.data() + static_cast<size_t>(ilocal)*NRES;
+                    {
+                        VMC_PROFILE_SCOPE(Integrate);
+                        mci.integrate(_Nmc, res, res + 4, !warm, true); // the full Nmc, on this thread only
+                    }
+                    res[8] = ithread;
+                    res[9] = warm ? 1. : 0.;
+
+                    if (file.is_open()) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        file << ipoint;
+                        for (const double v : vps[ipoint]) { file << " " << v; }
+                        for (int i = 0; i < 4; ++i) { file << " " << res[i] << " " << res[4 + i]; }
+                        file << std::endl;
+                    }
+                }
+            }
+        }
+        catch (...) {
+            errors[ithread] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int it = 1; it < nthreads; ++it) { threads.emplace_back(worker, it); }
+    if (nlocal > 0) { worker(0); }
+    for (auto &t : threads) { t.join(); }
+    for (const auto &e : errors) {
+        if (e) { std::rethrow_exception(e); }
+    }
+
+    // collect the results of all ranks
+    std::vector<double> all(nchains*chainSize);
+    MPIVMC::AllgatherRows(local.data(), nchains, static_cast<int>(chainSize), all.data());
+    std::vector<ScanResult> results(static_cast<size_t>(npoints));
+    for (int ip = 0; ip < npoints; ++ip) {
+        ScanResult &result = results[ip];
+        const double * const res = all.data() + static_cast<size_t>(ip)*NRES;
+        result.vp = vps[ip];
+        std::copy(res, res + 4, result.E);
+        std::copy(res + 4, res + 8, result.dE);
+        result.rank = static_cast<int>(std::upper_bound(offsets.begin(), offsets.end(), ip) - offsets.begin()) - 1;
+        result.thread = static_cast<int>(res[8]);
+        result.warm = (res[9] != 0.);
+    }
+    return results;
+}
+
+
+std::vector<std::vector<double>> ParameterScan::makeGrid(const std::vector<std::vector<double>> &axes)
+{
+    std::vector<std::vector<double>> grid(1); // the empty point
+    for (const auto &axis : axes) { // append the next axis, alternating its direction
+        std::vector<std::vector<double>> newgrid;
+        for (size_t ip = 0; ip < grid.size(); ++ip) {
+            for (size_t k = 0; k < axis.size(); ++k) {
+                newgrid.push_back(grid[ip]);
+                newgrid.back().push_back((ip%2 == 0) ? axis[k] : axis[axis.size() - 1 - k]);
+            }
+        }
+        grid.swap(newgrid);
+    }
+    return grid;
+}
+} // namespace vmc
@@ -0,0 +1,232 @@
+#include "vmc/Profiler.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Tracer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace vmc
+{
+
+namespace
+{
+const int NPHASES = Profiler::NPHASES;
+const int NEVENTS = HardwareCounters::NEVENTS;
+
+struct Counters
+{
+    std::atomic<int64_t> ns[NPHASES];
+    std::atomic<int64_t> calls[NPHASES];
+    std::atomic<int64_t> hw[NPHASES][NEVENTS];
+
+    Counters()
+    {
+        for (int i = 0; i < NPHASES; ++i) {
+            ns[i] = 0;
+            calls[i] = 0;
+            for (int j = 0; j < NEVENTS; ++j) { hw[i][j] = 0; }
+        }
+    }
+};
+
+// counters of all live threads, plus the sums of finished threads
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<Counters *> live;
+    int64_t retired_ns[NPHASES] = {};
+    int64_t retired_calls[NPHASES] = {};
+    int64_t retired_hw[NPHASES][NEVENTS] = {};
+    bool hw_measured[NEVENTS] = {}; // was the event available when hardware counting was enabled?
+};
+
+Registry &registry()
+{
+    static Registry reg;
+    return reg;
+}
+
+struct ThreadCounters
+{
+    Counters counters;
+
+    ThreadCounters()
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().live.push_back(&counters);
+    }
+
+    ~ThreadCounters()
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (int i = 0; i < NPHASES; ++i) {
+            reg.retired_ns[i] += counters.ns[i].load(std::memory_order_relaxed);
+            reg.retired_calls[i] += counters.calls[i].load(std::memory_order_relaxed);
+            for (int j = 0; j < NEVENTS; ++j) { reg.retired_hw[i][j] += counters.hw[i][j].load(std::memory_order_relaxed); }
+        }
+        reg.live.erase(std::find(reg.live.begin(), reg.live.end(), &counters));
+    }
+};
+
+Counters &localCounters()
+{
+    thread_local ThreadCounters tc;
+    return tc.counters;
+}
+} // namespace
+
+constexpr int Profiler::NPHASES;
+std::atomic<uint32_t> Profiler::_hwPhaseMask(0);
+
+
+const char * Profiler::getPhaseName(const ProfilePhase phase)
+{
+    switch (phase) {
+    case ProfilePhase::ProtoFunction:
+        return "protoFunction";
+    case ProfilePhase::AcceptanceFunction:
+        return "acceptanceFunction";
+    case ProfilePhase::ComputeAllDerivatives:
+        return "computeAllDerivatives";
+    case ProfilePhase::ObservableFunction:
+        return "observableFunction";
+    case ProfilePhase::Integrate:
+        return "integrate";
+    case ProfilePhase::MPIReduce:
+        return "mpiReduce";
+    case ProfilePhase::TargetFunction:
+        return "targetFunction";
+    case ProfilePhase::GradientSolve:
+        return "gradientSolve";
+    default:
+        return "unknown";
+    }
+}
+
+void Profiler::add(const ProfilePhase phase, const int64_t nanoseconds, const int64_t calls)
+{
+    Counters &c = localCounters();
+    const auto i = static_cast<int>(phase);
+    // only this thread writes, so relaxed atomics are enough (and uncontended)
+    c.ns[i].fetch_add(nanoseconds, std::memory_order_relaxed);
+    c.calls[i].fetch_add(calls, std::memory_order_relaxed);
+}
+
+void Profiler::record(const ProfilePhase phase, const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end)
+{
+    Profiler::add(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    if (Tracer::isActive()) { Tracer::addSpan(phase, begin, end); }
+}
+
+bool Profiler::enableHardwareCounters(const std::vector<ProfilePhase> &phases)
+{
+    if (!HardwareCounters::isAvailable()) {
+        _hwPhaseMask = 0;
+        return false;
+    }
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (int j = 0; j < NEVENTS; ++j) {
+            reg.hw_measured[j] = reg.hw_measured[j] || HardwareCounters::isAvailable(static_cast<HardwareEvent>(j));
+        }
+    }
+    uint32_t mask = 0;
+    for (const ProfilePhase phase : phases) { mask |= (1u << static_cast<int>(phase)); }
+    _hwPhaseMask = phases.empty() ? (1u << NPHASES) - 1u : mask;
+    return true;
+}
+
+void Profiler::disableHardwareCounters()
+{
+    _hwPhaseMask = 0;
+}
+
+void Profiler::addHardwareCounts(const ProfilePhase phase, const int64_t * begin, const int64_t * end)
+{
+    Counters &c = localCounters();
+    const auto i = static_cast<int>(phase);
+    for (int j = 0; j < NEVENTS; ++j) {
+        if (begin[j] >= 0 && end[j] >= begin[j]) { c.hw[i][j].fetch_add(end[j] - begin[j], std::memory_order_relaxed); }
+    }
+}
+
+ProfileReport Profiler::getReport()
+{
+    int64_t ns[NPHASES], calls[NPHASES], hw[NPHASES][NEVENTS];
+    bool measured[NEVENTS];
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (int i = 0; i < NPHASES; ++i) {
+            ns[i] = reg.retired_ns[i];
+            calls[i] = reg.retired_calls[i];
+            for (int j = 0; j < NEVENTS; ++j) { hw[i][j] = reg.retired_hw[i][j]; }
+            for (const Counters * c : reg.live) {
+                ns[i] += c->ns[i].load(std::memory_order_relaxed);
+                calls[i] += c->calls[i].load(std::memory_order_relaxed);
+                for (int j = 0; j < NEVENTS; ++j) { hw[i][j] += c->hw[i][j].load(std::memory_order_relaxed); }
+            }
+        }
+        std::copy(reg.hw_measured, reg.hw_measured + NEVENTS, measured);
+    }
+
+    ProfileReport report;
+#if USE_PROFILING == 1
+    report.enabled = true;
+#else
+    report.enabled = false;
+#endif
+    report.rank = MPIVMC::MyRank();
+    report.hwCounters = std::find(measured, measured + NEVENTS, true) != measured + NEVENTS;
+    for (int i = 0; i < NPHASES; ++i) {
+        std::vector<int64_t> hwCounts(NEVENTS);
+        for (int j = 0; j < NEVENTS; ++j) { hwCounts[j] = measured[j] ? hw[i][j] : -1; }
+        report.entries.push_back(ProfileEntry{getPhaseName(static_cast<ProfilePhase>(i)), calls[i], 1e-9*ns[i], hwCounts});
+    }
+    return report;
+}
+
+void Profiler::reset()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (int i = 0; i < NPHASES; ++i) {
+        reg.retired_ns[i] = 0;
+        reg.retired_calls[i] = 0;
+        for (int j = 0; j < NEVENTS; ++j) { reg.retired_hw[i][j] = 0; }
+        for (Counters * c : reg.live) {
+            c->ns[i].store(0, std::memory_order_relaxed);
+            c->calls[i].store(0, std::memory_order_relaxed);
+            for (int j = 0; j < NEVENTS; ++j) { c->hw[i][j].store(0, std::memory_order_relaxed); }
+        }
+    }
+}
+
+
+std::string ProfileReport::toJSON() const
+{
+    std::ostringstream out;
+    out << std::setprecision(9);
+    out << "{\"enabled\": " << (enabled ? "true" : "false") << ", \"rank\": " << rank
+        << ", \"hwCounters\": " << (hwCounters ? "true" : "false") << ", \"phases\": [";
+    for (size_t i = 0; i < entries.size(); ++i) {
+        out << (i > 0 ? ", " : "") << "{\"name\": \"" << entries[i].name << "\", \"calls\": " << entries[i].calls
+            << ", \"seconds\": " << entries[i].seconds;
+        if (hwCounters) {
+            for (size_t j = 0; j < entries[i].hwCounts.size(); ++j) { // unavailable events as null
+                out << ", \"" << HardwareCounters::getEventName(static_cast<HardwareEvent>(j)) << "\": ";
+                if (entries[i].hwCounts[j] >= 0) { out << entries[i].hwCounts[j]; }
+                else { out << "null"; }
+            }
+        }
+        out << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+} // namespace vmc
@@ -1,9 +1,16 @@
 #include "vmc/StochasticReconfigurationTargetFunction.hpp"
 #include "vmc/StochasticReconfigurationMCObservable.hpp"
+#include "vmc/EnergyGradientMCObservable.hpp"
+#include "vmc/MPIVMC.hpp"
 
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_linalg.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+
 namespace vmc
 {
 
@@ -38,6 +45,274 @@ void add_norm_fgrad(const double * const vp, const int nvp, double &f, double *
 }
 
 
+void computeSRDirection(const int nvpi, const double * const obs, const double * const dobs, double * const grad_E, double * const dgrad_E, double * const condition)
+{
+    const auto nvp = static_cast<size_t>(nvpi);
+    const bool flag_dgrad = (dgrad_E != nullptr);
+
+    // create pointers for ease of use and readability
+    const double * const H = obs;
+    const double * const dH = dobs;
+    const double * const Oi = obs + 4;
+    const double * const dOi = dobs + 4;
+    const double * const HOi = obs + 4 + nvp;
+    const double * const dHOi = dobs + 4 + nvp;
+    const double * const OiOj = obs + 4 + 2*nvp;
+    const double * const dOiOj = dobs + 4 + 2*nvp;
+
+
+    // --- compute direction (or gradient) to follow
+    gsl_matrix * sij = gsl_matrix_alloc(nvp, nvp);
+    gsl_matrix * rdsij = flag_dgrad ? gsl_matrix_alloc(nvp, nvp) : nullptr;   // relative error, i.e. error/value
+    for (size_t i = 0; i < nvp; ++i) {
+        for (size_t j = 0; j < nvp; ++j) {
+            gsl_matrix_set(sij, i, j, OiOj[i*nvp + j] - Oi[i]*Oi[j]);
+            if (flag_dgrad) {
+                gsl_matrix_set(rdsij, i, j,
+                               (dOiOj[i*nvp + j] + fabs(Oi[i]*Oi[j])*((dOi[i]/Oi[i]) + (dOi[j]/Oi[j])))
+                               /gsl_matrix_get(sij, i, j));
+            }
+        }
+    }
+    gsl_vector * fi = gsl_vector_alloc(nvp);
+    gsl_vector * rdfi = flag_dgrad ? gsl_vector_alloc(nvp) : nullptr;   // relative error, i.e. error/value
+    for (size_t i = 0; i < nvp; ++i) {
+        gsl_vector_set(fi, i, H[0]*Oi[i] - HOi[i]);
+        if (flag_dgrad) {
+            gsl_vector_set(rdfi, i,
+                           (fabs(H[0]*Oi[i])*((dH[0]/H[0]) + (dOi[i]/Oi[i])) + dHOi[i])
+                           /gsl_vector_get(fi, i));
+        }
+    }
+    // invert matrix using SVD
+    const double SVD_MIN = 1.0e-9;
+    // matrix and vectors needed for the SVD
+    gsl_matrix * V = gsl_matrix_alloc(nvp, nvp);
+    gsl_vector * S = gsl_vector_alloc(nvp);
+    gsl_vector * work = gsl_vector_alloc(nvp);
+    // run the Single Value Decomposition
+    gsl_linalg_SV_decomp(sij, V, S, work);
+    if (condition != nullptr) { // singular values are sorted in descending order
+        const double smin = gsl_vector_get(S, nvp - 1);
+        *condition = (smin > 0.) ? gsl_vector_get(S, 0)/smin : std::numeric_limits<double>::infinity();
+    }
+    // assemble the inverse matrix
+    gsl_matrix * Isij = gsl_matrix_alloc(nvp, nvp);
+    for (size_t i = 0; i < nvp; ++i) {
+        for (size_t j = 0; j < nvp; ++j) {
+            gsl_matrix_set(Isij, i, j, 0.);
+        }
+    }
+    for (size_t i = 0; i < nvp; ++i) {
+        if (gsl_vector_get(S, i) > SVD_MIN*gsl_vector_get(S, 0)) {
+            gsl_matrix_set(Isij, i, i, 1./gsl_vector_get(S, i));
+        }
+        else {
+            gsl_matrix_set(Isij, i, i, 0.);
+        }
+    }
+    gsl_matrix * mm = gsl_matrix_alloc(nvp, nvp);
+    gsl_matrix_transpose(V);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, Isij, V, 0.0, mm);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, sij, mm, 0.0, Isij);
+    // --- finally find the direction to follow
+    for (size_t i = 0; i < nvp; ++i) {
+        grad_E[i] = 0.;
+        if (flag_dgrad) { dgrad_E[i] = 0.; }
+        for (size_t k = 0; k < nvp; ++k) {
+            double foo = gsl_vector_get(fi, k)*gsl_matrix_get(Isij, k, i);
+            grad_E[i] += foo;
+            if (flag_dgrad) {
+                dgrad_E[i] += fabs(foo)*(gsl_vector_get(rdfi, k) + gsl_matrix_get(rdsij, k, i));  // not correct, just a rough estimation
+            }
+        }
+    }
+
+    // free resources
+    gsl_matrix_free(mm);
+    gsl_vector_free(work);
+    gsl_vector_free(S);
+    gsl_matrix_free(V);
+    gsl_matrix_free(Isij);
+    if (flag_dgrad) { gsl_vector_free(rdfi); }
+    gsl_vector_free(fi);
+    if (flag_dgrad) { gsl_matrix_free(rdsij); }
+    gsl_matrix_free(sij);
+}
+
+// Subtract (sign -1) or add (sign +1) the products O_i*O_j of averages O_i to/from the rows [row0, row0 + nrows) of OiOj.
+// With allRanks, the rank-average of the products of every rank's averages O_i is used instead (collective).
+void shiftOiOjByProducts(const int nvp, const double * const Oi, const int row0, const int nrows, double * const OiOj,
+                         const double sign, const bool allRanks)
+{
+    const auto n = static_cast<size_t>(nvp);
+    const int nranks = allRanks ? MPIVMC::Size() : 1;
+    std::vector<double> allOi(Oi, Oi + n);
+    if (allRanks) {
+        allOi.resize(n*nranks);
+        MPIVMC::AllgatherRows(Oi, nranks, nvp, allOi.data());
+    }
+    const double fac = sign/nranks;
+    for (int r = 0; r < nranks; ++r) {
+        const double * const O = allOi.data() + r*n;
+        for (size_t i = 0; i < static_cast<size_t>(nrows); ++i) {
+            double * const row = OiOj + i*n;
+            const double fOi = fac*O[row0 + i];
+            for (size_t j = 0; j < n; ++j) { row[j] += fOi*O[j]; }
+        }
+    }
+}
+
+void reduceSRResults(const int nvp, double * const obs, double * const dobs, const bool singlePrecision)
+{
+    const int nhead = 4 + 2*nvp; // H, O_i, H*O_i
+    const int ntot = nhead + nvp*nvp;
+    if (!singlePrecision) {
+        MPIVMC::ReduceResults(obs, dobs, ntot);
+        return;
+    }
+    const std::vector<double> Oi(obs + 4, obs + 4 + nvp); // of this rank
+    shiftOiOjByProducts(nvp, Oi.data(), 0, nvp, obs + nhead, -1., false);
+    MPIVMC::ReduceResults(obs, dobs, ntot, nhead);
+    shiftOiOjByProducts(nvp, Oi.data(), 0, nvp, obs + nhead, 1., true);
+}
+
+void reduceScatterSRResults(const int nvp, double * const lobs, const double * const ldobs, double * const obs, double * const dobs,
+                            std::vector<double> &OiOjRows, const bool singlePrecision)
+{
+    const auto nhead = static_cast<size_t>(4 + 2*nvp); // H, O_i, H*O_i
+
+    // combine means and (independent) errors of the vectors, as MPIVMC::Integrate
+    std::copy(lobs, lobs + nhead, obs);
+    std::copy(ldobs, ldobs + nhead, dobs);
+    MPIVMC::ReduceResults(obs, dobs, static_cast<int>(nhead));
+
+    // O_i*O_j: every rank only receives its own row block
+    const std::vector<int> offsets = MPIVMC::RowOffsets(nvp);
+    const int myrank = MPIVMC::MyRank();
+    const int size = MPIVMC::Size();
+    const int nrows = offsets[myrank + 1] - offsets[myrank];
+    if (singlePrecision) { shiftOiOjByProducts(nvp, lobs + 4, 0, nvp, lobs + nhead, -1., false); } // see reduceSRResults
+    OiOjRows.resize(static_cast<size_t>(nrows)*nvp);
+    MPIVMC::ReduceScatterRows(lobs + nhead, nvp, nvp, OiOjRows.data(), singlePrecision);
+    for (double &v : OiOjRows) { v /= size; }
+    if (singlePrecision) { shiftOiOjByProducts(nvp, lobs + 4, offsets[myrank], nrows, OiOjRows.data(), 1., true); }
+}
+
+// Condition number estimate of the matrix solved by CG with the coefficients alpha_k (step lengths) and beta_k
+// (direction updates), as ratio of the extreme singular values of the equivalent Lanczos tridiagonal matrix
+double cgConditionEstimate(const std::vector<double> &alpha, const std::vector<double> &beta)
+{
+    const size_t n = alpha.size();
+    if (n == 0) { return std::numeric_limits<double>::quiet_NaN(); }
+    gsl_matrix * T = gsl_matrix_alloc(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            gsl_matrix_set(T, i, j, 0.);
+        }
+    }
+    for (size_t k = 0; k < n; ++k) {
+        gsl_matrix_set(T, k, k, 1./alpha[k] + ((k > 0) ? beta[k - 1]/alpha[k - 1] : 0.));
+        if (k + 1 < n) {
+            const double offdiag = sqrt(beta[k])/alpha[k];
+            gsl_matrix_set(T, k, k + 1, offdiag);
+            gsl_matrix_set(T, k + 1, k, offdiag);
+        }
+    }
+    gsl_matrix * V = gsl_matrix_alloc(n, n);
+    gsl_vector * S = gsl_vector_alloc(n);
+    gsl_vector * work = gsl_vector_alloc(n);
+    gsl_linalg_SV_decomp(T, V, S, work);
+    const double smin = gsl_vector_get(S, n - 1); // sorted in descending order
+    const double condition = (smin > 0.) ? gsl_vector_get(S, 0)/smin : std::numeric_limits<double>::infinity();
+    gsl_vector_free(work);
+    gsl_vector_free(S);
+    gsl_matrix_free(V);
+    gsl_matrix_free(T);
+    return condition;
+}
+
+int computeSRDirectionDistributed(const int nvpi, const double * const obs, const double * const dobs, const double * const OiOjRows, double * const grad_E,
+                                  double * const dgrad_E, const double tolerance, const int maxIter, const double shift, double * const condition)
+{
+    const auto nvp = static_cast<size_t>(nvpi);
+    const std::vector<int> offsets = MPIVMC::RowOffsets(nvpi);
+    const int myrank = MPIVMC::MyRank();
+    const auto row0 = static_cast<size_t>(offsets[myrank]);
+    const auto nrows = static_cast<size_t>(offsets[myrank + 1]) - row0;
+
+    // create pointers for ease of use and readability
+    const double * const H = obs;
+    const double * const dH = dobs;
+    const double * const Oi = obs + 4;
+    const double * const dOi = dobs + 4;
+    const double * const HOi = obs + 4 + nvp;
+    const double * const dHOi = dobs + 4 + nvp;
+
+    // diagonal shift, relative to the largest diagonal element of S_ij
+    std::vector<double> diag(nvp), ldiag(nrows);
+    for (size_t i = 0; i < nrows; ++i) {
+        ldiag[i] = OiOjRows[i*nvp + row0 + i] - Oi[row0 + i]*Oi[row0 + i];
+    }
+    MPIVMC::AllgatherRows(ldiag.data(), nvpi, 1, diag.data());
+    const double mu = (nvp > 0) ? shift*std::max(0., *std::max_element(diag.begin(), diag.end())) : 0.;
+
+    // (S_ij + mu*delta_ij)*v: the rows of this rank are computed locally and then gathered
+    std::vector<double> lSv(nrows);
+    const auto applyS = [&](const std::vector<double> &v, std::vector<double> &Sv) {
+        const double Ov = std::inner_product(Oi, Oi + nvp, v.begin(), 0.);
+        for (size_t i = 0; i < nrows; ++i) {
+            const double * const row = OiOjRows + i*nvp;
+            lSv[i] = std::inner_product(row, row + nvp, v.begin(), 0.) - Oi[row0 + i]*Ov + mu*v[row0 + i];
+        }
+        MPIVMC::AllgatherRows(lSv.data(), nvpi, 1, Sv.data());
+    };
+
+    // conjugate gradients, starting from x = 0 (all ranks do the same iterations on the same gathered values)
+    const int maxit = (maxIter > 0) ? maxIter : nvpi;
+    std::vector<double> cgAlpha, cgBeta; // coefficients of the last solve
+    const auto solve = [&](const std::vector<double> &b, double * const x) {
+        std::vector<double> r(b), p(b), Sp(nvp);
+        cgAlpha.clear();
+        cgBeta.clear();
+        std::fill(x, x + nvp, 0.);
+        double rr = std::inner_product(r.begin(), r.end(), r.begin(), 0.);
+        const double bnorm = sqrt(rr);
+        int iter = 0;
+        while (iter < maxit && sqrt(rr) > tolerance*bnorm) {
+            applyS(p, Sp);
+            const double pSp = std::inner_product(p.begin(), p.end(), Sp.begin(), 0.);
+            if (!(pSp > 0.)) { break; } // no descent left (singular direction)
+            const double alpha = rr/pSp;
+            for (size_t i = 0; i < nvp; ++i) {
+                x[i] += alpha*p[i];
+                r[i] -= alpha*Sp[i];
+            }
+            const double rrnew = std::inner_product(r.begin(), r.end(), r.begin(), 0.);
+            for (size_t i = 0; i < nvp; ++i) { p[i] = r[i] + (rrnew/rr)*p[i]; }
+            cgAlpha.push_back(alpha);
+            cgBeta.push_back(rrnew/rr);
+            rr = rrnew;
+            ++iter;
+        }
+        return iter;
+    };
+
+    // --- find the direction to follow
+    std::vector<double> fi(nvp);
+    for (size_t i = 0; i < nvp; ++i) { fi[i] = H[0]*Oi[i] - HOi[i]; }
+    const int niter = solve(fi, grad_E);
+    if (condition != nullptr) { *condition = cgConditionEstimate(cgAlpha, cgBeta); }
+
+    if (dgrad_E != nullptr) { // propagate the absolute errors of the forces (just a rough estimation)
+        for (size_t i = 0; i < nvp; ++i) { fi[i] = fabs(Oi[i])*dH[0] + fabs(H[0])*dOi[i] + dHOi[i]; }
+        solve(fi, dgrad_E);
+        for (size_t i = 0; i < nvp; ++i) { dgrad_E[i] = fabs(dgrad_E[i]); }
+    }
+    return niter;
+}
+
+
 void StochasticReconfigurationTargetFunction::_integrate(const double * const vp, double * const obs, double * const dobs, const bool flag_grad, const bool flag_dgrad)
 {
     // set the variational parameters given as input
@@ -45,25 +320,85 @@ void StochasticReconfigurationTargetFunction::_integrate(const double * const vp
 
     // set up the MC integrator
     if (flag_grad) { // add gradient obs if necessary
-        // skip MC error for grad if flag_dgrad is false
-        const int blocksize = flag_dgrad ? _vmc.getBlockSizeEG() : 0;
+        // skip MC error for grad if flag_dgrad is false (and we don't sample adaptively)
+        const int blocksize = (flag_dgrad || _grad_targetErr > 0.) ? _vmc.getBlockSizeEG() : 0;
         _vmc.getMCI().addObservable(StochasticReconfigurationMCObservable(_vmc.getNTotalDim(), _vmc.getNVP()),
                                     blocksize, _vmc.getNSkipEG(), false, blocksize > 0);
     }
 
     // perform the integral and store the values (skip extra burning phase on gradient runs (only findMRT2))
-    _vmc.computeEnergy(flag_grad ? _grad_E_Nmc : _E_Nmc, obs, dobs, true, !flag_grad);
+    const double targetErr = flag_grad ? _grad_targetErr : _E_targetErr;
+    int64_t nmc = flag_grad ? _grad_E_Nmc : _E_Nmc;
+    if (targetErr > 0.) {
+        const int64_t Ninit = flag_grad ? _grad_E_Nmc : _E_Nmc;
+        const int nvp = _vmc.getNVP();
+        std::function<double(const double *, const double *)> errfun; // defaults to the energy error
+        if (flag_grad) { errfun = [nvp](const double * o, const double * d) { return energyGradientErrorNorm(nvp, o, d); }; }
+        nmc = _vmc.computeEnergyAdaptive(targetErr, Ninit, _maxNmcFactor*Ninit, obs, dobs, true, !flag_grad, errfun);
+    }
+    else if (_overlapNchunk > 0) { // pops the gradient obs before the overlap sampling
+        this->_computeEnergyOverlapped(nmc, obs, dobs, flag_grad ? 1 : 0, !flag_grad);
+    }
+    else if (flag_grad && _singlePrecisionReduction) { // O_i*O_j in float32, the rest in double
+        _vmc.computeEnergyUnreduced(nmc, obs, dobs, true, false); // same share Nmc/Size() per rank as computeEnergy
+        reduceSRResults(_vmc.getNVP(), obs, dobs, true);
+    }
+    else {
+        _vmc.computeEnergy(nmc, obs, dobs, true, !flag_grad);
+    }
+    if (_telemetry != nullptr) {
+        _telemetry->current().nmc += nmc;
+        _telemetry->current().acceptance = _vmc.getMCI().getAcceptanceRate();
+    }
 
     // remove gradient obs again
-    if (flag_grad) { _vmc.getMCI().popObservable(); }
+    if (flag_grad && (_overlapNchunk <= 0 || targetErr > 0.)) { _vmc.getMCI().popObservable(); }
+}
+
+void StochasticReconfigurationTargetFunction::_integrateDistributed(const double * const vp, double * const obs, double * const dobs,
+                                                                   std::vector<double> &OiOjRows, const bool flag_dgrad)
+{
+    // set the variational parameters given as input
+    _vmc.setVP(vp);
+    const int nvp = _vmc.getNVP();
+    const auto nhead = static_cast<size_t>(4 + 2*nvp); // H, O_i, H*O_i
+
+    // sample on this rank only (skip extra burning phase, as on all gradient runs)
+    const int blocksize = flag_dgrad ? _vmc.getBlockSizeEG() : 0;
+    _vmc.getMCI().addObservable(StochasticReconfigurationMCObservable(_vmc.getNTotalDim(), nvp),
+                                blocksize, _vmc.getNSkipEG(), false, blocksize > 0);
+    std::vector<double> lobs(nhead + static_cast<size_t>(nvp)*nvp), ldobs(lobs.size());
+    _vmc.computeEnergyUnreduced(_grad_E_Nmc, lobs.data(), ldobs.data(), true, false);
+    if (_telemetry != nullptr) {
+        _telemetry->current().nmc += _grad_E_Nmc;
+        _telemetry->current().acceptance = _vmc.getMCI().getAcceptanceRate();
+    }
+    _vmc.getMCI().popObservable();
+
+    ldobs.resize(nhead); // errors of O_i*O_j are not needed
+    reduceScatterSRResults(nvp, lobs.data(), ldobs.data(), obs, dobs, OiOjRows, _singlePrecisionReduction);
 }
 
 void StochasticReconfigurationTargetFunction::_calcObs(const double * const vp, double &f, double &df, double * const grad_E, double * const dgrad_E)
 {
+    VMC_PROFILE_SCOPE(TargetFunction);
     const auto nvp = static_cast<size_t>(_vmc.getNVP());
     const bool flag_grad = (grad_E != nullptr);
     const bool flag_dgrad = (dgrad_E != nullptr);
 
+    if (flag_grad && _distributedSolve && _grad_targetErr <= 0.) {
+        double obs[4 + 2*nvp];
+        double dobs[4 + 2*nvp];
+        std::vector<double> OiOjRows;
+        _integrateDistributed(vp, obs, dobs, OiOjRows, flag_dgrad);
+        f = obs[0];
+        df = dobs[0];
+        VMC_PROFILE_SCOPE(GradientSolve);
+        computeSRDirectionDistributed(static_cast<int>(nvp), obs, dobs, OiOjRows.data(), grad_E, dgrad_E, _cgTolerance, _cgMaxIter, 1.e-9,
+                                      (_telemetry != nullptr) ? &_telemetry->current().srCondition : nullptr);
+        return;
+    }
+
     double obs[flag_grad ? 4 + 2*nvp + nvp*nvp : 4];
     double dobs[flag_grad ? 4 + 2*nvp + nvp*nvp : 4];
 
@@ -73,114 +408,49 @@ void StochasticReconfigurationTargetFunction::_calcObs(const double * const vp,
     df = dobs[0];
 
     if (flag_grad) {
-        // create pointers for ease of use and readability
-        double * const H = obs;
-        double * const dH = dobs;
-        double * const Oi = obs + 4;
-        double * const dOi = dobs + 4;
-        double * const HOi = obs + 4 + nvp;
-        double * const dHOi = dobs + 4 + nvp;
-        double * const OiOj = obs + 4 + 2*nvp;
-        double * const dOiOj = dobs + 4 + 2*nvp;
-
-
-        // --- compute direction (or gradient) to follow
-        gsl_matrix * sij = gsl_matrix_alloc(nvp, nvp);
-        gsl_matrix * rdsij = flag_dgrad ? gsl_matrix_alloc(nvp, nvp) : nullptr;   // relative error, i.e. error/value
-        for (size_t i = 0; i < nvp; ++i) {
-            for (size_t j = 0; j < nvp; ++j) {
-                gsl_matrix_set(sij, i, j, OiOj[i*nvp + j] - Oi[i]*Oi[j]);
-                if (flag_dgrad) {
-                    gsl_matrix_set(rdsij, i, j,
-                                   (dOiOj[i*nvp + j] + fabs(Oi[i]*Oi[j])*((dOi[i]/Oi[i]) + (dOi[j]/Oi[j])))
-                                   /gsl_matrix_get(sij, i, j));
-                }
-            }
-        }
-        gsl_vector * fi = gsl_vector_alloc(nvp);
-        gsl_vector * rdfi = flag_dgrad ? gsl_vector_alloc(nvp) : nullptr;   // relative error, i.e. error/value
-        for (size_t i = 0; i < nvp; ++i) {
-            gsl_vector_set(fi, i, H[0]*Oi[i] - HOi[i]);
-            if (flag_dgrad) {
-                gsl_vector_set(rdfi, i,
-                               (fabs(H[0]*Oi[i])*((dH[0]/H[0]) + (dOi[i]/Oi[i])) + dHOi[i])
-                               /gsl_vector_get(fi, i));
-            }
-        }
-        // invert matrix using SVD
-        const double SVD_MIN = 1.0e-9;
-        // matrix and vectors needed for the SVD
-        gsl_matrix * V = gsl_matrix_alloc(nvp, nvp);
-        gsl_vector * S = gsl_vector_alloc(nvp);
-        gsl_vector * work = gsl_vector_alloc(nvp);
-        // run the Single Value Decomposition
-        gsl_linalg_SV_decomp(sij, V, S, work);
-        // assemble the inverse matrix
-        gsl_matrix * Isij = gsl_matrix_alloc(nvp, nvp);
-        for (size_t i = 0; i < nvp; ++i) {
-            for (size_t j = 0; j < nvp; ++j) {
-                gsl_matrix_set(Isij, i, j, 0.);
-            }
-        }
-        for (size_t i = 0; i < nvp; ++i) {
-            if (gsl_vector_get(S, i) > SVD_MIN*gsl_vector_get(S, 0)) {
-                gsl_matrix_set(Isij, i, i, 1./gsl_vector_get(S, i));
-            }
-            else {
-                gsl_matrix_set(Isij, i, i, 0.);
-            }
-        }
-        gsl_matrix * mm = gsl_matrix_alloc(nvp, nvp);
-        gsl_matrix_transpose(V);
-        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, Isij, V, 0.0, mm);
-        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, sij, mm, 0.0, Isij);
-        // --- finally find the direction to follow
-        for (size_t i = 0; i < nvp; ++i) {
-            grad_E[i] = 0.;
-            if (flag_dgrad) { dgrad_E[i] = 0.; }
-            for (size_t k = 0; k < nvp; ++k) {
-                double foo = gsl_vector_get(fi, k)*gsl_matrix_get(Isij, k, i);
-                grad_E[i] += foo;
-                if (flag_dgrad) {
-                    dgrad_E[i] += fabs(foo)*(gsl_vector_get(rdfi, k) + gsl_matrix_get(rdsij, k, i));  // not correct, just a rough estimation
-                }
-            }
-        }
-
-        // free resources
-        gsl_matrix_free(mm);
-        gsl_vector_free(work);
-        gsl_vector_free(S);
-        gsl_matrix_free(V);
-        gsl_matrix_free(Isij);
-        if (flag_dgrad) { gsl_vector_free(rdfi); }
-        gsl_vector_free(fi);
-        if (flag_dgrad) { gsl_matrix_free(rdsij); }
-        gsl_matrix_free(sij);
+        VMC_PROFILE_SCOPE(GradientSolve);
+        computeSRDirection(static_cast<int>(nvp), obs, dobs, grad_E, dgrad_E, (_telemetry != nullptr) ? &_telemetry->current().srCondition : nullptr);
     }
 }
 
 
 nfm::NoisyValue StochasticReconfigurationTargetFunction::f(const std::vector<double> &vp)
 {
+    if (_telemetry != nullptr) { _telemetry->begin("sr", "f"); }
     nfm::NoisyValue f;
     _calcObs(vp.data(), f.val, f.err);
     if (_lambda_reg > 0) { add_norm_f(vp.data(), _vmc.getNVP(), f.val, _lambda_reg); }
+    if (_telemetry != nullptr) {
+        _telemetry->setResult(vp.data(), _vmc.getNVP(), f.val, f.err);
+        _telemetry->end();
+    }
     return f;
 }
 
 void StochasticReconfigurationTargetFunction::grad(const std::vector<double> &vp, nfm::NoisyGradient &grad)
 {
+    if (_telemetry != nullptr) { _telemetry->begin("sr", "grad"); }
     double f, df; // dummies
     _calcObs(vp.data(), f, df, grad.val.data(), this->hasGradErr() ? grad.err.data() : nullptr);
     if (_lambda_reg > 0) { add_norm_grad(vp.data(), _vmc.getNVP(), grad.val.data(), _lambda_reg); }
+    if (_telemetry != nullptr) {
+        _telemetry->setResult(vp.data(), _vmc.getNVP(), f, df, grad.val.data(), this->hasGradErr() ? grad.err.data() : nullptr);
+        _telemetry->end();
+    }
+    this->_checkpointIteration(vp);
 }
 
 nfm::NoisyValue StochasticReconfigurationTargetFunction::fgrad(const std::vector<double> &vp, nfm::NoisyGradient &grad)
 {
+    if (_telemetry != nullptr) { _telemetry->begin("sr", "fgrad"); }
     nfm::NoisyValue f;
     _calcObs(vp.data(), f.val, f.err, grad.val.data(), this->hasGradErr() ? grad.err.data() : nullptr);
     if (_lambda_reg > 0) { add_norm_fgrad(vp.data(), _vmc.getNVP(), f.val, grad.val.data(), _lambda_reg); }
+    if (_telemetry != nullptr) {
+        _telemetry->setResult(vp.data(), _vmc.getNVP(), f.val, f.err, grad.val.data(), this->hasGradErr() ? grad.err.data() : nullptr);
+        _telemetry->end();
+    }
+    this->_checkpointIteration(vp);
     return f;
 }
 } // namespace vmc
@@ -109,6 +109,7 @@ void SymmetrizerWaveFunction::_newToOld()
 
 void SymmetrizerWaveFunction::computeAllDerivatives(const double * x)
 {
+    VMC_PROFILE_SCOPE(ComputeAllDerivatives);
     const int ndim = getTotalNDim();
     double xh[ndim]; // helper array for positions
     int idh[ndim]; // helper array for indices
@@ -178,6 +179,7 @@ double SymmetrizerWaveFunction::acceptanceFunction(const double * protoold, cons
 
 void SymmetrizerWaveFunction::protoFunction(const double * in, double * out)
 {
+    VMC_PROFILE_SCOPE(ProtoFunction);
     const int ndim = getTotalNDim();
     double outh[_wf->getNProto()], inh[ndim]; // helper arrays for input/output
     int counts[_npart], iter; // counters for heaps algorithm
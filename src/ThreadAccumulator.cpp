@@ -0,0 +1,146 @@
+#include "vmc/ThreadAccumulator.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Reweighting.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+namespace vmc
+{
+
+constexpr size_t ThreadAccumulator::CACHELINE;
+
+
+ThreadAccumulator::ThreadAccumulator(const int nobs, const int nthreads, const int64_t blocksize):
+        _nobs(nobs), _nthreads(nthreads), _blocksize(blocksize)
+{
+    if (nobs < 1) { throw std::invalid_argument("[ThreadAccumulator] nobs must be positive."); }
+    if (nthreads < 1) { throw std::invalid_argument("[ThreadAccumulator] nthreads must be positive."); }
+    if (blocksize < 0) { throw std::invalid_argument("[ThreadAccumulator] blocksize must be non-negative."); }
+
+    _slots.resize(static_cast<size_t>(_nthreads));
+    this->reset();
+}
+
+void ThreadAccumulator::reset()
+{
+    for (int it = 0; it < _nthreads; ++it) { this->initThread(it); }
+}
+
+void ThreadAccumulator::initThread(const int ithread)
+{
+    Slot &slot = _slots[ithread];
+    decltype(slot.sums)(2*static_cast<size_t>(_nobs) + 3, 0.).swap(slot.sums); // new allocation, touched here
+    decltype(slot.blocks)().swap(slot.blocks);
+    slot.indexed = false;
+}
+
+double * ThreadAccumulator::_newBlock(Slot &slot, const int64_t iblock)
+{
+    slot.blocks.resize(slot.blocks.size() + _blockLength(), 0.);
+    double * const block = &slot.blocks[slot.blocks.size() - _blockLength()];
+    block[0] = static_cast<double>(iblock);
+    return block;
+}
+
+std::vector<double> ThreadAccumulator::_mergedBlocks() const
+{
+    const size_t blen = _blockLength();
+    std::vector<double> merged;
+    bool indexed = false;
+    for (const Slot &slot : _slots) { indexed = indexed || slot.indexed; }
+    if (indexed) { // sum up the parts of the same block, in thread order
+        std::map<int64_t, std::vector<double>> blocks;
+        for (const Slot &slot : _slots) {
+            for (size_t ib = 0; ib < slot.blocks.size(); ib += blen) {
+                std::vector<double> &block = blocks[static_cast<int64_t>(slot.blocks[ib])];
+                block.resize(blen, 0.);
+                for (size_t i = 1; i < blen; ++i) { block[i] += slot.blocks[ib + i]; }
+            }
+        }
+        for (const auto &block : blocks) { merged.insert(merged.end(), block.second.begin(), block.second.end()); }
+    }
+    else { // complete blocks of every thread
+        for (const Slot &slot : _slots) {
+            for (size_t ib = 0; ib < slot.blocks.size(); ib += blen) {
+                if (slot.blocks[ib + 1] == static_cast<double>(_blocksize)) {
+                    merged.insert(merged.end(), slot.blocks.begin() + ib, slot.blocks.begin() + ib + blen);
+                }
+            }
+        }
+    }
+    return merged;
+}
+
+
+int64_t ThreadAccumulator::getNSamples() const
+{
+    int64_t nsamples = 0;
+    for (int it = 0; it < _nthreads; ++it) { nsamples += getNSamples(it); }
+    return nsamples;
+}
+
+int64_t ThreadAccumulator::getNBlocks() const
+{
+    return isBlocking() ? static_cast<int64_t>(_mergedBlocks().size()/_blockLength()) : 0;
+}
+
+double ThreadAccumulator::getESS(const bool allRanks) const
+{
+    double wsums[2] = {0., 0.}; // sum w, sum w^2
+    for (const Slot &slot : _slots) {
+        wsums[0] += slot.sums[2*_nobs];
+        wsums[1] += slot.sums[2*_nobs + 1];
+    }
+    if (allRanks) { MPIVMC::AllreduceSum(wsums, 2); }
+    return effectiveSampleSize(wsums[0], wsums[1]);
+}
+
+void ThreadAccumulator::getResult(double * const average, double * const error, const bool allRanks) const
+{
+    // merge in thread order: sum w*x, sum w*x^2, sum w, sum w^2, nsamples
+    const size_t ntot = 2*static_cast<size_t>(_nobs) + 3;
+    std::vector<double> tot(ntot, 0.);
+    for (const Slot &slot : _slots) {
+        for (size_t i = 0; i < ntot; ++i) { tot[i] += slot.sums[i]; }
+    }
+    if (allRanks) { MPIVMC::AllreduceSum(tot.data(), static_cast<int>(ntot)); }
+    const double W = tot[2*_nobs], W2 = tot[2*_nobs + 1];
+    std::fill(average, average + _nobs, 0.);
+    std::fill(error, error + _nobs, 0.);
+    if (tot[2*_nobs + 2] == 0. || W == 0.) { return; }
+    for (int i = 0; i < _nobs; ++i) { average[i] = tot[i]/W; }
+
+    if (!isBlocking()) {
+        const double ess = effectiveSampleSize(W, W2); // the number of samples for equal weights
+        for (int i = 0; i < _nobs; ++i) {
+            const double var = std::max(0., tot[_nobs + i]/W - average[i]*average[i]);
+            error[i] = (ess > 1.) ? sqrt(var/(ess - 1.)) : 0.;
+        }
+        return;
+    }
+
+    // block variance of the ratio estimator (see Reweighting.hpp), centered on the average of the blocks that enter it
+    const size_t blen = _blockLength();
+    const std::vector<double> blocks = _mergedBlocks();
+    std::vector<double> bsum(static_cast<size_t>(_nobs) + 2, 0.); // sum w*x (nobs), sum w, number of blocks
+    for (size_t ib = 0; ib < blocks.size(); ib += blen) {
+        for (int i = 0; i < _nobs; ++i) { bsum[i] += blocks[ib + 3 + i]; }
+        bsum[_nobs] += blocks[ib + 2];
+        bsum[_nobs + 1] += 1.;
+    }
+    if (allRanks) { MPIVMC::AllreduceSum(bsum.data(), _nobs + 2); }
+    const double WB = bsum[_nobs], nb = bsum[_nobs + 1];
+    if (nb < 2. || WB == 0.) { return; }
+    for (size_t ib = 0; ib < blocks.size(); ib += blen) {
+        for (int i = 0; i < _nobs; ++i) {
+            const double d = blocks[ib + 3 + i] - bsum[i]/WB*blocks[ib + 2];
+            error[i] += d*d;
+        }
+    }
+    if (allRanks) { MPIVMC::AllreduceSum(error, _nobs); }
+    for (int i = 0; i < _nobs; ++i) { error[i] = sqrt(nb/(nb - 1.)*error[i])/WB; }
+}
+} // namespace vmc
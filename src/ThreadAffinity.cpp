@@ -0,0 +1,141 @@
+#include "vmc/ThreadAffinity.hpp"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+
+namespace vmc
+{
+
+namespace
+{
+#ifdef __linux__
+// CPUs of the affinity mask of the calling thread
+std::vector<int> getAffinity()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+        }
+    }
+    return cpus;
+}
+
+bool setAffinity(const std::vector<int> &cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// parse a sysfs cpulist like "0-3,8-11"
+std::vector<int> parseCPUList(const std::string &list)
+{
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) { end = list.size(); }
+        const std::string item = list.substr(pos, end - pos);
+        const size_t dash = item.find('-');
+        if (!item.empty()) {
+            const int first = std::atoi(item.c_str());
+            const int last = (dash != std::string::npos) ? std::atoi(item.c_str() + dash + 1) : first;
+            for (int cpu = first; cpu <= last; ++cpu) { cpus.push_back(cpu); }
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+std::vector<std::vector<int>> readTopology()
+{
+    const std::vector<int> allowed = getAffinity();
+    std::vector<std::pair<int, std::vector<int>>> nodes; // (node id, allowed cpus)
+
+    const std::string path = "/sys/devices/system/node";
+    DIR * const dir = opendir(path.c_str());
+    if (dir != nullptr) {
+        while (const dirent * const entry = readdir(dir)) {
+            const std::string name(entry->d_name);
+            if (name.compare(0, 4, "node") != 0 || name.size() < 5 || name.find_first_not_of("0123456789", 4) != std::string::npos) { continue; }
+            std::ifstream file(path + "/" + name + "/cpulist");
+            std::string list;
+            if (!std::getline(file, list)) { continue; }
+            std::vector<int> cpus;
+            for (const int cpu : parseCPUList(list)) {
+                if (std::binary_search(allowed.begin(), allowed.end(), cpu)) { cpus.push_back(cpu); }
+            }
+            if (!cpus.empty()) { nodes.emplace_back(std::atoi(name.c_str() + 4), cpus); }
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end());
+
+    std::vector<std::vector<int>> nodeCPUs;
+    for (auto &node : nodes) { nodeCPUs.push_back(std::move(node.second)); }
+    if (nodeCPUs.empty()) { nodeCPUs.push_back(allowed); } // no NUMA information
+    return nodeCPUs;
+}
+#endif
+} // namespace
+
+
+const std::vector<std::vector<int>> &NumaTopology::getNodeCPUs()
+{
+#ifdef __linux__
+    static const std::vector<std::vector<int>> nodeCPUs = readTopology();
+#else
+    static const std::vector<std::vector<int>> nodeCPUs(1);
+#endif
+    return nodeCPUs;
+}
+
+int NumaTopology::getWorkerNode(const int ithread, const int nthreads)
+{
+    return static_cast<int>(static_cast<int64_t>(ithread)*getNNodes()/std::max(1, nthreads));
+}
+
+int NumaTopology::getWorkerCPU(const int ithread, const int nthreads)
+{
+    const int node = getWorkerNode(ithread, nthreads);
+    const std::vector<int> &cpus = getNodeCPUs()[node];
+    if (cpus.empty()) { return -1; }
+    int ilocal = 0; // index of the worker within its node
+    for (int it = ithread - 1; it >= 0 && getWorkerNode(it, nthreads) == node; --it) { ++ilocal; }
+    return cpus[ilocal%cpus.size()];
+}
+
+
+ThreadPin::ThreadPin(const std::vector<int> &cpus)
+{
+#ifdef __linux__
+    if (cpus.empty()) { return; }
+    std::vector<int> oldcpus = getAffinity();
+    if (!oldcpus.empty() && setAffinity(cpus)) { _oldcpus = std::move(oldcpus); }
+#else
+    (void) cpus;
+#endif
+}
+
+ThreadPin::~ThreadPin()
+{
+#ifdef __linux__
+    if (!_oldcpus.empty()) { setAffinity(_oldcpus); }
+#endif
+}
+} // namespace vmc
@@ -0,0 +1,216 @@
+#include "vmc/Tracer.hpp"
+#include "vmc/MPIVMC.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace vmc
+{
+
+namespace
+{
+struct Span
+{
+    int phase;
+    int tid;
+    int64_t begin; // ns since the time origin
+    int64_t duration; // ns
+};
+
+struct ThreadSpans;
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<ThreadSpans *> live;
+    std::vector<Span> retired; // spans of finished threads
+    size_t retired_dropped = 0;
+    int nthreads = 0; // thread ids handed out so far
+    std::string filename;
+};
+
+Registry &registry()
+{
+    static Registry reg;
+    return reg;
+}
+
+std::atomic<int64_t> t0_ns(0); // time origin (steady_clock, ns)
+std::atomic<size_t> max_spans(0); // max spans per thread
+std::atomic<bool> trace_steps(false); // trace the per-step phases?
+
+int64_t toNS(const std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+struct ThreadSpans
+{
+    std::mutex mutex; // uncontended, except for getNSpans() / finalize()
+    int tid;
+    std::vector<Span> spans;
+    size_t dropped = 0;
+
+    ThreadSpans()
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        tid = reg.nthreads++;
+        reg.live.push_back(this);
+    }
+
+    ~ThreadSpans()
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.retired.insert(reg.retired.end(), spans.begin(), spans.end());
+        reg.retired_dropped += dropped;
+        reg.live.erase(std::find(reg.live.begin(), reg.live.end(), this));
+    }
+};
+
+ThreadSpans &localSpans()
+{
+    thread_local ThreadSpans ts;
+    return ts;
+}
+
+// collect and clear all spans of this process (registry mutex must be held)
+std::vector<Span> collectSpans(Registry &reg)
+{
+    std::vector<Span> all;
+    all.swap(reg.retired);
+    reg.retired_dropped = 0;
+    for (ThreadSpans * ts : reg.live) {
+        std::lock_guard<std::mutex> lock(ts->mutex);
+        all.insert(all.end(), ts->spans.begin(), ts->spans.end());
+        ts->spans.clear();
+        ts->dropped = 0;
+    }
+    return all;
+}
+
+// Chrome trace events of one rank, each followed by ",\n"
+std::string spansToEvents(const std::vector<Span> &spans, const int rank, const int nthreads)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << R"({"name": "process_name", "ph": "M", "pid": )" << rank << R"(, "args": {"name": "rank )" << rank << "\"}},\n";
+    out << R"({"name": "process_sort_index", "ph": "M", "pid": )" << rank << R"(, "args": {"sort_index": )" << rank << "}},\n";
+    for (int it = 0; it < nthreads; ++it) {
+        out << R"({"name": "thread_name", "ph": "M", "pid": )" << rank << ", \"tid\": " << it
+            << R"(, "args": {"name": "thread )" << it << "\"}},\n";
+    }
+    for (const Span &s : spans) {
+        out << "{\"name\": \"" << Profiler::getPhaseName(static_cast<ProfilePhase>(s.phase)) << R"(", "cat": "vmc", "ph": "X", "pid": )" << rank
+            << ", \"tid\": " << s.tid << ", \"ts\": " << 1e-3*s.begin << ", \"dur\": " << 1e-3*s.duration << "},\n";
+    }
+    return out.str();
+}
+} // namespace
+
+std::atomic<bool> Tracer::_active(false);
+
+
+void Tracer::start(const std::string &filename, const bool traceSteps, const size_t maxSpansPerThread)
+{
+    if (filename.empty()) { throw std::invalid_argument("[Tracer::start] filename must not be empty."); }
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.filename = filename;
+        collectSpans(reg); // discard old spans
+    }
+    max_spans = maxSpansPerThread;
+    trace_steps = traceSteps;
+
+    // common time origin on all ranks (up to the barrier latency)
+#if USE_MPI == 1
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    t0_ns = toNS(std::chrono::steady_clock::now());
+    _active.store(true, std::memory_order_release);
+}
+
+void Tracer::stop()
+{
+    _active.store(false, std::memory_order_release);
+}
+
+void Tracer::addSpan(const ProfilePhase phase, const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end)
+{
+    if (!trace_steps.load(std::memory_order_relaxed) && Tracer::isStepPhase(phase)) { return; }
+    ThreadSpans &ts = localSpans();
+    std::lock_guard<std::mutex> lock(ts.mutex);
+    if (ts.spans.size() >= max_spans.load(std::memory_order_relaxed)) {
+        ++ts.dropped;
+        return;
+    }
+    const int64_t b = toNS(begin);
+    ts.spans.push_back(Span{static_cast<int>(phase), ts.tid, b - t0_ns.load(std::memory_order_relaxed), toNS(end) - b});
+}
+
+size_t Tracer::getNSpans()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t n = reg.retired.size();
+    for (ThreadSpans * ts : reg.live) {
+        std::lock_guard<std::mutex> tlock(ts->mutex);
+        n += ts->spans.size();
+    }
+    return n;
+}
+
+size_t Tracer::getNDropped()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    size_t n = reg.retired_dropped;
+    for (ThreadSpans * ts : reg.live) {
+        std::lock_guard<std::mutex> tlock(ts->mutex);
+        n += ts->dropped;
+    }
+    return n;
+}
+
+void Tracer::finalize()
+{
+    Tracer::stop();
+    std::string filename, events;
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (reg.filename.empty()) { return; } // not started (consistent on all ranks)
+        filename.swap(reg.filename);
+        events = spansToEvents(collectSpans(reg), MPIVMC::MyRank(), reg.nthreads);
+    }
+
+#if USE_MPI == 1
+    // gather the events of all ranks on rank 0
+    const int nranks = MPIVMC::Size();
+    int len = static_cast<int>(events.size());
+    std::vector<int> lens(static_cast<size_t>(nranks)), displs(static_cast<size_t>(nranks), 0);
+    MPI_Gather(&len, 1, MPI_INT, lens.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    std::string allevents;
+    if (MPIVMC::MyRank() == 0) {
+        for (int i = 1; i < nranks; ++i) { displs[i] = displs[i - 1] + lens[i - 1]; }
+        allevents.resize(static_cast<size_t>(displs[nranks - 1] + lens[nranks - 1]));
+    }
+    MPI_Gatherv(&events[0], len, MPI_CHAR, &allevents[0], lens.data(), displs.data(), MPI_CHAR, 0, MPI_COMM_WORLD);
+    events.swap(allevents);
+#endif
+
+    if (MPIVMC::MyRank() == 0) {
+        if (events.size() >= 2) { events.resize(events.size() - 2); } // remove the last ",\n"
+        std::ofstream file(filename);
+        if (!file) { throw std::runtime_error("[Tracer::finalize] Failed to open file " + filename + " for writing."); }
+        file << "{\"traceEvents\": [\n" << events << "\n], \"displayTimeUnit\": \"ms\"}\n";
+    }
+}
+} // namespace vmc
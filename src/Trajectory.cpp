@@ -0,0 +1,285 @@
+#include "vmc/Trajectory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if USE_ZLIB == 1
+#include <zlib.h>
+#endif
+
+namespace vmc
+{
+
+// --- TrajectoryFormat
+
+constexpr uint32_t TrajectoryFormat::VERSION;
+constexpr size_t TrajectoryFormat::HEADER_BYTES;
+constexpr size_t TrajectoryFormat::CHUNK_HEADER_BYTES;
+const char TrajectoryFormat::MAGIC[8] = {'V', 'M', 'C', 'T', 'R', 'A', 'J', '\0'};
+
+bool TrajectoryFormat::hasCompression()
+{
+#if USE_ZLIB == 1
+    return true;
+#else
+    return false;
+#endif
+}
+
+namespace
+{
+size_t padTo8(const size_t nbytes) { return (nbytes + 7)/8*8; }
+} // namespace
+
+
+// --- TrajectoryWriter
+
+TrajectoryWriter::TrajectoryWriter(const std::string &filename, const int ndim, const int nproto, const int nobs, const int chunksize, const bool compress):
+        _ndim(ndim), _nproto(nproto), _nobs(nobs), _reclen(static_cast<size_t>(ndim + nproto + nobs)),
+        _chunksize(chunksize), _compress(compress)
+{
+    if (_ndim < 1 || _nproto < 0 || _nobs < 0 || _chunksize < 1) {
+        throw std::invalid_argument("[TrajectoryWriter] Invalid record or chunk size.");
+    }
+    if (_compress && !TrajectoryFormat::hasCompression()) {
+        throw std::invalid_argument("[TrajectoryWriter] Compression requested, but the library was built without zlib (USE_ZLIB).");
+    }
+
+    _file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!_file) { throw std::runtime_error("[TrajectoryWriter] Could not open file " + filename + "."); }
+    const uint32_t version = TrajectoryFormat::VERSION;
+    const int32_t dims[3] = {_ndim, _nproto, _nobs};
+    _file.write(TrajectoryFormat::MAGIC, sizeof(TrajectoryFormat::MAGIC));
+    _file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    _file.write(reinterpret_cast<const char *>(dims), sizeof(dims));
+    if (!_file) { throw std::runtime_error("[TrajectoryWriter] Failed writing header to file " + filename + "."); }
+
+    _front.resize(_reclen*_chunksize);
+    _back.resize(_reclen*_chunksize);
+    _thread = std::thread(&TrajectoryWriter::_run, this);
+}
+
+TrajectoryWriter::~TrajectoryWriter()
+{
+    try { this->close(); }
+    catch (...) {} // destructors must not throw
+}
+
+
+void TrajectoryWriter::_run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _cv.wait(lock, [this] { return _pending || _stop; });
+        if (_pending) {
+            lock.unlock(); // the main thread doesn't touch _back while _pending is true
+            std::string error;
+            try { this->_writeChunk(_back.data(), _nback); }
+            catch (const std::exception &e) { error = e.what(); }
+            lock.lock();
+            if (!error.empty() && _error.empty()) { _error = error; }
+            _pending = false;
+            _cv.notify_all();
+        }
+        else { // _stop and nothing left to write
+            break;
+        }
+    }
+}
+
+void TrajectoryWriter::_writeChunk(const double * const data, const int nrec)
+{
+    const auto * payload = reinterpret_cast<const char *>(data);
+    uint64_t nbytes = nrec*_reclen*sizeof(double);
+    uint32_t compressed = 0;
+
+#if USE_ZLIB == 1
+    std::vector<Bytef> zbuf;
+    if (_compress) {
+        uLongf zbytes = compressBound(static_cast<uLong>(nbytes));
+        zbuf.resize(zbytes);
+        if (compress2(zbuf.data(), &zbytes, reinterpret_cast<const Bytef *>(data), static_cast<uLong>(nbytes), Z_BEST_SPEED) != Z_OK) {
+            throw std::runtime_error("[TrajectoryWriter] zlib compression failed.");
+        }
+        payload = reinterpret_cast<const char *>(zbuf.data());
+        nbytes = zbytes;
+        compressed = 1;
+    }
+#endif
+
+    const auto nrec32 = static_cast<uint32_t>(nrec);
+    _file.write(reinterpret_cast<const char *>(&nrec32), sizeof(nrec32));
+    _file.write(reinterpret_cast<const char *>(&compressed), sizeof(compressed));
+    _file.write(reinterpret_cast<const char *>(&nbytes), sizeof(nbytes));
+    _file.write(payload, static_cast<std::streamsize>(nbytes));
+    const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    _file.write(zeros, static_cast<std::streamsize>(padTo8(nbytes) - nbytes));
+    if (!_file) { throw std::runtime_error("[TrajectoryWriter] Failed writing chunk to file."); }
+}
+
+
+void TrajectoryWriter::_checkError()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_error.empty()) { throw std::runtime_error(_error); }
+}
+
+void TrajectoryWriter::_waitIdle()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait(lock, [this] { return !_pending; });
+}
+
+void TrajectoryWriter::_handOver()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this] { return !_pending; }); // only blocks if the disk is slower than sampling
+        std::swap(_front, _back);
+        _nback = _nfront;
+        _nfront = 0;
+        _pending = true;
+    }
+    _cv.notify_all();
+    this->_checkError();
+}
+
+
+void TrajectoryWriter::append(const double * const x, const double * const proto, const double * const obs)
+{
+    if (!_thread.joinable()) { throw std::runtime_error("[TrajectoryWriter] Cannot append to closed trajectory."); }
+    double * const rec = _front.data() + _nfront*_reclen;
+    std::copy(x, x + _ndim, rec);
+    if (_nproto > 0) { std::copy(proto, proto + _nproto, rec + _ndim); }
+    if (_nobs > 0) { std::copy(obs, obs + _nobs, rec + _ndim + _nproto); }
+    ++_nrecords;
+    if (++_nfront == _chunksize) { this->_handOver(); }
+}
+
+void TrajectoryWriter::flush()
+{
+    if (!_thread.joinable()) { return; }
+    if (_nfront > 0) { this->_handOver(); }
+    this->_waitIdle();
+    _file.flush(); // background thread is idle now
+    this->_checkError();
+}
+
+void TrajectoryWriter::close()
+{
+    if (!_thread.joinable()) { return; }
+    this->flush();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    _thread.join();
+    _file.close();
+    this->_checkError();
+}
+
+
+// --- TrajectoryReader
+
+TrajectoryReader::TrajectoryReader(const std::string &filename)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) { throw std::runtime_error("[TrajectoryReader] Could not open file " + filename + "."); }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < TrajectoryFormat::HEADER_BYTES) {
+        ::close(fd);
+        throw std::runtime_error("[TrajectoryReader] File " + filename + " is not a trajectory file.");
+    }
+    _mapsize = static_cast<size_t>(st.st_size);
+    void * const map = mmap(nullptr, _mapsize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping stays valid
+    if (map == MAP_FAILED) { throw std::runtime_error("[TrajectoryReader] Could not map file " + filename + "."); }
+    _map = static_cast<const char *>(map);
+
+    // header
+    uint32_t version;
+    int32_t dims[3];
+    std::memcpy(&version, _map + 8, sizeof(version));
+    std::memcpy(dims, _map + 12, sizeof(dims));
+    if (std::memcmp(_map, TrajectoryFormat::MAGIC, sizeof(TrajectoryFormat::MAGIC)) != 0 || version != TrajectoryFormat::VERSION
+        || dims[0] < 1 || dims[1] < 0 || dims[2] < 0) {
+        munmap(const_cast<char *>(_map), _mapsize);
+        throw std::runtime_error("[TrajectoryReader] File " + filename + " is not a trajectory file of version " + std::to_string(TrajectoryFormat::VERSION) + ".");
+    }
+    _ndim = dims[0];
+    _nproto = dims[1];
+    _nobs = dims[2];
+    _reclen = static_cast<size_t>(_ndim + _nproto + _nobs);
+
+    // chunk index (an incomplete last chunk, e.g. of an interrupted run, is ignored)
+    size_t offset = TrajectoryFormat::HEADER_BYTES;
+    while (offset + TrajectoryFormat::CHUNK_HEADER_BYTES <= _mapsize) {
+        uint32_t nrec, compressed;
+        uint64_t nbytes;
+        std::memcpy(&nrec, _map + offset, sizeof(nrec));
+        std::memcpy(&compressed, _map + offset + 4, sizeof(compressed));
+        std::memcpy(&nbytes, _map + offset + 8, sizeof(nbytes));
+        const size_t payload = offset + TrajectoryFormat::CHUNK_HEADER_BYTES;
+        if (payload + nbytes > _mapsize) { break; }
+        if (compressed == 0 && nbytes != nrec*_reclen*sizeof(double)) {
+            munmap(const_cast<char *>(_map), _mapsize);
+            throw std::runtime_error("[TrajectoryReader] Corrupted chunk in file " + filename + ".");
+        }
+        _chunk_offset.push_back(payload);
+        _chunk_bytes.push_back(nbytes);
+        _chunk_nrec.push_back(static_cast<int>(nrec));
+        _chunk_compressed.push_back(compressed != 0);
+        _chunk_first.push_back(_nrecords);
+        _nrecords += nrec;
+        offset = payload + padTo8(nbytes);
+    }
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+    if (_map != nullptr) { munmap(const_cast<char *>(_map), _mapsize); }
+}
+
+
+const double * TrajectoryReader::getChunk(const int64_t ichunk, std::vector<double> &buffer) const
+{
+    if (ichunk < 0 || ichunk >= this->getNChunks()) {
+        throw std::out_of_range("[TrajectoryReader::getChunk] Invalid chunk index.");
+    }
+    if (!_chunk_compressed[ichunk]) { // mapped file is 8-byte aligned, see format
+        return reinterpret_cast<const double *>(_map + _chunk_offset[ichunk]);
+    }
+#if USE_ZLIB == 1
+    buffer.resize(_chunk_nrec[ichunk]*_reclen);
+    auto nbytes = static_cast<uLongf>(buffer.size()*sizeof(double));
+    if (uncompress(reinterpret_cast<Bytef *>(buffer.data()), &nbytes, reinterpret_cast<const Bytef *>(_map + _chunk_offset[ichunk]),
+                   static_cast<uLong>(_chunk_bytes[ichunk])) != Z_OK || nbytes != buffer.size()*sizeof(double)) {
+        throw std::runtime_error("[TrajectoryReader::getChunk] zlib decompression failed.");
+    }
+    return buffer.data();
+#else
+    (void) buffer;
+    throw std::runtime_error("[TrajectoryReader::getChunk] Compressed chunk, but the library was built without zlib (USE_ZLIB).");
+#endif
+}
+
+void TrajectoryReader::getRecord(const int64_t irec, double * const out) const
+{
+    if (irec < 0 || irec >= _nrecords) {
+        throw std::out_of_range("[TrajectoryReader::getRecord] Invalid record index.");
+    }
+    const auto it = std::upper_bound(_chunk_first.begin(), _chunk_first.end(), irec);
+    const int64_t ichunk = (it - _chunk_first.begin()) - 1;
+    std::vector<double> buffer;
+    const double * const chunk = this->getChunk(ichunk, buffer);
+    const double * const rec = chunk + (irec - _chunk_first[ichunk])*_reclen;
+    std::copy(rec, rec + _reclen, out);
+}
+} // namespace vmc
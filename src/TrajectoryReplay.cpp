@@ -0,0 +1,129 @@
+#include "vmc/TrajectoryReplay.hpp"
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Reweighting.hpp"
+#include "vmc/ThreadAccumulator.hpp"
+#include "vmc/ThreadAffinity.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vmc
+{
+
+namespace
+{
+void defaultBind(WaveFunction &wf, mci::ObservableFunctionInterface &obs)
+{
+    auto * const H = dynamic_cast<Hamiltonian *>(&obs);
+    if (H != nullptr) { H->bindWaveFunction(&wf); }
+}
+} // namespace
+
+
+TrajectoryReplay::TrajectoryReplay(const TrajectoryReader &reader, const int nthreads):
+        _reader(reader), _nthreads(1)
+{
+    this->setNThreads(nthreads);
+}
+
+void TrajectoryReplay::setNThreads(const int nthreads)
+{
+    if (nthreads < 0) { throw std::invalid_argument("[TrajectoryReplay] nthreads must be non-negative."); }
+    _nthreads = (nthreads > 0) ? nthreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+void TrajectoryReplay::setBlockSize(const int64_t blocksize)
+{
+    if (blocksize < 1) { throw std::invalid_argument("[TrajectoryReplay] blocksize must be positive."); }
+    _blocksize = blocksize;
+}
+
+void TrajectoryReplay::setNSkip(const int64_t nskip)
+{
+    if (nskip < 1) { throw std::invalid_argument("[TrajectoryReplay] nskip must be positive."); }
+    _nskip = nskip;
+}
+
+
+int64_t TrajectoryReplay::evaluate(const WaveFunction &wf, const mci::ObservableFunctionInterface &obs, double * const average, double * const error,
+                                   const bool reweight, const BindFunction &bind)
+{
+    const int ndim = _reader.getNDim();
+    const int nobs = obs.getNObs();
+    if (wf.getTotalNDim() != ndim || obs.getNDim() != ndim) {
+        throw std::invalid_argument("[TrajectoryReplay::evaluate] Dimension of wf or obs doesn't match the trajectory.");
+    }
+    if (reweight && _reader.getNProto() != wf.getNProto()) {
+        throw std::invalid_argument("[TrajectoryReplay::evaluate] Reweighting requires stored proto values compatible with wf.");
+    }
+
+    const int64_t nchunks = _reader.getNChunks();
+    const int nthreads = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(_nthreads, nchunks)));
+
+    // blocks by record index, i.e. independent of the assignment of chunks to threads
+    ThreadAccumulator acc(nobs, nthreads, _blocksize);
+    std::vector<std::string> errors(static_cast<size_t>(nthreads));
+    std::atomic<int64_t> nextchunk(0);
+
+    auto worker = [&](const int ithread) {
+        std::unique_ptr<ThreadPin> pin;
+        if (_pinthreads) {
+            pin.reset(new ThreadPin({NumaTopology::getWorkerCPU(ithread, nthreads)}));
+            acc.initThread(ithread); // on the node of the thread
+        }
+        try {
+            auto twf = wf.cloneWaveFunction();
+            auto tobs = obs.clone();
+            if (bind) { bind(*twf, *tobs); }
+            else { defaultBind(*twf, *tobs); }
+
+            std::vector<double> buffer, protonew(static_cast<size_t>(twf->getNProto())), out(static_cast<size_t>(nobs));
+            const size_t reclen = _reader.getRecordLength();
+            int64_t ic;
+            while ((ic = nextchunk++) < nchunks) { // increasing chunks, so increasing record indices per thread
+                const double * const chunk = _reader.getChunk(ic, buffer);
+                const int64_t first = _reader.getChunkFirstRecord(ic);
+                for (int64_t ir = 0; ir < _reader.getChunkNRecords(ic); ++ir) {
+                    const int64_t irec = first + ir;
+                    if (irec%_nskip != 0) { continue; }
+                    const double * const x = chunk + ir*reclen;
+                    double w = 1.;
+                    if (reweight) { w = reweightingFactor(*twf, x, x + ndim, protonew.data()); }
+                    twf->computeAllDerivatives(x);
+                    tobs->observableFunction(x, out.data());
+                    acc.accumulate(ithread, out.data(), w, irec);
+                }
+            }
+        }
+        catch (const std::exception &e) {
+            errors[ithread] = e.what();
+            nextchunk = nchunks; // stop the other threads early
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int it = 1; it < nthreads; ++it) { threads.emplace_back(worker, it); }
+    worker(0);
+    for (auto &t : threads) { t.join(); }
+    for (const auto &e : errors) {
+        if (!e.empty()) { throw std::runtime_error(e); }
+    }
+
+    // totals over all threads and ranks
+    double nused = static_cast<double>(acc.getNSamples());
+    MPIVMC::AllreduceSum(&nused, 1);
+    acc.getResult(average, error, true);
+    _ess = acc.getESS(true);
+    if (_ess <= 0.) {
+        throw std::runtime_error("[TrajectoryReplay::evaluate] No records with positive weight.");
+    }
+
+    return static_cast<int64_t>(nused);
+}
+} // namespace vmc
@@ -11,6 +11,8 @@ namespace vmc
 
 void TwoBodyJastrow::protoFunction(const double * x, double * protov)
 {
+    VMC_PROFILE_SCOPE(ProtoFunction);
+    _u2->syncVP(); // all pairs of one evaluation use the same (shared) parameters
     protov[0] = 0.;
     for (int i = 0; i < getNPart() - 1; ++i) {
         for (int j = i + 1; j < getNPart(); ++j) {
@@ -32,6 +34,8 @@ double TwoBodyJastrow::acceptanceFunction(const double * protoold, const double
 
 void TwoBodyJastrow::computeAllDerivatives(const double * x)
 {
+    VMC_PROFILE_SCOPE(ComputeAllDerivatives);
+    _u2->syncVP();
     double * d1_divbywf = _getD1DivByWF();
     for (int i = 0; i < getTotalNDim(); ++i) { d1_divbywf[i] = 0.; }
 
@@ -119,6 +123,77 @@ void TwoBodyJastrow::computeAllDerivatives(const double * x)
     }
 }
 
+void TwoBodyJastrow::protoFunctionBatch(const int nwalkers, const double * xs, double * protovs)
+{
+    VMC_PROFILE_SCOPE(ProtoFunction);
+    _u2->syncVP();
+    // in SoA layout, the coordinates of particle i (for all walkers) start at xs + i*nspacedim*nwalkers
+    const int pstride = getNSpaceDim()*nwalkers;
+    _bu.resize(static_cast<size_t>(nwalkers));
+    for (int w = 0; w < nwalkers; ++w) { protovs[w] = 0.; }
+    for (int i = 0; i < getNPart() - 1; ++i) {
+        for (int j = i + 1; j < getNPart(); ++j) {
+            _u2->uBatch(nwalkers, xs + i*pstride, xs + j*pstride, _bu.data());
+            for (int w = 0; w < nwalkers; ++w) { protovs[w] += _bu[w]; }
+        }
+    }
+}
+
+
+void TwoBodyJastrow::computeAllDerivativesBatch(const int nwalkers, const double * xs, double * d1s, double * d2s, double * vd1s)
+{
+    VMC_PROFILE_SCOPE(ComputeAllDerivatives);
+    _u2->syncVP();
+    const int nsd = getNSpaceDim();
+    const int pstride = nsd*nwalkers;
+    const int ndimw = getTotalNDim()*nwalkers;
+    const bool flag_vd1 = hasVD1() && vd1s != nullptr;
+    const auto nw = static_cast<size_t>(nwalkers);
+    _bd1.resize(2*nsd*nw);
+    _bd2.resize(2*nsd*nw);
+    _bvd1.resize(flag_vd1 ? getNVP()*nw : 0);
+
+    for (int i = 0; i < ndimw; ++i) {
+        d1s[i] = 0.;
+        d2s[i] = 0.;
+    }
+    if (flag_vd1) {
+        for (int i = 0; i < getNVP()*nwalkers; ++i) { vd1s[i] = 0.; }
+    }
+
+    // --- sum up the pair terms
+    for (int i = 0; i < getNPart() - 1; ++i) {
+        for (int j = i + 1; j < getNPart(); ++j) {
+            _u2->computeDerivativesBatch(nwalkers, xs + i*pstride, xs + j*pstride, _bd1.data(), _bd2.data(), flag_vd1 ? _bvd1.data() : nullptr);
+
+            for (int idim = 0; idim < nsd; ++idim) {
+                double * const d1i = d1s + i*pstride + idim*nwalkers;
+                double * const d1j = d1s + j*pstride + idim*nwalkers;
+                double * const d2i = d2s + i*pstride + idim*nwalkers;
+                double * const d2j = d2s + j*pstride + idim*nwalkers;
+                const double * const ud1i = _bd1.data() + idim*nw;
+                const double * const ud1j = _bd1.data() + (idim + nsd)*nw;
+                const double * const ud2i = _bd2.data() + idim*nw;
+                const double * const ud2j = _bd2.data() + (idim + nsd)*nw;
+                for (int w = 0; w < nwalkers; ++w) {
+                    d1i[w] += ud1i[w];
+                    d1j[w] += ud1j[w];
+                    d2i[w] += ud2i[w];
+                    d2j[w] += ud2j[w];
+                }
+            }
+            if (flag_vd1) {
+                for (int ivw = 0; ivw < getNVP()*nwalkers; ++ivw) { vd1s[ivw] += _bvd1[ivw]; }
+            }
+        }
+    }
+    // --- complete the second derivative
+    for (int i = 0; i < ndimw; ++i) {
+        d2s[i] += d1s[i]*d1s[i];
+    }
+}
+
+
 double TwoBodyJastrow::computeWFValue(const double * protovalues) const
 {
     return exp(protovalues[0]);
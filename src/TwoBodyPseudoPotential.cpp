@@ -1,8 +1,62 @@
 #include "vmc/TwoBodyPseudoPotential.hpp"
 
+#include <algorithm>
+#include <cstddef>
+
 namespace vmc
 {
 
+std::unique_ptr<TwoBodyPseudoPotential> TwoBodyPseudoPotential::clone() const
+{
+    std::unique_ptr<TwoBodyPseudoPotential> newu2(_clone());
+    newu2->_ownedMetric = _metric->clone();
+    newu2->_metric = newu2->_ownedMetric.get();
+
+    std::vector<double> vp(static_cast<size_t>(_nvp));
+    getVP(vp.data());
+    newu2->setVP(vp.data());
+    newu2->_sharedVP = _sharedVP; // the clone joins our parameter block, if any
+    newu2->_vpversion = _vpversion;
+    return newu2;
+}
+
+
+void TwoBodyPseudoPotential::shareVP()
+{
+    if (!_sharedVP) {
+        std::vector<double> vp(static_cast<size_t>(_nvp));
+        getVP(vp.data());
+        _sharedVP = std::make_shared<SharedVP>(vp.data(), _nvp);
+        _vpversion = _sharedVP->getVersion();
+    }
+}
+
+
+void TwoBodyPseudoPotential::publishVP(const double * vp)
+{
+    setVP(vp);
+    if (_sharedVP) { _vpversion = _sharedVP->publish(vp); }
+}
+
+
+void TwoBodyPseudoPotential::getLatestVP(double * vp) const
+{
+    if (_sharedVP) {
+        const auto snapshot = _sharedVP->load();
+        std::copy(snapshot->vp.begin(), snapshot->vp.end(), vp);
+    }
+    else { getVP(vp); }
+}
+
+
+void TwoBodyPseudoPotential::_pullVP()
+{
+    const auto snapshot = _sharedVP->load();
+    setVP(snapshot->vp.data());
+    _vpversion = snapshot->version;
+}
+
+
 double TwoBodyPseudoPotential::u(const double * r1, const double * r2)
 {
     return ur(_metric->dist(r1, r2));
@@ -53,6 +107,71 @@ void TwoBodyPseudoPotential::computeAllDerivatives(const double * r1, const doub
 }
 
 
+void TwoBodyPseudoPotential::uBatch(const int n, const double * r1s, const double * r2s, double * out)
+{
+    _br.resize(static_cast<size_t>(n));
+    _metric->distBatch(n, r1s, r2s, _br.data());
+    urBatch(n, _br.data(), out);
+}
+
+
+void TwoBodyPseudoPotential::computeDerivativesBatch(const int n, const double * r1s, const double * r2s, double * d1s, double * d2s, double * vd1s)
+{
+    const auto nsize = static_cast<size_t>(n);
+    _br.resize(nsize);
+    _bud1.resize(nsize);
+    _bud2.resize(nsize);
+    _bfoo.resize(_ndim2*nsize);
+    _bfoo2.resize(_ndim2*nsize);
+
+    _metric->distBatch(n, r1s, r2s, _br.data());
+    urD1Batch(n, _br.data(), _bud1.data());
+    urD2Batch(n, _br.data(), _bud2.data());
+    _metric->distD1Batch(n, r1s, r2s, _bfoo.data());
+    _metric->distD2Batch(n, r1s, r2s, _bfoo2.data());
+
+    const double * const ud1 = _bud1.data();
+    const double * const ud2 = _bud2.data();
+    for (int i = 0; i < _ndim2; ++i) {
+        const double * const foo = _bfoo.data() + i*nsize;
+        const double * const foo2 = _bfoo2.data() + i*nsize;
+        double * const d1 = d1s + i*n;
+        double * const d2 = d2s + i*n;
+        for (int k = 0; k < n; ++k) {
+            d1[k] = foo[k]*ud1[k];
+            d2[k] = foo2[k]*ud1[k] + foo[k]*foo[k]*ud2[k];
+        }
+    }
+
+    if (_flag_vd1 && vd1s != nullptr) { urVD1Batch(n, _br.data(), vd1s); }
+}
+
+
+void TwoBodyPseudoPotential::urBatch(const int n, const double * r, double * out)
+{
+    for (int k = 0; k < n; ++k) { out[k] = ur(r[k]); }
+}
+
+void TwoBodyPseudoPotential::urD1Batch(const int n, const double * r, double * out)
+{
+    for (int k = 0; k < n; ++k) { out[k] = urD1(r[k]); }
+}
+
+void TwoBodyPseudoPotential::urD2Batch(const int n, const double * r, double * out)
+{
+    for (int k = 0; k < n; ++k) { out[k] = urD2(r[k]); }
+}
+
+void TwoBodyPseudoPotential::urVD1Batch(const int n, const double * r, double * vd1s)
+{
+    std::vector<double> vd1(static_cast<size_t>(_nvp));
+    for (int k = 0; k < n; ++k) {
+        urVD1(r[k], vd1.data());
+        for (int i = 0; i < _nvp; ++i) { vd1s[i*n + k] = vd1[i]; }
+    }
+}
+
+
 TwoBodyPseudoPotential::TwoBodyPseudoPotential(Metric * metric, const int nvp, bool flag_vd1, bool flag_d1vd1, bool flag_d2vd1)
 {
     _metric = metric;
@@ -1,5 +1,9 @@
 #include "vmc/VMC.hpp"
 #include "vmc/MPIVMC.hpp"
+#include "vmc/TrajectoryRecorder.hpp"
+
+#include <algorithm>
+#include <vector>
 
 namespace vmc
 {
@@ -39,8 +43,84 @@ VMC::VMC(const WaveFunction &wf, const Hamiltonian &H, const int nskip_eg, const
 
 // --- compute quantities
 
+void VMC::_applySkipEquilibration(bool &doFindMRT2step, bool &doDecorrelation)
+{
+    if (_skip_equil) {
+        doFindMRT2step = false;
+        doDecorrelation = false;
+        _skip_equil = false;
+    }
+}
+
 void VMC::computeEnergy(int64_t Nmc, double * E, double * dE, bool doFindMRT2step, bool doDecorrelation)
 {
+    _applySkipEquilibration(doFindMRT2step, doDecorrelation);
     MPIVMC::Integrate(_mci, Nmc, E, dE, doFindMRT2step, doDecorrelation);
 }
+
+void VMC::computeEnergyUnreduced(int64_t Nmc, double * E, double * dE, bool doFindMRT2step, bool doDecorrelation)
+{
+    _applySkipEquilibration(doFindMRT2step, doDecorrelation);
+    VMC_PROFILE_SCOPE(Integrate);
+    _mci.integrate(Nmc/MPIVMC::Size(), E, dE, doFindMRT2step, doDecorrelation);
+}
+
+#if USE_MPI == 1
+void VMC::computeEnergyOnComm(MPI_Comm comm, int64_t Nmc, double * E, double * dE, bool doFindMRT2step, bool doDecorrelation)
+{
+    _applySkipEquilibration(doFindMRT2step, doDecorrelation);
+    MPIVMC::IntegrateOnComm(_mci, comm, Nmc, E, dE, doFindMRT2step, doDecorrelation);
+}
+#endif
+
+int64_t VMC::computeEnergyOverlapped(const int64_t Nmc, const int64_t Nchunk, double * E, double * dE, const int npop,
+                                     bool doFindMRT2step, bool doDecorrelation)
+{
+    _applySkipEquilibration(doFindMRT2step, doDecorrelation);
+    int npopped = 0;
+    std::vector<double> avg, err; // discarded results of the overlap sampling
+    const auto overlapWork = [&]() {
+        for (; npopped < npop; ++npopped) { _mci.popObservable(); }
+        avg.resize(static_cast<size_t>(_mci.getNObsDim()));
+        err.resize(avg.size());
+        VMC_PROFILE_SCOPE(Integrate);
+        _mci.integrate(Nchunk, avg.data(), err.data(), false, false);
+    };
+    const int ncalls = MPIVMC::IntegrateOverlapped(_mci, Nmc, E, dE, (Nchunk > 0) ? overlapWork : std::function<void()>(), doFindMRT2step, doDecorrelation);
+    for (; npopped < npop; ++npopped) { _mci.popObservable(); }
+    return ncalls*Nchunk;
+}
+
+void VMC::recordTrajectory(const int64_t Nmc, TrajectoryWriter &writer, double * E, double * dE, bool doFindMRT2step, bool doDecorrelation)
+{
+    // the recorder's dummy value is stored behind all other observables
+    _mci.addObservable(std::unique_ptr<mci::ObservableFunctionInterface>(new TrajectoryRecorder(*_wf, writer)), 0, _nskip_eg, false, false);
+    std::vector<double> obs(static_cast<size_t>(_mci.getNObsDim())), dobs(obs.size());
+    try {
+        this->computeEnergy(Nmc, obs.data(), dobs.data(), doFindMRT2step, doDecorrelation);
+    }
+    catch (...) {
+        _mci.popObservable();
+        throw;
+    }
+    _mci.popObservable();
+    std::copy(obs.begin(), obs.end() - 1, E);
+    std::copy(dobs.begin(), dobs.end() - 1, dE);
+}
+
+int64_t VMC::computeEnergyAdaptive(double targetError, int64_t Ninit, int64_t Nmax, double * E, double * dE, bool doFindMRT2step, bool doDecorrelation,
+                                   const std::function<double(const double *, const double *)> &errorFunction)
+{
+    _applySkipEquilibration(doFindMRT2step, doDecorrelation);
+    if (errorFunction) {
+        return MPIVMC::IntegrateAdaptive(_mci, Ninit, Nmax, targetError, E, dE, errorFunction, doFindMRT2step, doDecorrelation);
+    }
+    return MPIVMC::IntegrateAdaptive(_mci, Ninit, Nmax, targetError, E, dE, ElocID::ETot, doFindMRT2step, doDecorrelation);
+}
+
+int64_t VMC::computeEnergyTimed(double budget, int64_t Nchunk, double * E, double * dE, double targetError, double checkInterval, bool doFindMRT2step, bool doDecorrelation)
+{
+    _applySkipEquilibration(doFindMRT2step, doDecorrelation);
+    return MPIVMC::IntegrateTimed(_mci, budget, Nchunk, E, dE, targetError, checkInterval, doFindMRT2step, doDecorrelation);
+}
 } // namespace vmc
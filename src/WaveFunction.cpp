@@ -1,8 +1,25 @@
 #include "vmc/WaveFunction.hpp"
 
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
 namespace vmc
 {
 
+std::unique_ptr<WaveFunction> WaveFunction::cloneWaveFunction() const
+{
+    std::unique_ptr<WaveFunction> newwf(dynamic_cast<WaveFunction *>(this->clone().release()));
+    if (!newwf) {
+        throw std::runtime_error("[WaveFunction] clone() did not produce a type derived from WaveFunction.");
+    }
+    std::vector<double> vp(static_cast<size_t>(getNVP()));
+    getVP(vp.data());
+    newwf->setVP(vp.data());
+    return newwf;
+}
+
+
 void WaveFunction::setNVP(const int nvp)
 {
     _nvp = nvp;
@@ -63,6 +80,36 @@ WaveFunction::WaveFunction(const int nspacedim, const int npart, const int ncomp
 }
 
 
+void WaveFunction::protoFunctionBatch(const int nwalkers, const double * xs, double * protovs)
+{
+    const int ndim = getTotalNDim();
+    std::vector<double> x(static_cast<size_t>(ndim)), protov(static_cast<size_t>(getNProto()));
+    for (int w = 0; w < nwalkers; ++w) {
+        for (int i = 0; i < ndim; ++i) { x[i] = xs[i*nwalkers + w]; }
+        this->protoFunction(x.data(), protov.data());
+        for (int i = 0; i < getNProto(); ++i) { protovs[i*nwalkers + w] = protov[i]; }
+    }
+}
+
+
+void WaveFunction::computeAllDerivativesBatch(const int nwalkers, const double * xs, double * d1s, double * d2s, double * vd1s)
+{
+    const int ndim = getTotalNDim();
+    std::vector<double> x(static_cast<size_t>(ndim));
+    for (int w = 0; w < nwalkers; ++w) {
+        for (int i = 0; i < ndim; ++i) { x[i] = xs[i*nwalkers + w]; }
+        this->computeAllDerivatives(x.data());
+        for (int i = 0; i < ndim; ++i) {
+            d1s[i*nwalkers + w] = _d1_divbywf[i];
+            d2s[i*nwalkers + w] = _d2_divbywf[i];
+        }
+        if (hasVD1() && vd1s != nullptr) {
+            for (int i = 0; i < getNVP(); ++i) { vd1s[i*nwalkers + w] = _vd1_divbywf[i]; }
+        }
+    }
+}
+
+
 WaveFunction::~WaveFunction()
 {
     delete[] _d1_divbywf;
@@ -219,12 +219,12 @@ protected:
 
     mci::SamplingFunctionInterface * _clone() const final
     {
-        return new ConstNormGaussian1D1POrbital(_a, this->hasVD1());
+        return new ConstNormGaussian1D1POrbital(_a, this->hasVD1(), this->hasD1VD1(), this->hasD2VD1());
     }
 
 public:
-    explicit ConstNormGaussian1D1POrbital(double a, bool flag_vd1 = true):
-            WaveFunction(1, 1, 1, 1, flag_vd1, false, false),
+    explicit ConstNormGaussian1D1POrbital(double a, bool flag_vd1 = true, bool flag_d1vd1 = false, bool flag_d2vd1 = false):
+            WaveFunction(1, 1, 1, 1, flag_vd1, flag_d1vd1, flag_d2vd1),
             _a(a), _sqa(sqrt(a)), _asq(a*a), _asqsq((a*a)*(a*a)) {}
 
     void setVP(const double in[]) final
@@ -253,6 +253,13 @@ public:
         _setD1DivByWF(0, -_asq*in[0]);
         _setD2DivByWF(0, _asqsq*xsq - _asq);
         if (this->hasVD1()) { _setVD1DivByWF(0, (0.5/_a - _a*xsq)); }
+        if (this->hasD1VD1()) { // O = 0.5/a - a*x^2 with d/dx O = -2*a*x
+            const double vd1 = 0.5/_a - _a*xsq;
+            _setD1VD1DivByWF(0, 0, -2.*_a*in[0] + vd1*getD1DivByWF(0));
+            if (this->hasD2VD1()) {
+                _setD2VD1DivByWF(0, 0, -2.*_a + 4.*_a*_asq*xsq + vd1*getD2DivByWF(0));
+            }
+        }
     }
 
     double computeWFValue(const double protovalues[]) const final
@@ -289,8 +296,13 @@ class He3u2: public vmc::TwoBodyPseudoPotential
 private:
     double _b;
 
+    vmc::TwoBodyPseudoPotential * _clone() const final
+    {
+        return new He3u2(_metric);
+    }
+
 public:
-    explicit He3u2(vmc::EuclideanMetric * em):
+    explicit He3u2(vmc::Metric * em):
             vmc::TwoBodyPseudoPotential(em, 1, true, true, true)
     {
         _b = -1.;
@@ -340,8 +352,13 @@ class PolynomialU2: public vmc::TwoBodyPseudoPotential
 private:
     double _a, _b;
 
+    vmc::TwoBodyPseudoPotential * _clone() const final
+    {
+        return new PolynomialU2(_metric, _a, _b);
+    }
+
 public:
-    PolynomialU2(vmc::EuclideanMetric * em, double a, double b):
+    PolynomialU2(vmc::Metric * em, double a, double b):
             vmc::TwoBodyPseudoPotential(em, 2, true, true, true)
     {
         _a = a;
@@ -402,8 +419,13 @@ class FlatU2: public vmc::TwoBodyPseudoPotential
 private:
     double _K;
 
+    vmc::TwoBodyPseudoPotential * _clone() const final
+    {
+        return new FlatU2(_metric, _K);
+    }
+
 public:
-    FlatU2(vmc::EuclideanMetric * em, const double &K):
+    FlatU2(vmc::Metric * em, const double &K):
             vmc::TwoBodyPseudoPotential(em, 1, true, true, true)
     {
         _K = K;
@@ -0,0 +1,83 @@
+#include <cmath>
+#include <cassert>
+#include <iostream>
+#include <memory>
+
+#include "vmc/MPIVMC.hpp"
+#include "vmc/VMC.hpp"
+#include "vmc/EnergyGradientTargetFunction.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+    const double w = 1.0; // harmonic oscillator strength
+    const double p = 1.2; // not the exact ground state, i.e. finite variance
+
+    // For the p-parametrized gaussian
+    // Psi(x) ~ sqrt(p) e(-0.5*p^2*x^2)
+    // the energy should be E(p) = (w^2 + p^4)/(4 p^2)
+    // and the gradient d/dp E(p) = (p^4 - w^2)/(2 p^3). The target function's grad
+    // holds the descent direction -d/dp E(p) = (w^2 - p^4)/(2 p^3) (negative for p > sqrt(w)).
+    const double en_ana = (w*w + p*p*p*p)/(4.*p*p);
+    const double grad_ana = (w*w - p*p*p*p)/(2.*p*p*p);
+
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(p), make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vmc.getMCI().setTrialMove(mci::SRRDType::Gaussian);
+    vmc.getMCI().setSeed(1337 + 42*myrank); // fixed seed, such that the noisy asserts will always pass
+
+    const int64_t NINIT = 10000; // initial sampling increment
+    double E[4], dE[4];
+
+    // --- sample until the target error is reached
+    const double targetErr = 0.002;
+    const int64_t nsamples = vmc.computeEnergyAdaptive(targetErr, NINIT, 100*NINIT, E, dE);
+    if (myrank == 0 && verbose) {
+        cout << "E = " << E[0] << " +- " << dE[0] << " (ana: " << en_ana << ") with " << nsamples << " steps" << endl;
+    }
+    assert(nsamples >= NINIT);
+    assert(nsamples < 100*NINIT);
+    assert(dE[0] <= targetErr);
+    assert(fabs(E[0] - en_ana) < 3.*dE[0]);
+    assert(fabs(E[0] - (E[1] + E[2])) < 1e-10); // ETot = EPot + EKinPB
+
+    // --- the maximum number of steps is respected
+    const int64_t nsamples_max = vmc.computeEnergyAdaptive(1e-12, NINIT, 3*NINIT, E, dE);
+    assert(nsamples_max == 3*NINIT);
+
+    // --- adaptive gradient in the target function
+    EnergyGradientTargetFunction gradfun(vmc, NINIT, NINIT, true, 0.);
+    const double gradTargetErr = 0.01;
+    gradfun.setTargetErrors(targetErr, gradTargetErr, 100);
+    std::vector<double> x0{p};
+    nfm::NoisyGradient grad(1);
+    const auto en = gradfun.fgrad(x0, grad);
+    if (myrank == 0 && verbose) {
+        cout << "grad = " << grad.val[0] << " +- " << grad.err[0] << " (ana: " << grad_ana << ")" << endl;
+    }
+    assert(grad.err[0] <= gradTargetErr);
+    assert(grad_ana < 0.);
+    assert(fabs(grad.val[0] - grad_ana) < 3.*grad.err[0]);
+    assert(fabs(en.val - en_ana) < 3.*en.err);
+
+    const auto enf = gradfun.f(x0);
+    assert(enf.err <= targetErr);
+    assert(fabs(enf.val - en_ana) < 3.*enf.err);
+
+    // invalid settings
+    bool caught = false;
+    try { gradfun.setTargetErrors(-1., 0.); }
+    catch (const std::invalid_argument &) { caught = true; }
+    assert(caught);
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
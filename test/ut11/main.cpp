@@ -0,0 +1,77 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "vmc/Philox.hpp"
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    // --- known-answer tests of Philox4x32-10 (Random123 kat_vectors)
+    uint32_t out[4];
+    Philox::block(0, 0, 0, out);
+    assert(out[0] == 0x6627e8d5u && out[1] == 0xe169c58du && out[2] == 0xbc57ac4cu && out[3] == 0x9b00dbd8u);
+
+    Philox::block(0xffffffffffffffffull, 0xffffffffffffffffull, 0xffffffffffffffffull, out);
+    assert(out[0] == 0x408f276du && out[1] == 0x41c83b0eu && out[2] == 0xa20bc7c6u && out[3] == 0x6d5451fdu);
+
+    // counter {243f6a88, 85a308d3, 13198a2e, 03707344}, key {a4093822, 299f31d0}
+    Philox::block(0x299f31d0a4093822ull, 0x0370734413198a2eull, 0x85a308d3243f6a88ull, out);
+    assert(out[0] == 0xd16cfe09u && out[1] == 0x94fdccebu && out[2] == 0x5001e420u && out[3] == 0x24126ea1u);
+
+    // --- 64-bit output is composed of the block words
+    Philox rng(0, 0);
+    assert(rng() == ((static_cast<uint64_t>(0xe169c58du) << 32) | 0x6627e8d5u));
+    assert(rng() == ((static_cast<uint64_t>(0x9b00dbd8u) << 32) | 0xbc57ac4cu));
+    assert(rng.getPosition() == 2);
+
+    // --- reproducibility and skip-ahead
+    const uint64_t seed = 1337;
+    const uint64_t stream = Philox::streamID(3, 1, 42);
+    Philox rng1(seed, stream);
+    vector<uint64_t> vals(11);
+    for (auto &v : vals) { v = rng1(); }
+    for (uint64_t n = 0; n < vals.size(); ++n) {
+        Philox rng2(seed, stream);
+        rng2.discard(n);
+        assert(rng2.getPosition() == n);
+        assert(rng2() == vals[n]);
+    }
+    rng1.seed(seed, stream); // restart
+    assert(rng1() == vals[0]);
+
+    // --- streams are distinct
+    Philox rngA(seed, Philox::streamID(0, 0, 1));
+    Philox rngB(seed, Philox::streamID(1, 0, 0));
+    Philox rngC(seed + 1, Philox::streamID(0, 0, 1));
+    const uint64_t a = rngA();
+    assert(a != rngB());
+    assert(a != rngC());
+
+    // --- rough uniformity check with a std:: distribution
+    std::uniform_real_distribution<double> rd(0., 1.);
+    const int N = 100000;
+    double sum = 0., sum2 = 0.;
+    for (int i = 0; i < N; ++i) {
+        const double x = rd(rngA);
+        assert(x >= 0. && x < 1.);
+        sum += x;
+        sum2 += x*x;
+    }
+    assert(fabs(sum/N - 0.5) < 5.*sqrt(1./12./N));
+    assert(fabs(sum2/N - 1./3.) < 0.01);
+
+    // --- invalid stream indices
+    bool caught = false;
+    try { Philox::streamID(-1); }
+    catch (const std::invalid_argument &) { caught = true; }
+    assert(caught);
+
+    return 0;
+}
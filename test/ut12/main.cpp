@@ -0,0 +1,97 @@
+#include <cmath>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vmc/Checkpoint.hpp"
+#include "vmc/ConfigurationSampler.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const string filename = "ut12_checkpoint" + to_string(myrank) + ".bin";
+
+    const double w = 1.0;
+    const double p = 1.2;
+    const uint64_t seed = 1337;
+
+    // --- VMC to checkpoint (with "tuned" walker and step)
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(p), make_unique<HarmonicOscillator1D1P>(w));
+    vmc.getMCI().setX(0, 0.3);
+    vmc.getMCI().setMRT2Step(0, 1.7);
+
+    // --- sampler to checkpoint, after some steps
+    ConfigurationSampler sampler(vmc.getWF(), seed);
+    sampler.setSeed(seed, Philox::streamID(myrank));
+    sampler.tuneStepSize();
+    sampler.decorrelate(123);
+
+    // --- write checkpoint
+    Checkpoint ckpt;
+    ckpt.addVMC(vmc, seed);
+    ckpt.addSampler(sampler);
+    const vector<double> optx{p}, optextra{0.1, 0.2, 0.3};
+    ckpt.setOptimizerState(17, optx, optextra);
+    ckpt.write(filename);
+    assert(ckpt.getGeneration() == 1);
+
+    // continue the original sampler
+    vector<double> confs_ref;
+    sampler.sample(50, 3, confs_ref);
+
+    // --- read into a fresh object and restore into fresh VMC/sampler
+    Checkpoint ckpt2;
+    ckpt2.read(filename);
+    assert(ckpt2.getGeneration() == 1);
+    assert(ckpt2.getNVMC() == 1);
+    assert(ckpt2.getNSampler() == 1);
+    assert(ckpt2.getOptimizerIteration() == 17);
+    assert(ckpt2.getOptimizerX() == optx);
+    assert(ckpt2.getOptimizerExtra() == optextra);
+
+    VMC vmc2(make_unique<ConstNormGaussian1D1POrbital>(0.5), make_unique<HarmonicOscillator1D1P>(w));
+    ckpt2.restoreVMC(0, vmc2);
+    double vp2;
+    vmc2.getVP(&vp2);
+    assert(vp2 == p);
+    assert(vmc2.getMCI().getX(0) == vmc.getMCI().getX(0));
+    assert(vmc2.getMCI().getMRT2Step(0) == vmc.getMCI().getMRT2Step(0));
+
+    ConfigurationSampler sampler2(vmc2.getWF());
+    ckpt2.restoreSampler(0, sampler2);
+    assert(sampler2.getStepSize() == sampler.getStepSize());
+    vector<double> confs;
+    sampler2.sample(50, 3, confs);
+    assert(confs == confs_ref); // bitwise identical continuation
+
+    // --- mismatching dimensions and invalid files
+    bool caught = false;
+    try { ckpt2.restoreSampler(1, sampler2); }
+    catch (const std::invalid_argument &) { caught = true; }
+    assert(caught);
+
+    {
+        ofstream out(filename, ios::binary | ios::trunc);
+        out << "not a checkpoint";
+    }
+    caught = false;
+    try { ckpt2.read(filename); }
+    catch (const std::runtime_error &) { caught = true; }
+    assert(caught);
+    remove(filename.c_str());
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
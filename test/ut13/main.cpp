@@ -0,0 +1,165 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vmc/ConfigurationSampler.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Trajectory.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+void checkRoundTrip(const std::string &filename, const bool compress)
+{
+    using namespace vmc;
+
+    const int NDIM = 3, NPROTO = 2, NOBS = 4;
+    const int CHUNKSIZE = 7;
+    const int NREC = 100; // not a multiple of CHUNKSIZE
+
+    auto value = [](int irec, int j) { return irec + 0.001*j; };
+
+    {
+        TrajectoryWriter writer(filename, NDIM, NPROTO, NOBS, CHUNKSIZE, compress);
+        double rec[NDIM + NPROTO + NOBS];
+        for (int i = 0; i < NREC; ++i) {
+            for (int j = 0; j < NDIM + NPROTO + NOBS; ++j) { rec[j] = value(i, j); }
+            writer.append(rec, rec + NDIM, rec + NDIM + NPROTO);
+        }
+        assert(writer.getNRecords() == NREC);
+        writer.close();
+    }
+
+    TrajectoryReader reader(filename);
+    assert(reader.getNDim() == NDIM);
+    assert(reader.getNProto() == NPROTO);
+    assert(reader.getNObs() == NOBS);
+    assert(reader.getRecordLength() == NDIM + NPROTO + NOBS);
+    assert(reader.getNRecords() == NREC);
+    assert(reader.getNChunks() == (NREC + CHUNKSIZE - 1)/CHUNKSIZE);
+
+    std::vector<double> buffer;
+    for (int64_t ic = 0; ic < reader.getNChunks(); ++ic) {
+        const double * const chunk = reader.getChunk(ic, buffer);
+        for (int ir = 0; ir < reader.getChunkNRecords(ic); ++ir) {
+            const int64_t irec = reader.getChunkFirstRecord(ic) + ir;
+            for (size_t j = 0; j < reader.getRecordLength(); ++j) {
+                assert(chunk[ir*reader.getRecordLength() + j] == value(static_cast<int>(irec), static_cast<int>(j)));
+            }
+        }
+    }
+
+    double rec[NDIM + NPROTO + NOBS];
+    reader.getRecord(NREC - 1, rec);
+    assert(rec[NDIM] == value(NREC - 1, NDIM));
+}
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const string filename = "ut13_trajectory" + to_string(myrank) + ".bin";
+
+    // --- round trip of raw records
+    checkRoundTrip(filename, false);
+    if (TrajectoryFormat::hasCompression()) {
+        checkRoundTrip(filename, true);
+    }
+    else {
+        bool caught = false;
+        try { TrajectoryWriter writer(filename, 1, 0, 0, 16, true); }
+        catch (const std::invalid_argument &) { caught = true; }
+        assert(caught);
+    }
+
+    // --- record configurations and local energies of a sampler
+    const double w = 1.0, p = 1.2;
+    ConstNormGaussian1D1POrbital wf(p);
+    HarmonicOscillator1D1P H(w);
+    H.bindWaveFunction(&wf);
+    ConfigurationSampler sampler(wf, 1337);
+    sampler.setSeed(1337, Philox::streamID(myrank));
+    sampler.tuneStepSize();
+    sampler.decorrelate(1000);
+    {
+        TrajectoryWriter writer(filename, wf.getTotalNDim(), wf.getNProto(), 4, 64);
+        sampler.record(1000, 2, writer, &H);
+    } // closed by destructor
+
+    TrajectoryReader reader(filename);
+    assert(reader.getNRecords() == 1000);
+    double rec[1 + 1 + 4]; // x, proto, energies
+    double eloc[4];
+    for (int64_t i = 0; i < reader.getNRecords(); i += 97) {
+        reader.getRecord(i, rec);
+        wf.computeAllDerivatives(rec);
+        H.observableFunction(rec, eloc);
+        for (int j = 0; j < 4; ++j) { assert(fabs(eloc[j] - rec[2 + j]) < 1e-12); }
+    }
+
+    // --- record the Markov chain of a VMC (every nskip_eg = 2 steps)
+    VMC vmc(wf, H, 2);
+    vmc.getMCI().setSeed(1337 + myrank);
+    const int64_t NMC = 4000;
+    double E[4], dE[4];
+    {
+        TrajectoryWriter writer(filename, wf.getTotalNDim(), wf.getNProto(), 4, 64);
+        vmc.recordTrajectory(NMC, writer, E, dE);
+        assert(writer.getNRecords() > 0 && writer.getNRecords() <= NMC/2/MPIVMC::Size() + 1);
+    }
+    assert(vmc.getMCI().getNObs() == 1); // the recorder was removed again
+    assert(fabs(E[0] - (w*w + p*p*p*p)/(4.*p*p)) < 4.*dE[0]);
+
+    TrajectoryReader vmcreader(filename);
+    double proto;
+    for (int64_t i = 0; i < vmcreader.getNRecords(); ++i) {
+        vmcreader.getRecord(i, rec);
+        wf.protoFunction(rec, &proto);
+        assert(proto == rec[1]);
+        wf.computeAllDerivatives(rec);
+        H.observableFunction(rec, eloc);
+        for (int j = 0; j < 4; ++j) { assert(fabs(eloc[j] - rec[2 + j]) < 1e-12); }
+    }
+
+    bool thrown = false; // wrong record layout
+    try {
+        TrajectoryWriter writer(filename, wf.getTotalNDim(), wf.getNProto(), 0);
+        vmc.recordTrajectory(NMC, writer, E, dE);
+    }
+    catch (const std::invalid_argument &) { thrown = true; }
+    assert(thrown);
+    assert(vmc.getMCI().getNObs() == 1);
+
+    // --- an incomplete last chunk (e.g. of an interrupted run) is ignored
+    {
+        TrajectoryWriter writer(filename, 1, 0, 0, 4);
+        double x = 0.;
+        for (int i = 0; i < 8; ++i) { writer.append(&x); }
+    }
+    {
+        ofstream out(filename, ios::binary | ios::app);
+        const uint32_t nrec = 4, compressed = 0;
+        const uint64_t nbytes = 4*sizeof(double);
+        out.write(reinterpret_cast<const char *>(&nrec), sizeof(nrec));
+        out.write(reinterpret_cast<const char *>(&compressed), sizeof(compressed));
+        out.write(reinterpret_cast<const char *>(&nbytes), sizeof(nbytes));
+        out.write("abc", 3); // truncated payload
+    }
+    TrajectoryReader reader2(filename);
+    assert(reader2.getNRecords() == 8);
+    assert(reader2.getNChunks() == 2);
+
+    remove(filename.c_str());
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "vmc/ConfigurationSampler.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/ThreadAffinity.hpp"
+#include "vmc/Trajectory.hpp"
+#include "vmc/TrajectoryReplay.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const string filename = "ut14_trajectory" + to_string(myrank) + ".bin";
+
+    const bool verbose = false;
+    const double w = 1.0; // harmonic oscillator strength
+    const double p_ref = 1.1; // sampled parameter
+    const int NREC = 20000;
+
+    // For the p-parametrized gaussian
+    // Psi(x) ~ sqrt(p) e(-0.5*p^2*x^2)
+    // the energy should be E(p) = (w^2 + p^4)/(4 p^2)
+    auto en_ana = [w](double p) { return (w*w + p*p*p*p)/(4.*p*p); };
+
+    // --- record a trajectory with local energies
+    ConstNormGaussian1D1POrbital wf(p_ref);
+    HarmonicOscillator1D1P H(w);
+    H.bindWaveFunction(&wf);
+    ConfigurationSampler sampler(wf);
+    sampler.setSeed(1337, Philox::streamID(myrank)); // fixed seed, such that the noisy asserts will always pass
+    sampler.tuneStepSize();
+    sampler.decorrelate(1000);
+    {
+        TrajectoryWriter writer(filename, wf.getTotalNDim(), wf.getNProto(), 4, 512);
+        sampler.record(NREC, 5, writer, &H);
+    }
+
+    TrajectoryReader reader(filename);
+    TrajectoryReplay replay(reader, 1);
+    replay.setBlockSize(200);
+
+    // --- replaying the sampled wf and H reproduces the stored local energies
+    double E[4], dE[4];
+    const int64_t nused = replay.evaluate(wf, H, E, dE);
+    assert(nused == NREC*MPIVMC::Size());
+    assert(fabs(replay.getESS() - NREC*MPIVMC::Size()) < 1e-6); // all weights are 1
+    double stored[4] = {0., 0., 0., 0.};
+    double rec[6];
+    for (int64_t i = 0; i < reader.getNRecords(); ++i) {
+        reader.getRecord(i, rec);
+        for (int j = 0; j < 4; ++j) { stored[j] += rec[2 + j]; }
+    }
+    MPIVMC::AllreduceSum(stored, 4);
+    for (int j = 0; j < 4; ++j) { assert(fabs(E[j] - stored[j]/(NREC*MPIVMC::Size())) < 1e-10); }
+    assert(fabs(E[0] - en_ana(p_ref)) < 3.*dE[0]);
+
+    // --- the result doesn't depend on the number of threads
+    double E4[4], dE4[4];
+    replay.setNThreads(4);
+    replay.evaluate(wf, H, E4, dE4);
+    for (int j = 0; j < 4; ++j) {
+        assert(fabs(E4[j] - E[j]) < 1e-10);
+        assert(fabs(dE4[j] - dE[j]) < 1e-10);
+    }
+
+    // --- nor on pinning the threads to the NUMA nodes
+    assert(NumaTopology::getNNodes() >= 1);
+    for (int it = 1; it < 4; ++it) { assert(NumaTopology::getWorkerNode(it, 4) >= NumaTopology::getWorkerNode(it - 1, 4)); }
+    replay.setPinThreads(true);
+    replay.evaluate(wf, H, E4, dE4);
+    replay.setPinThreads(false);
+    for (int j = 0; j < 4; ++j) {
+        assert(fabs(E4[j] - E[j]) < 1e-10);
+        assert(fabs(dE4[j] - dE[j]) < 1e-10);
+    }
+
+    // --- reweighting to a different wave function
+    const double p_new = 1.15;
+    ConstNormGaussian1D1POrbital wf_new(p_new);
+    replay.evaluate(wf_new, H, E, dE);
+    if (myrank == 0 && verbose) {
+        cout << "E(" << p_new << ") = " << E[0] << " +- " << dE[0] << " (ana: " << en_ana(p_new) << "), ESS = " << replay.getESS() << endl;
+    }
+    assert(replay.getESS() < NREC*MPIVMC::Size());
+    assert(fabs(E[0] - en_ana(p_new)) < 3.*dE[0]);
+
+    // --- nskip
+    replay.setNSkip(2);
+    assert(replay.evaluate(wf, H, E, dE) == NREC/2*MPIVMC::Size());
+
+    remove(filename.c_str());
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
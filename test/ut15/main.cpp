@@ -0,0 +1,136 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vmc/ConfigurationSampler.hpp"
+#include "vmc/HardwareCounters.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Profiler.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs
+
+
+int64_t getCalls(const vmc::ProfileReport &report, const vmc::ProfilePhase phase)
+{
+    return report.entries[static_cast<int>(phase)].calls;
+}
+
+double getSeconds(const vmc::ProfileReport &report, const vmc::ProfilePhase phase)
+{
+    return report.entries[static_cast<int>(phase)].seconds;
+}
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+
+    // the report has one entry per phase
+    VMC::resetProfile();
+    ProfileReport report = VMC::getProfile();
+    assert(report.entries.size() == static_cast<size_t>(Profiler::NPHASES));
+    for (const auto &e : report.entries) {
+        assert(e.calls == 0);
+        assert(e.seconds == 0.);
+    }
+    assert(report.entries[static_cast<int>(ProfilePhase::Integrate)].name == "integrate");
+
+    // explicit scopes work independent of USE_PROFILING, nested scopes of the same phase count once
+    {
+        Profiler::Scope outer(ProfilePhase::GradientSolve);
+        {
+            Profiler::Scope inner(ProfilePhase::GradientSolve);
+            Profiler::Scope other(ProfilePhase::TargetFunction);
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+    }
+    report = VMC::getProfile();
+    assert(getCalls(report, ProfilePhase::GradientSolve) == 1);
+    assert(getCalls(report, ProfilePhase::TargetFunction) == 1);
+    assert(getSeconds(report, ProfilePhase::GradientSolve) >= 0.005);
+    assert(getSeconds(report, ProfilePhase::GradientSolve) >= getSeconds(report, ProfilePhase::TargetFunction));
+
+    // counters of other threads (also finished ones) are included
+    const int NTHREADS = 4, NCALLS = 1000;
+    vector<thread> threads;
+    for (int it = 0; it < NTHREADS; ++it) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < NCALLS; ++i) { Profiler::Scope scope(ProfilePhase::ObservableFunction); }
+        });
+    }
+    for (auto &t : threads) { t.join(); }
+    report = VMC::getProfile();
+    assert(getCalls(report, ProfilePhase::ObservableFunction) == NTHREADS*NCALLS);
+
+    // the instrumented sampler records its wave function calls only with USE_PROFILING
+    VMC::resetProfile();
+    Gaussian1D1POrbital wf(1.);
+    ConfigurationSampler sampler(wf, 1234);
+    const int NSTEPS = 100;
+    sampler.decorrelate(NSTEPS);
+    report = VMC::getProfile();
+    assert(getCalls(report, ProfilePhase::ObservableFunction) == 0);
+#if USE_PROFILING == 1
+    assert(report.enabled);
+    assert(getCalls(report, ProfilePhase::ProtoFunction) == NSTEPS);
+    assert(getCalls(report, ProfilePhase::AcceptanceFunction) == NSTEPS);
+#else
+    assert(!report.enabled);
+    assert(getCalls(report, ProfilePhase::ProtoFunction) == 0);
+#endif
+
+    // hardware counters, if available on this machine (unavailable ones must degrade gracefully)
+    VMC::resetProfile();
+    if (Profiler::enableHardwareCounters({ProfilePhase::GradientSolve})) {
+        assert(HardwareCounters::isAvailable());
+        {
+            Profiler::Scope scope(ProfilePhase::GradientSolve);
+            double sum = 0.;
+            for (int i = 0; i < 100000; ++i) { sum += 1./(1. + i); }
+            assert(sum > 0.);
+        }
+        { Profiler::Scope scope(ProfilePhase::TargetFunction); } // not counted
+        report = VMC::getProfile();
+        assert(report.hwCounters);
+        const auto &counts = report.entries[static_cast<int>(ProfilePhase::GradientSolve)].hwCounts;
+        assert(counts.size() == static_cast<size_t>(HardwareCounters::NEVENTS));
+        for (int j = 0; j < HardwareCounters::NEVENTS; ++j) {
+            assert((counts[j] >= 0) == HardwareCounters::isAvailable(static_cast<HardwareEvent>(j)));
+        }
+        if (HardwareCounters::isAvailable(HardwareEvent::Instructions)) {
+            assert(counts[static_cast<int>(HardwareEvent::Instructions)] >= 100000);
+        }
+        for (const int64_t c : report.entries[static_cast<int>(ProfilePhase::TargetFunction)].hwCounts) { assert(c <= 0); }
+        Profiler::disableHardwareCounters();
+    }
+    else {
+        assert(!Profiler::isCountingHardware(ProfilePhase::GradientSolve));
+        int64_t counts[HardwareCounters::NEVENTS];
+        assert(!HardwareCounters::read(counts));
+        for (const int64_t c : counts) { assert(c == -1); }
+        report = VMC::getProfile();
+        assert(!report.hwCounters);
+        for (const int64_t c : report.entries[0].hwCounts) { assert(c == -1); }
+    }
+    if (verbose) { cout << "hardware counters: " << (report.hwCounters ? "available" : "unavailable") << endl; }
+
+    // JSON export
+    const string json = report.toJSON();
+    if (verbose) { cout << json << endl; }
+    assert(json.front() == '{' && json.back() == '}');
+    assert(json.find("\"phases\": [") != string::npos);
+    assert(json.find("\"name\": \"protoFunction\"") != string::npos);
+    assert(json.find("\"name\": \"gradientSolve\"") != string::npos);
+    assert((json.find("\"cycles\": ") != string::npos) == report.hwCounters);
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "vmc/MPIVMC.hpp"
+#include "vmc/Profiler.hpp"
+#include "vmc/Tracer.hpp"
+
+
+size_t countOccurrences(const std::string &str, const std::string &sub)
+{
+    size_t n = 0;
+    for (size_t pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + sub.size())) { ++n; }
+    return n;
+}
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const int nranks = MPIVMC::Size();
+    const string filename = "ut16_trace.json";
+
+    const bool verbose = false;
+
+    // nothing is recorded before start() and finalize() without start() does nothing
+    { Profiler::Scope scope(ProfilePhase::TargetFunction); }
+    assert(!Tracer::isActive());
+    assert(Tracer::getNSpans() == 0);
+    Tracer::finalize();
+
+    Tracer::start(filename, false, 3);
+    assert(Tracer::isActive());
+    {
+        Profiler::Scope outer(ProfilePhase::TargetFunction);
+        Profiler::Scope inner(ProfilePhase::TargetFunction); // nested, not recorded
+        Profiler::Scope solve(ProfilePhase::GradientSolve);
+    }
+    { Profiler::Scope scope(ProfilePhase::ProtoFunction); } // per-step phases are not traced by default
+    assert(Tracer::getNSpans() == 2);
+
+    // spans of other threads, with limit of 3 spans per thread
+    thread worker([]() {
+        for (int i = 0; i < 5; ++i) { Profiler::Scope scope(ProfilePhase::Integrate); }
+    });
+    worker.join();
+    assert(Tracer::getNSpans() == 5);
+    assert(Tracer::getNDropped() == 2);
+
+    Tracer::stop();
+    { Profiler::Scope scope(ProfilePhase::MPIReduce); }
+    assert(Tracer::getNSpans() == 5);
+
+    MPIVMC::Finalize(); // writes the trace
+    assert(!Tracer::isActive());
+    assert(Tracer::getNSpans() == 0);
+
+    if (myrank == 0) {
+        ifstream file(filename);
+        assert(file.good());
+        stringstream buffer;
+        buffer << file.rdbuf();
+        const string json = buffer.str();
+        if (verbose) { cout << json << endl; }
+
+        assert(json.find("{\"traceEvents\": [") == 0);
+        assert(json.find("]") != string::npos);
+        assert(json.find("},\n]") == string::npos); // no trailing comma
+        assert(countOccurrences(json, "\"ph\": \"X\"") == static_cast<size_t>(5*nranks));
+        assert(countOccurrences(json, "\"name\": \"targetFunction\"") == static_cast<size_t>(nranks));
+        assert(countOccurrences(json, "\"name\": \"gradientSolve\"") == static_cast<size_t>(nranks));
+        assert(countOccurrences(json, "\"name\": \"integrate\"") == static_cast<size_t>(3*nranks));
+        assert(countOccurrences(json, "\"name\": \"protoFunction\"") == 0);
+        assert(countOccurrences(json, "\"name\": \"mpiReduce\"") == 0);
+        assert(countOccurrences(json, "\"name\": \"process_name\"") == static_cast<size_t>(nranks));
+        remove(filename.c_str());
+    }
+
+    return 0;
+}
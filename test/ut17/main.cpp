@@ -0,0 +1,113 @@
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vmc/EnergyGradientTargetFunction.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/OptimizerTelemetry.hpp"
+#include "vmc/StochasticReconfigurationTargetFunction.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+std::vector<std::string> readLines(const std::string &filename)
+{
+    std::ifstream file(filename);
+    assert(file.good());
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) { lines.push_back(line); }
+    return lines;
+}
+
+bool contains(const std::string &str, const std::string &sub)
+{
+    return str.find(sub) != std::string::npos;
+}
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const string filename = "ut17_telemetry.jsonl";
+
+    const bool verbose = false;
+
+    // JSON of a single record, values not computed are null
+    TelemetryRecord rec;
+    rec.optimizer = "gradient";
+    rec.kind = "f";
+    rec.vp = {1.5, -2.};
+    rec.f = 0.5;
+    rec.nmc = 1000;
+    rec.phases.emplace_back("integrate", 0.25);
+    const string json = rec.toJSON(7);
+    if (verbose) { cout << json << endl; }
+    assert(json.front() == '{' && json.back() == '}');
+    assert(contains(json, "\"iter\": 7, \"optimizer\": \"gradient\", \"kind\": \"f\", \"f\": 0.5, \"df\": null"));
+    assert(contains(json, "\"gradNorm\": null"));
+    assert(contains(json, "\"nmc\": 1000"));
+    assert(contains(json, "\"phases\": {\"integrate\": 0.25}"));
+    assert(contains(json, "\"vp\": [1.5, -2]"));
+
+    // records of the target function evaluations
+    const double w = 1.0, p = 1.2;
+    const int E_NMC = 16*1024;
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(p, true), make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vmc.getMCI().setTrialMove(mci::SRRDType::Gaussian);
+    vmc.getMCI().setSeed(1337 + 42*myrank);
+
+    {
+        OptimizerTelemetry telemetry(filename);
+        std::vector<double> x0(1);
+        vmc.getVP(x0.data());
+        nfm::NoisyGradient grad(1);
+
+        EnergyGradientTargetFunction gradfun(vmc, E_NMC, 2*E_NMC, true);
+        gradfun.f(x0); // no telemetry yet
+        gradfun.setTelemetry(&telemetry);
+        gradfun.f(x0);
+        gradfun.fgrad(x0, grad);
+
+        StochasticReconfigurationTargetFunction srfun(vmc, E_NMC, 2*E_NMC, false);
+        srfun.setTelemetry(&telemetry);
+        srfun.fgrad(x0, grad);
+        assert(telemetry.getNRecords() == 3);
+    }
+
+    if (myrank == 0) {
+        const vector<string> lines = readLines(filename);
+        if (verbose) {
+            for (const auto &line : lines) { cout << line << endl; }
+        }
+        assert(lines.size() == 3);
+        assert(contains(lines[0], "\"iter\": 0, \"optimizer\": \"gradient\", \"kind\": \"f\""));
+        assert(contains(lines[0], "\"gradNorm\": null"));
+        assert(contains(lines[0], "\"nmc\": " + to_string(E_NMC)));
+        assert(contains(lines[0], "\"vp\": [1.2]"));
+        assert(contains(lines[1], "\"iter\": 1, \"optimizer\": \"gradient\", \"kind\": \"fgrad\""));
+        assert(!contains(lines[1], "\"gradNorm\": null"));
+        assert(!contains(lines[1], "\"dgradNorm\": null"));
+        assert(contains(lines[1], "\"nmc\": " + to_string(2*E_NMC)));
+        assert(contains(lines[1], "\"srCondition\": null"));
+        assert(contains(lines[2], "\"iter\": 2, \"optimizer\": \"sr\", \"kind\": \"fgrad\""));
+        assert(contains(lines[2], "\"dgradNorm\": null")); // no gradient errors
+        assert(contains(lines[2], "\"srCondition\": 1,")); // one parameter
+        for (const auto &line : lines) {
+            assert(!contains(line, "\"acceptance\": null"));
+            assert(!contains(line, "\"f\": null"));
+        }
+        remove(filename.c_str());
+    }
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
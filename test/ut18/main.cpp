@@ -0,0 +1,138 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "vmc/EuclideanMetric.hpp"
+#include "vmc/Hamiltonian.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/TwoBodyJastrow.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / pseudopotentials
+
+
+// Harmonic oscillator for npart particles in nspacedim dimensions
+class HarmonicOscillatorNDNP: public vmc::Hamiltonian
+{
+protected:
+    mci::ObservableFunctionInterface * _clone() const final
+    {
+        return new HarmonicOscillatorNDNP(_nspacedim, _npart, _flag_PBKE);
+    }
+
+public:
+    HarmonicOscillatorNDNP(int nspacedim, int npart, bool flag_PBKE = true): vmc::Hamiltonian(nspacedim, npart, flag_PBKE) {}
+
+    double localPotentialEnergy(const double * r) final
+    {
+        double epot = 0.;
+        for (int i = 0; i < _ndim; ++i) { epot += 0.5*r[i]*r[i]; }
+        return epot;
+    }
+};
+
+// SoA walker positions -> position of walker w
+std::vector<double> getWalker(const std::vector<double> &xs, const int ndim, const int nwalkers, const int w)
+{
+    std::vector<double> x(static_cast<size_t>(ndim));
+    for (int i = 0; i < ndim; ++i) { x[i] = xs[i*nwalkers + w]; }
+    return x;
+}
+
+bool isClose(const double a, const double b)
+{
+    return fabs(a - b) <= 1e-10*(1. + fabs(a));
+}
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+
+    const int NSPACEDIM = 3;
+    const int NPART = 5;
+    const int NDIM = NSPACEDIM*NPART;
+    const int NWALKERS = 13;
+
+    mt19937_64 rgen(1337);
+    uniform_real_distribution<double> rd(-1., 1.);
+    vector<double> xs(static_cast<size_t>(NDIM*NWALKERS));
+    for (double &x : xs) { x = rd(rgen); }
+
+    // --- Metric
+    EuclideanMetric em(NSPACEDIM);
+    {
+        const double * r1s = xs.data();
+        const double * r2s = xs.data() + NSPACEDIM*NWALKERS; // particle 0 and 1
+        vector<double> dist(NWALKERS), d1(2*NSPACEDIM*NWALKERS), d2(2*NSPACEDIM*NWALKERS);
+        em.distBatch(NWALKERS, r1s, r2s, dist.data());
+        em.distD1Batch(NWALKERS, r1s, r2s, d1.data());
+        em.distD2Batch(NWALKERS, r1s, r2s, d2.data());
+        for (int w = 0; w < NWALKERS; ++w) {
+            const vector<double> x = getWalker(xs, NDIM, NWALKERS, w);
+            double sd1[2*NSPACEDIM], sd2[2*NSPACEDIM];
+            em.distD1(x.data(), x.data() + NSPACEDIM, sd1);
+            em.distD2(x.data(), x.data() + NSPACEDIM, sd2);
+            assert(isClose(dist[w], em.dist(x.data(), x.data() + NSPACEDIM)));
+            for (int i = 0; i < 2*NSPACEDIM; ++i) {
+                assert(isClose(d1[i*NWALKERS + w], sd1[i]));
+                assert(isClose(d2[i*NWALKERS + w], sd2[i]));
+            }
+        }
+    }
+
+    // --- Wave functions: batched Jastrow and the default (per-walker) implementation
+    PolynomialU2 u2(&em, -0.3, 0.1);
+    TwoBodyJastrow J(NPART, &u2);
+    Gaussian1D1POrbital gauss(1.2); // 1D, uses the defaults
+    HarmonicOscillatorNDNP H(NSPACEDIM, NPART);
+    H.bindWaveFunction(&J);
+
+    vector<double> protovs(NWALKERS), d1s(NDIM*NWALKERS), d2s(NDIM*NWALKERS), vd1s(J.getNVP()*NWALKERS), eloc(4*NWALKERS);
+    J.protoFunctionBatch(NWALKERS, xs.data(), protovs.data());
+    J.computeAllDerivativesBatch(NWALKERS, xs.data(), d1s.data(), d2s.data(), vd1s.data());
+    H.observableFunctionBatch(NWALKERS, xs.data(), d1s.data(), d2s.data(), eloc.data());
+
+    for (int w = 0; w < NWALKERS; ++w) {
+        vector<double> x = getWalker(xs, NDIM, NWALKERS, w);
+        double protov, obs[4];
+        J.protoFunction(x.data(), &protov);
+        J.computeAllDerivatives(x.data());
+        H.observableFunction(x.data(), obs);
+        if (verbose) { cout << "walker " << w << ": proto " << protov << " vs " << protovs[w] << ", E " << obs[0] << " vs " << eloc[w] << endl; }
+
+        assert(isClose(protovs[w], protov));
+        for (int i = 0; i < NDIM; ++i) {
+            assert(isClose(d1s[i*NWALKERS + w], J.getD1DivByWF(i)));
+            assert(isClose(d2s[i*NWALKERS + w], J.getD2DivByWF(i)));
+        }
+        for (int ivp = 0; ivp < J.getNVP(); ++ivp) {
+            assert(isClose(vd1s[ivp*NWALKERS + w], J.getVD1DivByWF(ivp)));
+        }
+        for (int iobs = 0; iobs < 4; ++iobs) {
+            assert(isClose(eloc[iobs*NWALKERS + w], obs[iobs]));
+        }
+    }
+
+    // default implementation, without vd1 output
+    vector<double> gprotovs(NWALKERS), gd1s(NWALKERS), gd2s(NWALKERS);
+    gauss.protoFunctionBatch(NWALKERS, xs.data(), gprotovs.data());
+    gauss.computeAllDerivativesBatch(NWALKERS, xs.data(), gd1s.data(), gd2s.data());
+    for (int w = 0; w < NWALKERS; ++w) {
+        double protov;
+        gauss.protoFunction(&xs[w], &protov);
+        gauss.computeAllDerivatives(&xs[w]);
+        assert(isClose(gprotovs[w], protov));
+        assert(isClose(gd1s[w], gauss.getD1DivByWF(0)));
+        assert(isClose(gd2s[w], gauss.getD2DivByWF(0)));
+    }
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
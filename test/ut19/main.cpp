@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "vmc/EuclideanMetric.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/MultiComponentWaveFunction.hpp"
+#include "vmc/SymmetrizerWaveFunction.hpp"
+#include "vmc/TwoBodyJastrow.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / pseudopotentials
+
+
+struct WFValues
+{
+    std::vector<double> protov, d1, d2, vd1;
+};
+
+// evaluate proto values and derivatives of wf at x
+WFValues evaluate(vmc::WaveFunction &wf, const double * x)
+{
+    WFValues val;
+    val.protov.resize(static_cast<size_t>(wf.getNProto()));
+    wf.protoFunction(x, val.protov.data());
+    wf.computeAllDerivatives(x);
+    for (int i = 0; i < wf.getTotalNDim(); ++i) {
+        val.d1.push_back(wf.getD1DivByWF(i));
+        val.d2.push_back(wf.getD2DivByWF(i));
+    }
+    for (int ivp = 0; ivp < wf.getNVP(); ++ivp) { val.vd1.push_back(wf.getVD1DivByWF(ivp)); }
+    return val;
+}
+
+bool isEqual(const WFValues &a, const WFValues &b)
+{
+    return a.protov == b.protov && a.d1 == b.d1 && a.d2 == b.d2 && a.vd1 == b.vd1;
+}
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+
+    const int NSPACEDIM = 3;
+    const int NPART = 4;
+    const int NDIM = NSPACEDIM*NPART;
+    const int NTHREADS = 4;
+    const int NCONF = 200;
+
+    // composite wave function: Jastrow * symmetrized Jastrow, sharing one metric
+    EuclideanMetric em(NSPACEDIM);
+    PolynomialU2 u2a(&em, -0.3, 0.05);
+    FlatU2 u2b(&em, 0.7);
+    TwoBodyJastrow Ja(NPART, &u2a);
+    TwoBodyJastrow Jb(NPART, &u2b);
+    SymmetrizerWaveFunction Jsym(&Jb);
+    MultiComponentWaveFunction Psi(NSPACEDIM, NPART, true, true, true);
+    Psi.addWaveFunction(&Ja);
+    Psi.addWaveFunction(&Jsym);
+    assert(Psi.getNVP() == 3);
+
+    // random configurations and reference values of the original
+    mt19937_64 rgen(1337);
+    uniform_real_distribution<double> rd(-1., 1.);
+    vector<vector<double>> xs(NCONF, vector<double>(NDIM));
+    vector<WFValues> refs;
+    for (auto &x : xs) {
+        for (double &xi : x) { xi = rd(rgen); }
+        refs.push_back(evaluate(Psi, x.data()));
+    }
+
+    // the clone has the same parameters and values
+    unique_ptr<WaveFunction> clone = Psi.cloneWaveFunction();
+    assert(clone->getNVP() == Psi.getNVP());
+    assert(clone->getNProto() == Psi.getNProto());
+    for (int ic = 0; ic < NCONF; ++ic) {
+        assert(isEqual(evaluate(*clone, xs[ic].data()), refs[ic]));
+    }
+
+    // changing the parameters of the clone does not affect the original and its components
+    const double newvp[3] = {0.1, 0.2, 0.3};
+    clone->setVP(newvp);
+    double vp[3];
+    Psi.getVP(vp);
+    assert(vp[0] == -0.3 && vp[1] == 0.05 && vp[2] == 0.7);
+    u2a.getVP(vp);
+    assert(vp[0] == -0.3 && vp[1] == 0.05);
+    clone->getVP(vp);
+    assert(vp[0] == 0.1 && vp[1] == 0.2 && vp[2] == 0.3);
+    assert(isEqual(evaluate(Psi, xs[0].data()), refs[0]));
+    clone.reset(); // the clone owns its copies, the original must survive
+    assert(isEqual(evaluate(Psi, xs[0].data()), refs[0]));
+
+    // the pseudopotential clone copies the parameters and owns a metric copy
+    unique_ptr<TwoBodyPseudoPotential> u2clone = u2a.clone();
+    u2clone->getVP(vp);
+    assert(vp[0] == -0.3 && vp[1] == 0.05);
+    assert(u2clone->u(xs[0].data(), xs[0].data() + NSPACEDIM) == u2a.u(xs[0].data(), xs[0].data() + NSPACEDIM));
+
+    // one clone per thread, evaluated concurrently
+    vector<unique_ptr<WaveFunction>> clones;
+    for (int it = 0; it < NTHREADS; ++it) { clones.push_back(Psi.cloneWaveFunction()); }
+    vector<int> nfailed(NTHREADS, 0);
+    vector<thread> threads;
+    for (int it = 0; it < NTHREADS; ++it) {
+        threads.emplace_back([&, it]() {
+            for (int rep = 0; rep < 5; ++rep) {
+                for (int ic = it; ic < NCONF; ic += NTHREADS) { // every thread alternates different configurations
+                    if (!isEqual(evaluate(*clones[it], xs[ic].data()), refs[ic])) { ++nfailed[it]; }
+                }
+            }
+        });
+    }
+    for (auto &t : threads) { t.join(); }
+    for (int it = 0; it < NTHREADS; ++it) {
+        if (verbose) { cout << "thread " << it << ": " << nfailed[it] << " mismatches" << endl; }
+        assert(nfailed[it] == 0);
+    }
+
+    // shared parameters: replicas created after shareVP() follow setVP on any of them
+    u2a.shareVP();
+    assert(u2a.isSharingVP() && !u2b.isSharingVP());
+    vector<unique_ptr<WaveFunction>> replicas;
+    for (int it = 0; it < NTHREADS; ++it) { replicas.push_back(Psi.cloneWaveFunction()); }
+    const double sharedvp[3] = {0.1, 0.2, 0.7}; // keep u2b, which is not shared
+    Psi.setVP(sharedvp);
+    for (auto &replica : replicas) {
+        replica->getVP(vp);
+        assert(vp[0] == 0.1 && vp[1] == 0.2 && vp[2] == 0.7);
+    }
+    const WFValues newref = evaluate(Psi, xs[0].data());
+    assert(isEqual(evaluate(*replicas[1], xs[0].data()), newref));
+    clones[0]->getVP(vp); // created before shareVP(), stays private
+    assert(vp[0] == -0.3 && vp[1] == 0.05);
+    const double replicavp[3] = {0.15, 0.25, 0.7};
+    replicas[2]->setVP(replicavp); // publishing from a replica reaches the original
+    Psi.getVP(vp);
+    assert(vp[0] == 0.15 && vp[1] == 0.25);
+
+    // publish while the replicas are evaluated concurrently
+    threads.clear();
+    for (int it = 0; it < NTHREADS; ++it) {
+        threads.emplace_back([&, it]() {
+            for (int ic = 0; ic < NCONF; ++ic) { evaluate(*replicas[it], xs[ic].data()); }
+        });
+    }
+    for (int ip = 0; ip < 100; ++ip) {
+        const double pvp[3] = {-0.3 + 0.001*ip, 0.05, 0.7};
+        Psi.setVP(pvp);
+    }
+    for (auto &t : threads) { t.join(); }
+    const WFValues lastref = evaluate(Psi, xs[0].data());
+    for (auto &replica : replicas) {
+        assert(isEqual(evaluate(*replica, xs[0].data()), lastref));
+    }
+
+    // every evaluation during publishing uses one consistent parameter set, i.e. matches one of the two published
+    const double vpA[3] = {-0.3, 0.05, 0.7}, vpB[3] = {0.2, -0.1, 0.7};
+    vector<WFValues> refsA, refsB;
+    Psi.setVP(vpA);
+    for (auto &x : xs) { refsA.push_back(evaluate(Psi, x.data())); }
+    Psi.setVP(vpB);
+    for (auto &x : xs) { refsB.push_back(evaluate(Psi, x.data())); }
+    threads.clear();
+    std::fill(nfailed.begin(), nfailed.end(), 0);
+    atomic<int> nrunning(NTHREADS);
+    for (int it = 0; it < NTHREADS; ++it) {
+        threads.emplace_back([&, it]() {
+            for (int rep = 0; rep < 20; ++rep) {
+                for (int ic = 0; ic < NCONF; ++ic) {
+                    // protoFunction and computeAllDerivatives are separate evaluations, which may see different sets
+                    const WFValues val = evaluate(*replicas[it], xs[ic].data());
+                    const WFValues &a = refsA[ic], &b = refsB[ic];
+                    if (val.protov != a.protov && val.protov != b.protov) { ++nfailed[it]; }
+                    if (!(val.d1 == a.d1 && val.d2 == a.d2 && val.vd1 == a.vd1) && !(val.d1 == b.d1 && val.d2 == b.d2 && val.vd1 == b.vd1)) { ++nfailed[it]; }
+                }
+            }
+            --nrunning;
+        });
+    }
+    for (int ip = 0; nrunning > 0; ++ip) { Psi.setVP((ip%2 == 0) ? vpA : vpB); } // keep publishing until all are done
+    for (auto &t : threads) { t.join(); }
+    for (int it = 0; it < NTHREADS; ++it) {
+        if (verbose) { cout << "thread " << it << ": " << nfailed[it] << " mixed evaluations" << endl; }
+        assert(nfailed[it] == 0);
+    }
+
+    MPIVMC::Finalize();
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "vmc/EnergyGradientMCObservable.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/ThreadAccumulator.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+// Sample the energies (4) and energy gradient ingredients (2*nvp) on the configurations xs, every thread
+// using own clones and a fixed share of the configurations. Returns the averages and errors of all observables.
+void sample(const vmc::WaveFunction &wf, const HarmonicOscillator1D1P &H, const std::vector<double> &xs,
+            const int nthreads, const int64_t blocksize, std::vector<double> &average, std::vector<double> &error)
+{
+    const int nvp = wf.getNVP();
+    const int nobs = 4 + 2*nvp;
+    const double E[4] = {0.5, 0.25, 0.25, 0.25}; // fixed energy for the gradient observable
+    vmc::ThreadAccumulator acc(nobs, nthreads, blocksize);
+
+    auto worker = [&](const int ithread) {
+        auto twf = wf.cloneWaveFunction();
+        std::unique_ptr<vmc::Hamiltonian> tH(dynamic_cast<vmc::Hamiltonian *>(H.clone().release()));
+        tH->bindWaveFunction(twf.get());
+        vmc::EnergyGradientMCObservable eg(1, nvp);
+        eg.bindDependencies(E, twf.get());
+        std::vector<double> values(static_cast<size_t>(nobs));
+        const size_t nconf = xs.size()/nthreads; // contiguous share of the configurations
+        for (size_t ic = ithread*nconf; ic < (ithread + 1)*nconf; ++ic) {
+            twf->computeAllDerivatives(&xs[ic]);
+            tH->observableFunction(&xs[ic], values.data());
+            eg.observableFunction(&xs[ic], values.data() + 4);
+            acc.accumulate(ithread, values.data());
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int it = 1; it < nthreads; ++it) { threads.emplace_back(worker, it); }
+    worker(0);
+    for (auto &t : threads) { t.join(); }
+
+    assert(acc.getNSamples() == static_cast<int64_t>(xs.size()));
+    average.resize(static_cast<size_t>(nobs));
+    error.resize(static_cast<size_t>(nobs));
+    acc.getResult(average.data(), error.data());
+}
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+
+    const int NCONF = 4000;
+    const int NTHREADS = 4;
+    const int64_t BLOCKSIZE = 100;
+
+    Gaussian1D1POrbital wf(1.2);
+    HarmonicOscillator1D1P H(1.);
+
+    // normally distributed positions
+    mt19937_64 rgen(1337);
+    normal_distribution<double> rd(0., 1.);
+    vector<double> xs(NCONF);
+    for (double &x : xs) { x = rd(rgen); }
+
+    // --- simple and blocking mode
+    for (const int64_t blocksize : {int64_t(0), BLOCKSIZE}) {
+        vector<double> avg1, err1, avg4, err4, avg4b, err4b;
+        sample(wf, H, xs, 1, blocksize, avg1, err1);
+        sample(wf, H, xs, NTHREADS, blocksize, avg4, err4);
+        sample(wf, H, xs, NTHREADS, blocksize, avg4b, err4b);
+
+        for (size_t i = 0; i < avg1.size(); ++i) {
+            if (verbose) { cout << "blocksize " << blocksize << ", obs " << i << ": " << avg4[i] << " +- " << err4[i] << endl; }
+            // bitwise reproducible for a fixed number of threads
+            assert(avg4[i] == avg4b[i]);
+            assert(err4[i] == err4b[i]);
+            // same result as a single thread, up to rounding
+            assert(fabs(avg4[i] - avg1[i]) <= 1e-12*(1. + fabs(avg1[i])));
+            if (blocksize == 0 || NCONF/NTHREADS%blocksize == 0) { // same blocks
+                assert(fabs(err4[i] - err1[i]) <= 1e-10*(1. + fabs(err1[i])));
+            }
+        }
+        assert(err4[0] > 0.); // energy has variance for b != 0.5
+    }
+
+    // --- direct check of the merged values
+    ThreadAccumulator acc(1, 2, 2);
+    const double vals[5] = {1., 2., 3., 4., 10.};
+    for (int i = 0; i < 4; ++i) { acc.accumulate(i%2, vals + i); } // thread 0: 1, 3; thread 1: 2, 4
+    acc.accumulate(0, vals + 4); // incomplete block
+    double avg, err;
+    acc.getResult(&avg, &err);
+    assert(acc.getNSamples() == 5 && acc.getNBlocks() == 2);
+    assert(fabs(avg - 4.) < 1e-14);
+    assert(fabs(err - 0.5) < 1e-14); // blocks 2 and 3
+    acc.reset();
+    assert(acc.getNSamples() == 0 && acc.getNBlocks() == 0);
+
+    // --- weighted samples in blocks by global index (as in TrajectoryReplay), split among threads in chunks
+    vector<double> ws(NCONF);
+    for (size_t ic = 0; ic < xs.size(); ++ic) { ws[ic] = exp(-0.5*xs[ic]*xs[ic]); }
+    double avg1, err1, avg2, err2;
+    ThreadAccumulator acc1(1, 1, BLOCKSIZE), acc2(1, 2, BLOCKSIZE);
+    double W = 0., WX = 0., W2 = 0.;
+    for (int ic = 0; ic < NCONF; ++ic) {
+        acc1.accumulate(0, &xs[ic], ws[ic], ic);
+        acc2.accumulate((ic/150)%2, &xs[ic], ws[ic], ic); // chunks of 150, not aligned with the blocks
+        W += ws[ic];
+        WX += ws[ic]*xs[ic];
+        W2 += ws[ic]*ws[ic];
+    }
+    acc1.getResult(&avg1, &err1);
+    acc2.getResult(&avg2, &err2);
+    assert(acc1.getNBlocks() == NCONF/BLOCKSIZE && acc2.getNBlocks() == NCONF/BLOCKSIZE);
+    assert(fabs(avg1 - WX/W) < 1e-12);
+    assert(fabs(avg2 - avg1) < 1e-12);
+    assert(fabs(err2 - err1) < 1e-12);
+    assert(fabs(acc2.getESS() - W*W/W2) < 1e-8);
+
+    MPIVMC::Finalize();
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "vmc/MPIVMC.hpp"
+#include "vmc/StochasticReconfigurationTargetFunction.hpp"
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+
+    const int NVP = 7;
+    const int NSAMPLES = 2000;
+    const size_t NHEAD = 4 + 2*NVP;
+
+    // SR observables of correlated random samples (same on all ranks): [H (4), O_i, H*O_i, O_i*O_j]
+    mt19937_64 rgen(1337);
+    normal_distribution<double> rd(0., 1.);
+    vector<double> obs(NHEAD + NVP*NVP, 0.), dobs(obs.size(), 0.);
+    for (int is = 0; is < NSAMPLES; ++is) {
+        double O[NVP];
+        double z = rd(rgen);
+        for (int i = 0; i < NVP; ++i) {
+            O[i] = (i + 1.)*rd(rgen) + 0.5*z; // different scales and some correlation
+            z = O[i];
+        }
+        const double E = 1. + 0.3*O[0] - 0.2*O[NVP - 1] + 0.1*rd(rgen);
+        obs[0] += E;
+        for (int i = 0; i < NVP; ++i) {
+            obs[4 + i] += O[i];
+            obs[4 + NVP + i] += E*O[i];
+            for (int j = 0; j < NVP; ++j) { obs[NHEAD + i*NVP + j] += O[i]*O[j]; }
+        }
+    }
+    for (double &v : obs) { v /= NSAMPLES; }
+    for (double &v : dobs) { v = 0.01; }
+
+    // reference: SVD on the full matrix
+    vector<double> ref(NVP), dref(NVP);
+    double condref;
+    computeSRDirection(NVP, obs.data(), dobs.data(), ref.data(), dref.data(), &condref);
+
+    // distributed: this rank only passes its row block
+    const vector<int> offsets = MPIVMC::RowOffsets(NVP);
+    assert(offsets.front() == 0 && offsets.back() == NVP);
+    const vector<double> rows(obs.begin() + NHEAD + offsets[myrank]*NVP, obs.begin() + NHEAD + offsets[myrank + 1]*NVP);
+    vector<double> grad(NVP), dgrad(NVP);
+    double cond;
+    const int niter = computeSRDirectionDistributed(NVP, obs.data(), dobs.data(), rows.data(), grad.data(), dgrad.data(), 1e-12, 0, 0., &cond);
+    assert(niter > 0 && niter <= NVP);
+    if (verbose) { cout << "condition " << cond << " (SVD: " << condref << ") after " << niter << " CG iterations" << endl; }
+    assert(cond > 1. && cond <= condref*(1. + 1e-6)); // estimated from within
+    if (niter == NVP) { assert(fabs(cond - condref) <= 1e-6*condref); }
+    for (int i = 0; i < NVP; ++i) {
+        if (verbose) { cout << "grad[" << i << "] = " << grad[i] << " (SVD: " << ref[i] << "), dgrad " << dgrad[i] << endl; }
+        assert(fabs(grad[i] - ref[i]) <= 1e-6*(1. + fabs(ref[i])));
+        assert(std::isfinite(dgrad[i]) && dgrad[i] >= 0.);
+    }
+
+    // the scattered rows and the gathered vector reproduce the full arrays
+    vector<double> scattered(rows.size()), gathered(obs.size() - NHEAD);
+    MPIVMC::ReduceScatterRows(obs.data() + NHEAD, NVP, NVP, scattered.data());
+    MPIVMC::AllgatherRows(rows.data(), NVP, NVP, gathered.data());
+    for (size_t i = 0; i < rows.size(); ++i) { assert(fabs(scattered[i] - MPIVMC::Size()*rows[i]) <= 1e-12*fabs(scattered[i])); }
+    for (size_t i = 0; i < gathered.size(); ++i) { assert(gathered[i] == obs[NHEAD + i]); }
+
+    // single precision reduction: energies and vectors stay exact, O_i*O_j are rounded to float32
+    vector<double> fobs(obs), fdobs(dobs);
+    MPIVMC::ReduceResults(fobs.data(), fdobs.data(), static_cast<int>(obs.size()), static_cast<int>(NHEAD));
+    const double errfac = 1./sqrt(MPIVMC::Size()); // same results on all ranks
+    for (size_t i = 0; i < obs.size(); ++i) {
+        const double tol = (i < NHEAD) ? 1e-14 : 1e-6;
+        assert(fabs(fobs[i] - obs[i]) <= tol*fabs(obs[i]));
+        assert(fabs(fdobs[i] - errfac*dobs[i]) <= tol*errfac*dobs[i]);
+    }
+    vector<double> frows(rows.size());
+    MPIVMC::ReduceScatterRows(obs.data() + NHEAD, NVP, NVP, frows.data(), true);
+    for (double &v : frows) { v /= MPIVMC::Size(); }
+    // the impact on the SR direction is far below its statistical error
+    vector<double> fgrad(NVP);
+    computeSRDirectionDistributed(NVP, obs.data(), dobs.data(), frows.data(), fgrad.data(), nullptr, 1e-12, 0, 0.);
+    for (int i = 0; i < NVP; ++i) {
+        if (verbose) { cout << "float32 grad[" << i << "] - SVD: " << fgrad[i] - ref[i] << endl; }
+        assert(fabs(fgrad[i] - ref[i]) <= 1e-3*dgrad[i]);
+    }
+
+    // float32 with large means of O_i: the per-rank covariances are reduced instead of O_i*O_j (reduceSRResults),
+    // so the rounding (~1e-7*<O_i>^2) does not cancel catastrophically in S_ij = O_i*O_j - O_i*O_j
+    const double OSHIFT = 100.;
+    vector<double> sobs(obs);
+    for (int i = 0; i < NVP; ++i) {
+        for (int j = 0; j < NVP; ++j) { sobs[NHEAD + i*NVP + j] += OSHIFT*(obs[4 + i] + obs[4 + j]) + OSHIFT*OSHIFT; }
+        sobs[4 + NVP + i] += OSHIFT*obs[0];
+        sobs[4 + i] += OSHIFT;
+    }
+    vector<double> sref(NVP);
+    computeSRDirection(NVP, sobs.data(), dobs.data(), sref.data());
+    for (int i = 0; i < NVP; ++i) { assert(fabs(sref[i] - ref[i]) <= 1e-6*(1. + fabs(ref[i]))); } // shift invariant in double
+    vector<double> sfobs(sobs), sfdobs(dobs);
+    reduceSRResults(NVP, sfobs.data(), sfdobs.data(), true);
+    computeSRDirection(NVP, sfobs.data(), sfdobs.data(), fgrad.data());
+    for (int i = 0; i < NVP; ++i) {
+        if (verbose) { cout << "float32 grad[" << i << "] - SVD (<O_i> + " << OSHIFT << "): " << fgrad[i] - sref[i] << endl; }
+        assert(fabs(fgrad[i] - sref[i]) <= 1e-3*dgrad[i]);
+    }
+    // and the same for the distributed solve
+    vector<double> lobs(sobs), hobs(NHEAD), hdobs(NHEAD), srows;
+    reduceScatterSRResults(NVP, lobs.data(), dobs.data(), hobs.data(), hdobs.data(), srows, true);
+    assert(srows.size() == rows.size());
+    computeSRDirectionDistributed(NVP, hobs.data(), hdobs.data(), srows.data(), fgrad.data(), nullptr, 1e-12, 0, 0.);
+    for (int i = 0; i < NVP; ++i) { assert(fabs(fgrad[i] - sref[i]) <= 1e-3*dgrad[i]); }
+
+    MPIVMC::Finalize();
+    return 0;
+}
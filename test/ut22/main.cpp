@@ -0,0 +1,115 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vmc/MPIVMC.hpp"
+#include "vmc/ParameterScan.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const string filename = "ut22_scan.txt";
+
+    const bool verbose = false;
+
+    // --- serpentine grid
+    const auto grid = ParameterScan::makeGrid({{0., 1., 2.}, {10., 20.}});
+    const vector<vector<double>> expected{{0., 10.}, {0., 20.}, {1., 20.}, {1., 10.}, {2., 10.}, {2., 20.}};
+    assert(grid == expected);
+    const auto grid3 = ParameterScan::makeGrid({{0., 1.}, {0., 1., 2.}, {0., 1.}});
+    assert(grid3.size() == 12);
+    for (size_t ip = 1; ip < grid3.size(); ++ip) { // neighbors differ in one parameter by one step
+        int ndiff = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            const double d = fabs(grid3[ip][i] - grid3[ip - 1][i]);
+            assert(d == 0. || d == 1.);
+            ndiff += (d > 0.) ? 1 : 0;
+        }
+        assert(ndiff == 1);
+    }
+
+    // --- energy curve of the gaussian orbital in the harmonic oscillator, E(p) = (w^2 + p^4)/(4 p^2)
+    const double w = 1.0;
+    const int NTHREADS = 3;
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(1.), make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vector<vector<double>> ps;
+    for (int ip = 0; ip < 10; ++ip) { ps.push_back({0.6 + 0.1*ip}); }
+
+    const int CHAINLENGTH = 4; // chains 0-3, 4-7, 8-9
+    ParameterScan scan(vmc, 64*1024, NTHREADS);
+    scan.setSeed(1337); // fixed seed, such that the noisy asserts will always pass
+    scan.setWarmStart(true, CHAINLENGTH);
+    scan.setOutputFile(filename);
+    scan.setSetupFunction([](VMC &tvmc) { tvmc.getMCI().setTrialMove(mci::SRRDType::Gaussian); });
+    const vector<ScanResult> results = scan.run(ps);
+    assert(scan.getChainLength() == CHAINLENGTH && scan.getWarmFraction() == 0.1);
+
+    assert(results.size() == ps.size());
+    for (size_t ip = 0; ip < ps.size(); ++ip) {
+        const ScanResult &res = results[ip];
+        const double p = ps[ip][0];
+        const double en_ana = (w*w + p*p*p*p)/(4.*p*p);
+        if (myrank == 0 && verbose) {
+            cout << "p " << p << ": E = " << res.E[0] << " +- " << res.dE[0] << " (ana " << en_ana << "), rank " << res.rank
+                 << ", thread " << res.thread << (res.warm ? ", warm" : "") << endl;
+        }
+        assert(res.vp == ps[ip]);
+        assert(res.rank >= 0 && res.rank < MPIVMC::Size());
+        assert(res.thread >= 0 && res.thread < NTHREADS);
+        assert(res.warm == (ip%CHAINLENGTH != 0)); // every chain starts cold
+        assert(!res.warm || (results[ip - 1].rank == res.rank && results[ip - 1].thread == res.thread));
+        assert(res.dE[0] > 0.);
+        assert(fabs(res.E[0] - en_ana) < 3.*res.dE[0]);
+    }
+
+    // the results don't depend on the scheduling (here: a single thread runs all chains of the rank)
+    ParameterScan scan1(vmc, 64*1024, 1);
+    scan1.setSeed(1337);
+    scan1.setWarmStart(true, CHAINLENGTH);
+    scan1.setSetupFunction([](VMC &tvmc) { tvmc.getMCI().setTrialMove(mci::SRRDType::Gaussian); });
+    const vector<ScanResult> results1 = scan1.run(ps);
+    for (size_t ip = 0; ip < ps.size(); ++ip) {
+        assert(results1[ip].thread == 0 && results1[ip].warm == results[ip].warm);
+        for (int i = 0; i < 4; ++i) {
+            assert(results1[ip].E[i] == results[ip].E[i]);
+            assert(results1[ip].dE[i] == results[ip].dE[i]);
+        }
+    }
+
+    // invalid warm start settings
+    bool thrown = false;
+    try { scan1.setWarmStart(true, 0); }
+    catch (const invalid_argument &) { thrown = true; }
+    assert(thrown);
+
+    // every point has been streamed to the file of its rank
+    {
+        const string rankfile = (MPIVMC::Size() > 1) ? filename + "." + to_string(myrank) : filename;
+        ifstream file(rankfile);
+        assert(file.good());
+        int nlines = 0;
+        string line;
+        while (getline(file, line)) { ++nlines; }
+        int nlocal = 0;
+        for (const auto &res : results) { nlocal += (res.rank == myrank) ? 1 : 0; }
+        assert(nlines == nlocal);
+        file.close();
+        remove(rankfile.c_str());
+    }
+
+    MPIVMC::Finalize();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "vmc/CorrelatedEvaluation.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+
+    // For the p-parametrized gaussian in the harmonic oscillator, E(p) = (w^2 + p^4)/(4 p^2)
+    const double w = 1.0;
+    const auto en_ana = [w](const double p) { return (w*w + p*p*p*p)/(4.*p*p); };
+
+    // guide VMC at p = 1.1
+    const double pg = 1.1;
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(pg), make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vmc.getMCI().setTrialMove(mci::SRRDType::Gaussian);
+    vmc.getMCI().setSeed(1337 + 42*myrank);
+
+    // candidates at other parameters and the guide itself
+    const double ps[3] = {0.9, 1.2, pg};
+    HarmonicOscillator1D1P H(w);
+    CorrelatedEvaluation ce(vmc, 200);
+    for (const double p : ps) { ce.addCandidate(ConstNormGaussian1D1POrbital(p), H); }
+    assert(ce.getNCandidates() == 3);
+
+    const int64_t NMC = 256*1024; // total over all ranks
+    const int NSKIP = 2; // nskip_eg of the guide VMC
+    double guideE[4], guideDE[4];
+    ce.evaluate(NMC, guideE, guideDE);
+    const int64_t nsamples = ce.getNSamples();
+    assert(nsamples == MPIVMC::Size()*((NMC/MPIVMC::Size())/NSKIP)); // every sample of the chain, including rejected steps
+
+    double E[3][4], dE[3][4];
+    for (int k = 0; k < 3; ++k) {
+        ce.getEnergy(k, E[k], dE[k]);
+        if (myrank == 0 && verbose) {
+            cout << "p " << ps[k] << ": E = " << E[k][0] << " +- " << dE[k][0] << " (ana " << en_ana(ps[k]) << "), ESS " << ce.getESS(k) << endl;
+        }
+        assert(fabs(E[k][0] - en_ana(ps[k])) < 4.*dE[k][0]);
+        assert(ce.getESS(k) <= nsamples + 1e-6*nsamples);
+    }
+    assert(fabs(ce.getESS(2) - nsamples) < 1e-6*nsamples); // guide clone: w = 1
+    assert(fabs(guideE[0] - en_ana(pg)) < 4.*guideDE[0]);
+
+    // correlated difference of neighboring parameters, more precise than from independent estimates
+    double diff, ddiff;
+    ce.getEnergyDifference(1, 2, diff, ddiff);
+    const double diff_ana = en_ana(ps[1]) - en_ana(ps[2]);
+    if (myrank == 0 && verbose) { cout << "E(1.2) - E(1.1) = " << diff << " +- " << ddiff << " (ana " << diff_ana << ")" << endl; }
+    assert(fabs(diff - diff_ana) < 4.*ddiff);
+    assert(ddiff < sqrt(dE[1][0]*dE[1][0] + dE[2][0]*dE[2][0]));
+    ce.getEnergyDifference(1, 0, diff, ddiff); // parameters on both sides of the guide are anti-correlated
+    assert(fabs(diff - (en_ana(ps[1]) - en_ana(ps[0]))) < 4.*ddiff);
+    ce.getEnergyDifference(2, 2, diff, ddiff);
+    assert(diff == 0. && ddiff == 0.);
+
+    MPIVMC::Finalize();
+    return 0;
+}
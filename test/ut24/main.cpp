@@ -0,0 +1,52 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "vmc/MPIVMC.hpp"
+#include "vmc/NMSimplexMinimization.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+    const double w = 1.0; // harmonic oscillator strength
+
+    // For the p-parametrized gaussian the energy is E(p) = (w^2 + p^4)/(4 p^2),
+    // with the minimum E = 0.5*w at p = sqrt(w) (zero variance)
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(1.4), make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vmc.getMCI().setTrialMove(mci::SRRDType::Gaussian);
+    vmc.getMCI().setSeed(1337 + 42*myrank); // fixed seed, such that the noisy asserts will always pass
+    vmc.getMCI().setNfindMRT2Iterations(10);
+    vmc.getMCI().setNdecorrelationSteps(1000);
+
+    // --- batched Nelder-Mead (reached also without MPI, the batches are then evaluated one after another)
+    const double rend = 0.005;
+    const size_t maxIter = 100;
+    NMSimplexMinimization nms(20000, 1.0, 0.1, 0., 0.2, rend, maxIter);
+    nms.setNGroups(2);
+    assert(nms.getNGroups() == 2);
+    vmc.skipNextEquilibration(); // must be used up by the first (rank-group) evaluation
+    nms.minimizeEnergy(vmc);
+    assert(!vmc.willSkipNextEquilibration());
+
+    double p;
+    vmc.getVP(&p);
+    double E[4], dE[4];
+    vmc.computeEnergy(20000, E, dE);
+    if (myrank == 0 && verbose) { cout << "p = " << p << ", E = " << E[0] << " +- " << dE[0] << endl; }
+    assert(fabs(fabs(p) - sqrt(w)) < 0.05); // the sign of p doesn't matter
+    assert(fabs(E[0] - 0.5*w) < 0.002);
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
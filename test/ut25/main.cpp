@@ -0,0 +1,83 @@
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "vmc/IncrementalEstimate.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+
+    // --- direct check of the combination rule
+    IncrementalEstimate inc(2);
+    const double avg1[2] = {1., 2.}, err1[2] = {0.1, 0.2};
+    const double avg2[2] = {4., -1.}, err2[2] = {0.3, 0.1};
+    inc.add(100, avg1, err1);
+    inc.add(200, avg2, err2);
+    assert(inc.getNSamples() == 300);
+    assert(fabs(inc.getAverage(0) - 3.) < 1e-14);
+    assert(fabs(inc.getAverage(1) - 0.) < 1e-14);
+    assert(fabs(inc.getError(0) - sqrt(100.*100.*0.01 + 200.*200.*0.09)/300.) < 1e-14);
+    inc.reset();
+    assert(inc.getNSamples() == 0 && inc.getAverage(0) == 0.);
+
+    // --- budgeted integration against a plain integration
+    const double w = 1.0;
+    const double p = 1.2; // finite variance
+    const double en_ana = (w*w + p*p*p*p)/(4.*p*p);
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(p), make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vmc.getMCI().setTrialMove(mci::SRRDType::Gaussian);
+    vmc.getMCI().setSeed(1337 + 42*myrank); // fixed seed, such that the noisy asserts will always pass
+
+    double Eref[4], dEref[4];
+    vmc.computeEnergy(100000, Eref, dEref);
+
+    using clock = chrono::steady_clock;
+    const int64_t NCHUNK = 2000;
+    double E[4], dE[4];
+    double prevErr = 0.;
+    for (const double budget : {0.1, 0.4}) {
+        const auto t0 = clock::now();
+        const int64_t nsamples = vmc.computeEnergyTimed(budget, NCHUNK, E, dE);
+        const double elapsed = chrono::duration<double>(clock::now() - t0).count();
+        if (myrank == 0 && verbose) {
+            cout << "budget " << budget << ": E = " << E[0] << " +- " << dE[0] << " with " << nsamples << " steps in "
+                 << elapsed << " s (ref " << Eref[0] << " +- " << dEref[0] << ", ana " << en_ana << ")" << endl;
+        }
+        assert(nsamples >= NCHUNK*MPIVMC::Size());
+        assert(nsamples%NCHUNK == 0); // whole chunks
+        assert(elapsed >= budget); // no target error, so the whole budget is used
+        assert(elapsed < budget + 0.5); // the budget is checked after every (short) chunk
+        assert(fabs(E[0] - Eref[0]) < 4.*sqrt(dE[0]*dE[0] + dEref[0]*dEref[0]));
+        assert(fabs(E[0] - en_ana) < 4.*dE[0]);
+        assert(fabs(E[0] - (E[1] + E[2])) < 1e-10); // ETot = EPot + EKinPB
+        if (prevErr > 0.) { assert(dE[0] < prevErr); } // the estimate converges with the budget
+        prevErr = dE[0];
+    }
+
+    // --- early stop at the target error, long before the end of the budget
+    const double targetErr = 2.*dEref[0];
+    const auto t0 = clock::now();
+    vmc.computeEnergyTimed(60., NCHUNK, E, dE, targetErr, 0.01);
+    const double elapsed = chrono::duration<double>(clock::now() - t0).count();
+    if (myrank == 0 && verbose) { cout << "target " << targetErr << ": E = " << E[0] << " +- " << dE[0] << " in " << elapsed << " s" << endl; }
+    assert(dE[0] <= targetErr);
+    assert(elapsed < 30.);
+    assert(fabs(E[0] - en_ana) < 4.*dE[0]);
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
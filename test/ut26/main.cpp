@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vmc/Checkpoint.hpp"
+#include "vmc/EnergyGradientTargetFunction.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/NMSimplexMinimization.hpp"
+#include "vmc/VMC.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+std::unique_ptr<vmc::VMC> makeVMC(const double p, const double w, const int myrank)
+{
+    auto vmc = std::make_unique<vmc::VMC>(std::make_unique<ConstNormGaussian1D1POrbital>(p), std::make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vmc->getMCI().setTrialMove(mci::SRRDType::Gaussian);
+    vmc->getMCI().setSeed(1337 + 42*myrank); // fixed seed, such that the noisy asserts will always pass
+    vmc->getMCI().setNfindMRT2Iterations(10);
+    vmc->getMCI().setNdecorrelationSteps(1000);
+    return vmc;
+}
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const string filename = "ut26_checkpoint.bin";
+    const string rankfile = vmc::OptimizerCheckpoint(filename, 1).getFilename(); // rank-suffixed with MPI
+    remove(rankfile.c_str());
+
+    const bool verbose = false;
+    const double w = 1.0; // harmonic oscillator strength, the optimal p is sqrt(w)
+    const uint64_t seed = 4242;
+
+    // --- batched NM simplex, stopped after 3 iterations (like a preempted job)
+    const int NSTOP = 3;
+    vector<double> xstop;
+    {
+        auto vmc = makeVMC(1.4, w, myrank);
+        OptimizerCheckpoint ckpt(filename, 1, seed);
+        NMSimplexMinimization nms(20000, 1.0, 0.1, 0., 0.2, 0.005, NSTOP);
+        nms.setNGroups(2);
+        nms.setCheckpoint(&ckpt);
+        nms.minimizeEnergy(*vmc);
+        assert(ckpt.getIteration() == NSTOP);
+        xstop = ckpt.getCheckpoint().getOptimizerX();
+        vector<double> vp(1);
+        vmc->getVP(vp.data());
+        assert(xstop == vp); // the batched mode sets the best vertex at the end
+    }
+
+    // --- resume with a fresh VMC: the stopped state is restored exactly and the optimization continues
+    {
+        auto vmc = makeVMC(0.7, w, myrank);
+        OptimizerCheckpoint ckpt(filename, 1, seed);
+        assert(ckpt.resume(*vmc));
+        assert(vmc->willSkipNextEquilibration()); // the walkers were restored
+        assert(ckpt.getIteration() == NSTOP);
+        assert(ckpt.getCheckpoint().getOptimizerX() == xstop);
+        const vector<double> &extra = ckpt.getCheckpoint().getOptimizerExtra();
+        assert(extra.size() == 4); // 2 vertices and 2 costs
+        assert(extra[0] == xstop[0] || extra[1] == xstop[0]); // the best vertex is part of the simplex
+
+        auto vmc2 = makeVMC(0.7, w, myrank);
+        NMSimplexMinimization nms(20000, 1.0, 0.1, 0., 0.2, 0.005, 100);
+        nms.setNGroups(2);
+        nms.setCheckpoint(&ckpt);
+        nms.minimizeEnergy(*vmc2);
+        assert(!vmc2->willSkipNextEquilibration()); // used up also by the rank-group evaluations
+        assert(ckpt.getIteration() > NSTOP); // continued counting
+        double p;
+        vmc2->getVP(&p);
+        if (myrank == 0 && verbose) { cout << "NMS stopped at p = " << xstop[0] << ", resumed to p = " << p << " after " << ckpt.getIteration() << " iterations" << endl; }
+        assert(fabs(fabs(p) - sqrt(w)) < 0.05);
+    }
+    remove(rankfile.c_str());
+
+    // --- gradient target function: every gradient evaluation is an iteration (as called by NoisyFunMin optimizers)
+    {
+        auto vmc = makeVMC(1.2, w, myrank);
+        OptimizerCheckpoint ckpt(filename, 2, seed);
+        EnergyGradientTargetFunction gradfun(*vmc, 10000, 10000, false);
+        gradfun.setCheckpoint(&ckpt);
+        nfm::NoisyGradient grad(1);
+        for (const double p : {1.2, 1.1, 1.05}) { // stop after the third "iteration", the last checkpoint is the second
+            gradfun.fgrad(vector<double>{p}, grad);
+        }
+        assert(ckpt.getIteration() == 3);
+        assert(ckpt.getCheckpoint().getOptimizerIteration() == 2);
+
+        auto vmc2 = makeVMC(0.5, w, myrank);
+        OptimizerCheckpoint ckpt2(filename, 2, seed);
+        assert(ckpt2.resume(*vmc2));
+        assert(ckpt2.getIteration() == 2);
+        assert(ckpt2.getCheckpoint().getOptimizerX() == vector<double>{1.1});
+        double p;
+        vmc2->getVP(&p);
+        assert(p == 1.1); // minimizeEnergy<> continues the optimizer from here
+    }
+    remove(rankfile.c_str());
+
+    // no file, nothing to resume
+    {
+        auto vmc = makeVMC(1.2, w, myrank);
+        OptimizerCheckpoint ckpt(filename, 1, seed);
+        assert(!ckpt.resume(*vmc));
+        assert(ckpt.getIteration() == 0);
+    }
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
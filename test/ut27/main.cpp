@@ -0,0 +1,146 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "vmc/EnergyGradientTargetFunction.hpp"
+#include "vmc/MPIVMC.hpp"
+#include "vmc/StochasticReconfigurationTargetFunction.hpp"
+#include "vmc/VMC.hpp"
+#include "mci/ObservableFunctionInterface.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+// Counts its evaluations in a counter shared by all clones
+class CountingObservable: public mci::ObservableFunctionInterface
+{
+protected:
+    int64_t * const _count;
+
+    mci::ObservableFunctionInterface * _clone() const final { return new CountingObservable(_count); }
+
+public:
+    explicit CountingObservable(int64_t * count): mci::ObservableFunctionInterface(1, 1, false), _count(count) {}
+    void observableFunction(const double * /*in*/, double * out) final
+    {
+        ++(*_count);
+        out[0] = 1.;
+    }
+};
+
+
+std::unique_ptr<vmc::VMC> makeVMC(const double p, const double w, const int myrank)
+{
+    auto vmc = std::make_unique<vmc::VMC>(std::make_unique<ConstNormGaussian1D1POrbital>(p), std::make_unique<HarmonicOscillator1D1P>(w), 2, 8);
+    vmc->getMCI().setTrialMove(mci::SRRDType::Gaussian);
+    vmc->getMCI().setSeed(1337 + 42*myrank); // fixed seed, such that the noisy asserts will always pass
+    vmc->getMCI().setNfindMRT2Iterations(10);
+    vmc->getMCI().setNdecorrelationSteps(1000);
+    return vmc;
+}
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+    const bool serial = (MPIVMC::Size() == 1); // no reduction to overlap
+
+    const bool verbose = false;
+    const double w = 1.0; // harmonic oscillator strength
+    const int64_t NMC = 20000;
+    const int64_t NCHUNK = 200;
+
+    // For the p-parametrized gaussian
+    // Psi(x) ~ sqrt(p) e(-0.5*p^2*x^2)
+    // the energy should be E(p) = (w^2 + p^4)/(4 p^2) and the target function's gradient (descent direction)
+    // -d/dp E(p) = (w^2 - p^4)/(2 p^3)
+    auto en_ana = [w](double p) { return (w*w + p*p*p*p)/(4.*p*p); };
+    auto grad_ana = [w](double p) { return (w*w - p*p*p*p)/(2.*p*p*p); };
+    const vector<double> ps{1.2, 1.1, 0.9, 0.8}; // a sequence of parameter updates
+
+    // --- energy gradient: with and without overlap sampling on the same chain
+    auto vmc_ref = makeVMC(ps[0], w, myrank);
+    auto vmc_ovl = makeVMC(ps[0], w, myrank);
+    EnergyGradientTargetFunction gf_ref(*vmc_ref, NMC, NMC, true);
+    EnergyGradientTargetFunction gf_ovl(*vmc_ovl, NMC, NMC, true);
+    gf_ovl.setOverlapSampling(NCHUNK);
+    assert(gf_ovl.getOverlapSampling() == NCHUNK);
+    assert(gf_ovl.getOverlapWarmFraction() == 0.1);
+    const int nobs0 = vmc_ovl->getMCI().getNObs();
+
+    nfm::NoisyGradient g_ref(1), g_ovl(1);
+    for (const double p : ps) {
+        const nfm::NoisyValue f_ref = gf_ref.fgrad(vector<double>{p}, g_ref);
+        const nfm::NoisyValue f_ovl = gf_ovl.fgrad(vector<double>{p}, g_ovl);
+        assert(vmc_ovl->getMCI().getNObs() == nobs0); // the gradient observable was removed (npop path)
+        if (myrank == 0 && verbose) {
+            cout << "p = " << p << ": grad " << g_ref.val[0] << " +- " << g_ref.err[0] << " (ref), " << g_ovl.val[0] << " +- " << g_ovl.err[0]
+                 << " (overlapped, " << gf_ovl.getLastOverlapSteps() << " steps), ana " << grad_ana(p) << endl;
+        }
+        if (serial) { // no overlap steps, so the same chain and results
+            assert(gf_ovl.getLastOverlapSteps() == 0);
+            assert(f_ovl.val == f_ref.val && f_ovl.err == f_ref.err);
+            assert(g_ovl.val[0] == g_ref.val[0] && g_ovl.err[0] == g_ref.err[0]);
+        }
+        else { // statistically compatible
+            assert(gf_ovl.getLastOverlapSteps()%NCHUNK == 0);
+            assert(fabs(f_ovl.val - f_ref.val) < 4.*sqrt(f_ovl.err*f_ovl.err + f_ref.err*f_ref.err));
+            assert(fabs(g_ovl.val[0] - g_ref.val[0]) < 4.*sqrt(g_ovl.err[0]*g_ovl.err[0] + g_ref.err[0]*g_ref.err[0]));
+        }
+        // and both unbiased
+        assert(fabs(f_ovl.val - en_ana(p)) < 4.*f_ovl.err);
+        assert(fabs(g_ovl.val[0] - grad_ana(p)) < 4.*g_ovl.err[0]);
+    }
+
+    // --- the same for the energies of the SR target function (overlapped evaluations between gradients)
+    auto vmc_sr = makeVMC(ps[0], w, myrank);
+    StochasticReconfigurationTargetFunction sr(*vmc_sr, NMC, NMC, true);
+    sr.setOverlapSampling(NCHUNK, 0.5);
+    for (const double p : ps) {
+        const nfm::NoisyValue f = sr.f(vector<double>{p});
+        assert(vmc_sr->getMCI().getNObs() == nobs0);
+        assert(fabs(f.val - en_ana(p)) < 4.*f.err);
+    }
+
+    // --- overlap sampling uses the same number of samples per rank (Nmc is split among the ranks in both cases)
+    // With the flat wave function (p = 0) every step is accepted, so the counter is evaluated on every sampled step.
+    int64_t counts[2];
+    for (int iovl = 0; iovl < 2; ++iovl) {
+        auto vmc_cnt = makeVMC(0., w, myrank);
+        vmc_cnt->getMCI().setIRange(-1., 1.);
+        counts[iovl] = 0;
+        vmc_cnt->getMCI().addObservable(std::make_unique<CountingObservable>(&counts[iovl]), 0, 1);
+        EnergyGradientTargetFunction gf_cnt(*vmc_cnt, NMC, NMC, false);
+        gf_cnt.setOverlapSampling(iovl*NCHUNK);
+        gf_cnt.f(vector<double>{0.});
+        counts[iovl] -= gf_cnt.getLastOverlapSteps(); // the counter also saw the overlap steps
+    }
+    assert(counts[1] == counts[0]);
+    assert(llabs(counts[0] - NMC/MPIVMC::Size()) <= 1); // allow for a separate evaluation on the initial walker
+
+    // --- invalid settings
+    bool thrown = false;
+    try { sr.setOverlapSampling(NCHUNK, 0.); }
+    catch (const invalid_argument &) { thrown = true; }
+    assert(thrown);
+    thrown = false; // the distributed SR solve doesn't support overlap sampling
+    try { sr.setDistributedSolve(true); }
+    catch (const invalid_argument &) { thrown = true; }
+    assert(thrown && !sr.isDistributedSolve());
+    sr.setOverlapSampling(0);
+    sr.setDistributedSolve(true);
+    thrown = false;
+    try { sr.setOverlapSampling(NCHUNK); }
+    catch (const invalid_argument &) { thrown = true; }
+    assert(thrown && sr.getOverlapSampling() == 0);
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
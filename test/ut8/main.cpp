@@ -0,0 +1,71 @@
+#include <cmath>
+#include <cassert>
+#include <iostream>
+#include <memory>
+
+#include "vmc/MPIVMC.hpp"
+#include "vmc/VMC.hpp"
+#include "vmc/LinearMethodTargetFunction.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+    const double w = 1.0; // harmonic oscillator strength
+    const double p_exact = sqrt(w); // the exact ground state parameter
+
+    // For the p-parametrized gaussian
+    // Psi(x) ~ sqrt(p) e(-0.5*p^2*x^2)
+    // a single Linear Method step should bring p very close to sqrt(w),
+    // while at p = sqrt(w) the step must vanish (zero-variance principle).
+    const std::vector<double> ps{p_exact, 1.2};
+
+    for (const double p : ps) {
+        // --- Create the VMC object
+        const int nskip = 2; // compute energy/grad only every second MC step
+        const int blocksize = 8; // we use fixed block size for performance and memory
+        VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(p, true, true, true), make_unique<HarmonicOscillator1D1P>(w), nskip, blocksize);
+        vmc.getMCI().setTrialMove(mci::SRRDType::Gaussian);
+        vmc.getMCI().setSeed(1337 + 42*myrank); // we need to use a fixed seed such to make sure that the noisy asserts will always pass
+
+        const int E_NMC = 128*1024; // MC samplings to use for computing the energy (kept low to allow running inside valgrind)
+
+        LinearMethodTargetFunction lmfun(vmc, E_NMC, E_NMC, true, 0.); // create linear method target function
+        std::vector<double> x0(1);
+        vmc.getVP(x0.data()); // set x0 from wf VP
+        nfm::NoisyGradient dp(1);
+        const auto en = lmfun.fgrad(x0, dp);
+
+        const double en_ana = (w*w + p*p*p*p)/(4.*p*p);
+        const double p_new = p + dp.val[0];
+
+        if (myrank == 0 && verbose) {
+            cout << endl;
+            cout << "p                = " << p << endl;
+            cout << "Energy (VMC)     = " << en.val << " +- " << en.err << endl;
+            cout << "Energy (ANA)     = " << en_ana << endl;
+            cout << "LM step          = " << dp.val[0] << " +- " << dp.err[0] << endl;
+            cout << "New p            = " << p_new << " (exact: " << p_exact << ")" << endl;
+            cout << endl;
+        }
+
+        assert(fabs(en.val - en_ana) < 3.*en.err + 1e-12);
+        if (p == p_exact) {
+            assert(fabs(dp.val[0]) < 1e-6);
+        }
+        else {
+            assert(fabs(p_new - p_exact) < 0.05);
+        }
+    }
+
+    MPIVMC::Finalize();
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <cmath>
+#include <cassert>
+#include <iostream>
+#include <memory>
+
+#include "vmc/MPIVMC.hpp"
+#include "vmc/VMC.hpp"
+#include "vmc/CorrelatedSampling.hpp"
+
+#include "../common/TestVMCFunctions.hpp" // used WFs / Hamiltonian
+
+
+int main()
+{
+    using namespace std;
+    using namespace vmc;
+
+    const int myrank = MPIVMC::Init(); // make this usable with a MPI-compiled library
+
+    const bool verbose = false;
+    const double w = 1.0; // harmonic oscillator strength
+    const double p_ref = 1.1; // reference parameter where configurations are sampled
+    const int64_t NCONF = 20000; // stored configurations (per rank)
+    const int NSKIP = 5;
+
+    // For the p-parametrized gaussian
+    // Psi(x) ~ sqrt(p) e(-0.5*p^2*x^2)
+    // the energy should be E(p) = (w^2 + p^4)/(4 p^2)
+    auto en_ana = [w](double p) { return (w*w + p*p*p*p)/(4.*p*p); };
+    // and the reweighting factors w(x) = p/p_ref e(-(p^2 - p_ref^2)*x^2) have <w> = 1 and
+    // <w^2> = p^2/(p_ref*sqrt(2 p^2 - p_ref^2)) (finite for 2 p^2 > p_ref^2), i.e. ESS/N -> 1/<w^2>
+    auto essratio_ana = [p_ref](double p) { return p_ref*sqrt(2.*p*p - p_ref*p_ref)/(p*p); };
+
+    VMC vmc(make_unique<ConstNormGaussian1D1POrbital>(p_ref), make_unique<HarmonicOscillator1D1P>(w));
+    CorrelatedSampling cs(vmc, NCONF, NSKIP, 1337); // fixed seed, such that the noisy asserts will always pass
+    cs.setMinESSRatio(0.5);
+
+    double E[4], dE[4];
+
+    // at the reference, all weights are 1
+    cs.computeEnergy(&p_ref, E, dE);
+    assert(cs.getNSample() == 1);
+    assert(fabs(cs.getESS() - NCONF*MPIVMC::Size()) < 1e-6);
+    assert(fabs(E[0] - en_ana(p_ref)) < 4.*dE[0]);
+
+    // nearby parameters by reweighting
+    const std::vector<double> ps{1.05, 1.15};
+    std::vector<double> dEs;
+    for (const double p : ps) {
+        cs.computeEnergy(&p, E, dE);
+        if (myrank == 0 && verbose) {
+            cout << "p = " << p << ", E = " << E[0] << " +- " << dE[0] << " (ana: " << en_ana(p) << "), ESS = " << cs.getESS() << endl;
+        }
+        assert(cs.getNSample() == 1); // no resampling necessary
+        assert(cs.getESS() < NCONF*MPIVMC::Size());
+        assert(fabs(cs.getESS()/(NCONF*MPIVMC::Size()) - essratio_ana(p)) < 0.01);
+        assert(fabs(E[0] - en_ana(p)) < 4.*dE[0] + 1e-12);
+        assert(fabs(E[0] - (E[1] + E[2])) < 1e-10); // ETot = EPot + EKinPB
+        dEs.push_back(dE[0]);
+    }
+
+    // correlated difference
+    double diff, ddiff;
+    cs.computeEnergyDifference(&ps[1], &ps[0], diff, ddiff);
+    const double diff_ana = en_ana(ps[1]) - en_ana(ps[0]);
+    if (myrank == 0 && verbose) {
+        cout << "E(" << ps[1] << ") - E(" << ps[0] << ") = " << diff << " +- " << ddiff << " (ana: " << diff_ana << ")" << endl;
+    }
+    assert(fabs(diff - diff_ana) < 4.*ddiff);
+    assert(ddiff < sqrt(dEs[0]*dEs[0] + dEs[1]*dEs[1])); // correlation must reduce the error
+
+    // far away from the reference the ESS drops and new configurations are sampled
+    const double p_far = 5.; // narrower than the reference, so the weights have finite variance and
+    assert(essratio_ana(p_far) < 0.35); // the ESS ratio is reliably below the threshold
+    cs.computeEnergy(&p_far, E, dE);
+    assert(cs.getNSample() == 2);
+    assert(fabs(cs.getESS() - NCONF*MPIVMC::Size()) < 1e-6);
+    double vp_ref;
+    cs.getReferenceVP(&vp_ref);
+    assert(vp_ref == p_far);
+    assert(fabs(E[0] - en_ana(p_far)) < 4.*dE[0]);
+
+    MPIVMC::Finalize();
+
+    return 0;
+}